@@ -0,0 +1,81 @@
+/* disk_image.h
+Host-side FatFs disk backend on a memory-mapped image file.
+
+Replaces src/glue.c when the FatFs and logging code is built for Linux, so it
+can run without an SD card. Each physical drive is backed by an image file
+mapped with mmap(). A profile can inject the latency and failures of a real
+card. Example build:
+
+    gcc -Iff15/source -Iinclude app.c ff15/source/ff.c \
+        ff15/source/ffunicode.c src/glue_image.c
+
+The application must also provide get_fattime() (src/rtc.c uses the Pico RTC).
+tests/CMakeLists.txt builds it this way for the host tests.
+*/
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+//
+#include "ff.h"
+#include "diskio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DISK_IMAGE_MAX_DRIVES
+#define DISK_IMAGE_MAX_DRIVES FF_VOLUMES
+#endif
+#define DISK_IMAGE_SECTOR_SIZE 512
+
+// Fault and latency profile. All fields zero = ideal, instant disk.
+// Probabilities are in parts per million per command.
+typedef struct {
+    uint32_t read_us;          // Command overhead for a read
+    uint32_t read_us_per_sector;
+    uint32_t write_us;         // Command overhead for a write
+    uint32_t write_us_per_sector;
+    // Busy periods: every busy_every_writes-th write holds the card busy for
+    // busy_us, as when the controller erases or garbage-collects a block.
+    uint32_t busy_every_writes;
+    uint32_t busy_us;
+    uint32_t write_fail_ppm;   // Write fails; a multi-sector write is torn
+                               // (only a random prefix of sectors lands)
+    uint32_t crc_error_ppm;    // Read returns RES_ERROR, as after retries
+                               // on a data CRC mismatch are exhausted
+    // Power cut: after this many writes every later write fails and nothing
+    // more reaches the image (0 = never). Remount to model the next boot.
+    uint32_t power_cut_after_writes;
+    uint32_t seed;             // PRNG seed for the *_ppm draws (0 = fixed)
+    bool sleep;                // Really sleep for the latencies; otherwise
+                               // they are only added up in the statistics
+} disk_image_profile_t;
+
+typedef struct {
+    uint64_t reads, writes;            // Commands
+    uint64_t sectors_read, sectors_written;
+    uint64_t busy_events;
+    uint64_t write_failures, crc_errors, torn_writes;
+    uint64_t syncs;
+    uint64_t simulated_us;             // Sum of the modelled latencies
+} disk_image_stats_t;
+
+// Maps (creating and sizing it if needed) the image for drive pdrv.
+// sectors == 0 keeps the size of an existing file. Returns false on error.
+bool disk_image_open(BYTE pdrv, const char *path, LBA_t sectors);
+// Unmaps the image after msync(); the drive then reports STA_NOINIT.
+void disk_image_close(BYTE pdrv);
+// Replaces the profile (NULL restores the ideal disk) and reseeds the PRNG.
+void disk_image_set_profile(BYTE pdrv, const disk_image_profile_t *profile);
+// Returns the counters; clears them if reset is true.
+disk_image_stats_t disk_image_stats(BYTE pdrv, bool reset);
+// Writes sectors inside an open multi-block write (CMD25 already sent): like
+// disk_write(), but without the write_us command overhead. Hosts modelling
+// sd_stream_write() charge the overhead once with disk_write() and stream the
+// rest through this.
+DRESULT disk_image_write_stream(BYTE pdrv, const BYTE *buff, LBA_t sector,
+                                UINT count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,7 +24,6 @@ specific language governing permissions and limitations under the License.
 #define BaseType_t int
 #define FF_FILE FIL
 
-#define ff_rewind f_rewind
 #define pvPortMalloc malloc
 #define vPortFree free
 #define ffconfigMAX_FILENAME 250
@@ -37,8 +36,16 @@ specific language governing permissions and limitations under the License.
 #define FF_SEEK_END 2
 #define pdFALSE 0
 #define pdTRUE 1
-#define ff_filelength f_size
-#define ff_feof f_eof
+
+// Write-back cache: files opened for writing borrow a sector-sized buffer
+// from a static pool, so ff_fputc() and short ff_fwrite() calls are gathered
+// into whole-sector f_write() calls. Pending data is written on ff_fflush(),
+// ff_fsync(), ff_fclose() and before any read, seek or size query on the
+// same stream. Once the pool is exhausted further files are unbuffered.
+#ifndef FF_STDIO_WBUF_COUNT
+#define FF_STDIO_WBUF_COUNT 2  // Streams that can be buffered at once (0 disables)
+#endif
+#define FF_STDIO_WBUF_SIZE FF_MAX_SS
 
 typedef struct FF_STAT {
     uint32_t st_size; /* Size of the object in number of bytes. */
@@ -75,3 +82,9 @@ FF_FILE *ff_truncate( const char * pcFileName, long lTruncateSize );
 int ff_seteof( FF_FILE *pxStream );
 int ff_rename( const char *pcOldName, const char *pcNewName, int bDeleteIfExists );
 char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream);
+int ff_fflush(FF_FILE *pxStream);
+int ff_fsync(FF_FILE *pxStream);
+int ff_setbuf(FF_FILE *pxStream, int bEnable);
+int ff_rewind(FF_FILE *pxStream);
+long ff_filelength(FF_FILE *pxStream);
+int ff_feof(FF_FILE *pxStream);
@@ -184,6 +184,17 @@ specific language governing permissions and limitations under the License.
 static bool crc_on = true;
 #endif
 
+// Compute data block CRC16 with the DMA sniffer while the block is on the bus
+//  (0: use the table-driven software crc16() after the transfer).
+//  The sniffer is checked against crc16() at driver init (sd_crc_sniff_self_test)
+//  and left unused if they disagree.
+#ifndef SD_CRC_DMA_SNIFF
+#define SD_CRC_DMA_SNIFF 1
+#endif
+#if SD_CRC_ENABLED && SD_CRC_DMA_SNIFF
+static bool crc_sniff_ok;
+#endif
+
 #define TRACE_PRINTF(fmt, args...)
 // #define TRACE_PRINTF printf
 
@@ -628,6 +639,7 @@ bool sd_card_detect(sd_card_t *pSD) {
         // The socket is now empty
         pSD->m_Status |= (STA_NODISK | STA_NOINIT);
         pSD->card_type = SDCARD_NONE;
+        pSD->baud_rate = 0;  // The next card negotiates its own clock
         printf("No SD card detected!\r\n");
         return false;
     }
@@ -819,7 +831,12 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     }
     // read data
     // bool spi_transfer(const uint8_t *tx, uint8_t *rx, size_t length)
-    if (!sd_spi_transfer(pSD, NULL, buffer, length)) {
+    uint16_t crc_result = 0;
+    uint16_t *sniff = NULL;
+#if SD_CRC_ENABLED && SD_CRC_DMA_SNIFF
+    if (crc_on && crc_sniff_ok) sniff = &crc_result;
+#endif
+    if (!sd_spi_transfer_crc16(pSD, NULL, buffer, length, sniff)) {
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
     // Read the CRC16 checksum for the data block
@@ -828,9 +845,8 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
 
 #if SD_CRC_ENABLED
     if (crc_on) {
-        uint32_t crc_result;
         // Compute and verify checksum
-        crc_result = crc16((void *)buffer, length);
+        if (!sniff) crc_result = crc16((void *)buffer, length);
         if ((uint16_t)crc_result != crc) {
             DBG_PRINTF("%s: Invalid CRC received 0x%" PRIx16
                        " result of computation 0x%" PRIx16 "\r\n",
@@ -843,6 +859,9 @@ static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     return SD_BLOCK_DEVICE_ERROR_NONE;
 }
 
+static int in_sd_stream_close(sd_card_t *pSD);
+static bool sd_clock_step_down(sd_card_t *pSD);
+
 static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
                              uint64_t ulSectorNumber, uint32_t ulSectorCount) {
     uint32_t blockCnt = ulSectorCount;
@@ -874,8 +893,8 @@ static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
     // receive the data : one block at a time
     int rd_status = 0;
     while (blockCnt) {
-        if (0 != sd_read_block(pSD, buffer, _block_size)) {
-            rd_status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+        // Keep the cause (CRC vs. timeout) so the caller can fall back on CRC errors
+        if (0 != (rd_status = sd_read_block(pSD, buffer, _block_size))) {
             break;
         }
         buffer += _block_size;
@@ -893,7 +912,11 @@ int sd_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
     sd_acquire(pSD);
     TRACE_PRINTF("sd_read_blocks(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
                  ulSectorNumber, ulSectorCount);
+    // Any other transfer ends an open streaming write session first
+    if (pSD->stream_open) in_sd_stream_close(pSD);
     int status = in_sd_read_blocks(pSD, buffer, ulSectorNumber, ulSectorCount);
+    if (SD_BLOCK_DEVICE_ERROR_CRC == status && sd_clock_step_down(pSD))
+        status = in_sd_read_blocks(pSD, buffer, ulSectorNumber, ulSectorCount);
     sd_release(pSD);
     return status;
 }
@@ -907,11 +930,15 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
     sd_spi_write(pSD, token);
 
     // write the data
-    bool ret = sd_spi_transfer(pSD, buffer, NULL, length);
+    uint16_t *sniff = NULL;
+#if SD_CRC_ENABLED && SD_CRC_DMA_SNIFF
+    if (crc_on && crc_sniff_ok) sniff = &crc;
+#endif
+    bool ret = sd_spi_transfer_crc16(pSD, buffer, NULL, length, sniff);
     myASSERT(ret);
 
 #if SD_CRC_ENABLED
-    if (crc_on) {
+    if (crc_on && !sniff) {
         // Compute CRC
         crc = crc16((void *)buffer, length);
     }
@@ -957,6 +984,9 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     uint8_t response;
     uint64_t addr;
 
+    pSD->write_calls++;
+    pSD->sectors_written += blockCnt;
+
     // SDSC Card (CCS=0) uses byte unit address
     // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
     if (SDCARD_V2HC == pSD->card_type) {
@@ -1010,7 +1040,10 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     uint32_t stat = 0;
     // Some SD cards want to be deselected between every bus transaction:
     sd_spi_deselect_pulse(pSD);
-    status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    // A rejected data token (CRC or write error) is not reflected in the R2
+    // bits, so keep it rather than letting CMD13 report success
+    int stat_status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = stat_status;
     return status;
 }
 
@@ -1019,7 +1052,115 @@ int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     sd_acquire(pSD);
     TRACE_PRINTF("sd_write_blocks(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
                  ulSectorNumber, blockCnt);
+    if (pSD->stream_open) in_sd_stream_close(pSD);
     int status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    // A rejected data block (e.g. CRC error token) is retried once at a lower clock
+    if (SD_BLOCK_DEVICE_ERROR_WRITE == status && sd_clock_step_down(pSD))
+        status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    sd_release(pSD);
+    return status;
+}
+
+/* Streaming write sessions
+ *
+ * A session keeps the card in CMD25 (WRITE_MULTIPLE_BLOCK) receive state
+ * between pushes, so a logger appending a few sectors at a time pays the
+ * ACMD23/CMD25/STOP_TRAN/CMD13 overhead once per session instead of once per
+ * call. The bus is released between pushes; any other read or write on the
+ * card closes the session first.
+ */
+
+static int in_sd_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber,
+                             uint32_t blockCnt) {
+    if (ulSectorNumber + blockCnt > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+
+    uint64_t addr = ulSectorNumber;
+    if (SDCARD_V2HC != pSD->card_type) addr *= _block_size;
+
+    // Pre-erase hint for the whole reserved range
+    if (blockCnt) {
+        sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
+        sd_spi_deselect_pulse(pSD);
+    }
+    int status = sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK, addr, false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) return status;
+
+    pSD->write_calls++;
+    pSD->stream_open = true;
+    pSD->stream_next = ulSectorNumber;
+    pSD->stream_end = blockCnt ? ulSectorNumber + blockCnt : pSD->sectors;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int in_sd_stream_close(sd_card_t *pSD) {
+    if (!pSD->stream_open) return SD_BLOCK_DEVICE_ERROR_NONE;
+    pSD->stream_open = false;
+    sd_spi_write(pSD, SPI_STOP_TRAN);
+    if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
+        DBG_PRINTF("%s:%d: Card not ready yet\r\n", __FILE__, __LINE__);
+    }
+    uint32_t stat = 0;
+    sd_spi_deselect_pulse(pSD);
+    return sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+}
+
+/** Open a streaming write session
+ *
+ *  @param ulSectorNumber   First LBA of the session
+ *  @param blockCnt         Blocks expected in the session (pre-erase hint and
+ *                          upper bound); 0 for open-ended
+ *  @return SD_BLOCK_DEVICE_ERROR_NONE(0) on success
+ */
+int sd_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber, uint32_t blockCnt) {
+    sd_acquire(pSD);
+    if (pSD->stream_open) in_sd_stream_close(pSD);
+    int status = in_sd_stream_open(pSD, ulSectorNumber, blockCnt);
+    sd_release(pSD);
+    return status;
+}
+
+/** Push blocks into the open session
+ *
+ *  @param buffer       Data to write (blockCnt * 512 bytes)
+ *  @param blockCnt     Blocks to write
+ *  @return SD_BLOCK_DEVICE_ERROR_NONE(0) on success; on error the session is
+ *          closed
+ */
+int sd_stream_write(sd_card_t *pSD, const uint8_t *buffer, uint32_t blockCnt) {
+    if (!pSD->stream_open) return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    if (pSD->stream_next + blockCnt > pSD->stream_end)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    sd_acquire(pSD);
+    while (blockCnt--) {
+        uint8_t response = sd_write_block(pSD, buffer, SPI_START_BLK_MUL_WRITE, _block_size);
+        if (response != SPI_DATA_ACCEPTED) {
+            DBG_PRINTF("Stream Block Write failed: 0x%x\r\n", response);
+            status = SD_BLOCK_DEVICE_ERROR_WRITE;
+            in_sd_stream_close(pSD);
+            sd_clock_step_down(pSD);
+            break;
+        }
+        buffer += _block_size;
+        pSD->stream_next++;
+        pSD->sectors_written++;
+    }
+    sd_release(pSD);
+    return status;
+}
+
+/** Close the streaming write session (STOP_TRAN + CMD13)
+ *
+ *  @return SD_BLOCK_DEVICE_ERROR_NONE(0) on success
+ */
+int sd_stream_close(sd_card_t *pSD) {
+    if (!pSD->stream_open) return SD_BLOCK_DEVICE_ERROR_NONE;
+    sd_acquire(pSD);
+    int status = in_sd_stream_close(pSD);
     sd_release(pSD);
     return status;
 }
@@ -1131,6 +1272,36 @@ static int sd_init_medium(sd_card_t *pSD) {
 static int sd_init(sd_card_t *pSD);
 static bool sd_test_com(sd_card_t *pSD);
 
+#if SD_CRC_ENABLED && SD_CRC_DMA_SNIFF
+// Compare the DMA sniffer CRC16 with the table-driven crc16() on known blocks,
+//  in both directions (TX sniffs the pattern, RX sniffs whatever the idle MISO
+//  line returns). Runs with every chip select deasserted, so no card sees the
+//  traffic.
+static bool sd_crc_sniff_self_test(spi_t *pSPI) {
+    static uint8_t block[64];
+    static uint8_t rx[64];
+    bool ok = true;
+    spi_lock(pSPI);
+    for (int pass = 0; pass < 2 && ok; ++pass) {
+        uint32_t x = 0x1D0F;
+        for (size_t i = 0; i < sizeof block; ++i) {
+            x = x * 1103515245 + 12345;  // LCG: non-trivial, reproducible data
+            block[i] = pass ? (uint8_t)(x >> 16) : (uint8_t)i;
+        }
+        uint16_t sniffed = 0;
+        ok = spi_transfer_crc16(pSPI, block, NULL, sizeof block, &sniffed) &&
+             sniffed == crc16((void *)block, sizeof block);
+    }
+    if (ok) {
+        uint16_t sniffed = 0;
+        ok = spi_transfer_crc16(pSPI, NULL, rx, sizeof rx, &sniffed) &&
+             sniffed == crc16((void *)rx, sizeof rx);
+    }
+    spi_unlock(pSPI);
+    return ok;
+}
+#endif
+
 static void sd_ctor(sd_card_t *pSD) {
     // State variables:
     pSD->m_Status = STA_NOINIT;
@@ -1171,11 +1342,147 @@ bool sd_init_driver() {
                 return false;
             }
         }
+#if SD_CRC_ENABLED && SD_CRC_DMA_SNIFF
+        crc_sniff_ok = true;
+        for (size_t i = 0; i < spi_get_num() && crc_sniff_ok; ++i)
+            crc_sniff_ok = sd_crc_sniff_self_test(spi_get_by_num(i));
+        if (!crc_sniff_ok)
+            printf("SD CRC: DMA sniffer disagrees with crc16(), using the table\n");
+#endif
         initialized = true;
     }
     mutex_exit(&sd_init_driver_mutex);
     return true;
 }
+/* SPI clock negotiation
+ *
+ * After init the card runs at SD_SAFE_BAUD_RATE. The clock is then raised
+ * through sd_clock_steps (up to spi->baud_rate), validating each step with
+ * CRC-checked reads and a write of a scratch sector, rewritten with its own
+ * content. The scratch sector is the last one of the gap between the MBR and
+ * the first partition, which no file system uses, so a power cut during the
+ * test cannot corrupt user data. Without such a gap (superfloppy layout, GPT,
+ * partition right after the MBR) the steps are validated with reads of
+ * sector 0 only. The fastest step that passed is kept in pSD->baud_rate and
+ * reused on re-init until the card is removed; CRC errors at runtime step the
+ * clock back down. A scratch write that failed to verify is redone at the
+ * last good rate before negotiation ends. If the reference read itself fails,
+ * nothing is written and the configured spi->baud_rate is used as before.
+ */
+
+#ifndef SD_SAFE_BAUD_RATE
+#define SD_SAFE_BAUD_RATE (1000 * 1000)
+#endif
+#define SD_CLOCK_TEST_READS 4
+
+static const uint sd_clock_steps[] = {12500 * 1000, 20833 * 1000, 25000 * 1000};
+
+static uint8_t sd_scratch_ref[BLOCK_SIZE_HC];
+static uint8_t sd_scratch_buf[BLOCK_SIZE_HC];
+
+// Writes the reference content back to the scratch sector and reads it back
+static bool sd_scratch_rewrite(sd_card_t *pSD, uint64_t scratch) {
+    return in_sd_write_blocks(pSD, sd_scratch_ref, scratch, 1) == SD_BLOCK_DEVICE_ERROR_NONE &&
+           in_sd_read_blocks(pSD, sd_scratch_buf, scratch, 1) == SD_BLOCK_DEVICE_ERROR_NONE &&
+           memcmp(sd_scratch_buf, sd_scratch_ref, _block_size) == 0;
+}
+
+// Finds the scratch sector: the last sector before the first partition of an
+// MBR. False if the card has no such gap, and the clock test then only reads.
+static bool sd_scratch_sector(sd_card_t *pSD, uint64_t *scratch) {
+    const uint8_t *mbr = sd_scratch_buf;
+    if (in_sd_read_blocks(pSD, sd_scratch_buf, 0, 1) != SD_BLOCK_DEVICE_ERROR_NONE ||
+        mbr[510] != 0x55 || mbr[511] != 0xAA)
+        return false;
+    // A volume boot record in sector 0 (superfloppy) has no partition table
+    if ((mbr[0] == 0xEB || mbr[0] == 0xE9) &&
+        (!memcmp(mbr + 54, "FAT", 3) || !memcmp(mbr + 82, "FAT", 3) || !memcmp(mbr + 3, "EXFAT", 5)))
+        return false;
+    uint32_t first = UINT32_MAX;
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t *entry = mbr + 446 + 16 * i;
+        uint32_t lba = entry[8] | (uint32_t)entry[9] << 8 | (uint32_t)entry[10] << 16 |
+                       (uint32_t)entry[11] << 24;
+        if (entry[4] && lba && lba < first) first = lba;  // entry[4]: partition type
+    }
+    if (first == UINT32_MAX || first < 2 || first > pSD->sectors) return false;
+    *scratch = first - 1;
+    return true;
+}
+
+// Reads and (if writable) rewrites the scratch sector; true if every transfer passed CRC and
+// matched. *dirty is set when the sector was written but the write could not be verified.
+static bool sd_clock_test(sd_card_t *pSD, uint64_t scratch, bool writable, bool *dirty) {
+    for (int i = 0; i < SD_CLOCK_TEST_READS; ++i) {
+        if (in_sd_read_blocks(pSD, sd_scratch_buf, scratch, 1) != SD_BLOCK_DEVICE_ERROR_NONE ||
+            memcmp(sd_scratch_buf, sd_scratch_ref, _block_size) != 0)
+            return false;
+    }
+    if (!writable) return true;
+    *dirty = true;
+    if (!sd_scratch_rewrite(pSD, scratch))
+        return false;
+    *dirty = false;
+    return true;
+}
+
+static void sd_negotiate_clock(sd_card_t *pSD) {
+    uint best = spi_set_baudrate(pSD->spi->hw_inst, SD_SAFE_BAUD_RATE);
+    uint64_t scratch = 0;
+    bool writable = sd_scratch_sector(pSD, &scratch);
+    if (in_sd_read_blocks(pSD, sd_scratch_ref, scratch, 1) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        // Probe not possible: keep the configured rate and retry negotiation on the next init
+        pSD->baud_rate = 0;
+        sd_spi_go_high_frequency(pSD);
+        printf("SD clock: reference read failed, using configured %u Hz\n", pSD->spi->baud_rate);
+        return;
+    }
+    bool dirty = false;
+    uint last = best;
+    for (size_t i = 0; i < count_of(sd_clock_steps) && sd_clock_steps[i] <= pSD->spi->baud_rate; ++i) {
+        uint actual = spi_set_baudrate(pSD->spi->hw_inst, sd_clock_steps[i]);
+        if (actual == last) continue;  // Same divider as the previous step
+        last = actual;
+        absolute_time_t t0 = get_absolute_time();
+        bool ok = sd_clock_test(pSD, scratch, writable, &dirty);
+        int64_t us = absolute_time_diff_us(t0, get_absolute_time());
+        uint32_t bytes = (SD_CLOCK_TEST_READS + (writable ? 2 : 0)) * _block_size;
+        printf("SD clock: %u Hz %s, %lu KB/s\n", actual, ok ? "ok" : "failed",
+               us > 0 ? (unsigned long)(bytes * 1000ull / us) : 0ul);
+        if (!ok) break;
+        best = actual;
+    }
+    spi_set_baudrate(pSD->spi->hw_inst, best);
+    if (dirty) {
+        // The failed step may have left a corrupt sector behind: restore it at a rate that works
+        if (sd_scratch_rewrite(pSD, scratch)) {
+            printf("SD clock: scratch sector restored at %u Hz\n", best);
+        } else {
+            best = spi_set_baudrate(pSD->spi->hw_inst, SD_SAFE_BAUD_RATE);
+            if (!sd_scratch_rewrite(pSD, scratch))
+                printf("SD clock: could not restore sector %llu\n", (unsigned long long)scratch);
+        }
+    }
+    pSD->baud_rate = best;
+    printf("SD clock: using %u Hz (%s sector %llu)\n", best, writable ? "scratch" : "read-only test on",
+           (unsigned long long)scratch);
+}
+
+// Drops to the next lower step after a CRC error; false if already at the safe rate
+static bool sd_clock_step_down(sd_card_t *pSD) {
+    uint current = pSD->baud_rate ? pSD->baud_rate : pSD->spi->baud_rate;
+    uint next = SD_SAFE_BAUD_RATE;
+    for (size_t i = 0; i < count_of(sd_clock_steps); ++i) {
+        if (sd_clock_steps[i] < current && sd_clock_steps[i] > next) next = sd_clock_steps[i];
+    }
+    if (current <= SD_SAFE_BAUD_RATE) return false;
+    pSD->baud_rate = spi_set_baudrate(pSD->spi->hw_inst, next);
+    if (pSD->baud_rate >= current) pSD->baud_rate = spi_set_baudrate(pSD->spi->hw_inst, SD_SAFE_BAUD_RATE);
+    pSD->clock_fallbacks++;
+    printf("SD clock: CRC error at %u Hz, falling back to %u Hz\n", current, pSD->baud_rate);
+    return true;
+}
+
 static int sd_init(sd_card_t *pSD) {
     TRACE_PRINTF("> %s\r\n", __FUNCTION__);
 
@@ -1199,6 +1506,7 @@ static int sd_init(sd_card_t *pSD) {
     }
     // Initialize the member variables
     pSD->card_type = SDCARD_NONE;
+    pSD->stream_open = false;
 
     sd_spi_acquire(pSD);
 
@@ -1224,12 +1532,15 @@ static int sd_init(sd_card_t *pSD) {
         sd_unlock(pSD);
         return pSD->m_Status;
     }
-    // Set SCK for data transfer
-    sd_spi_go_high_frequency(pSD);
-
-    // The card is now initialized
+    // The card is now initialized (the clock negotiation below goes through the block read/write paths)
     pSD->m_Status &= ~STA_NOINIT;
 
+    // Set SCK for data transfer: negotiate once per card, then reuse the result
+    if (pSD->baud_rate)
+        sd_spi_go_high_frequency(pSD);
+    else
+        sd_negotiate_clock(pSD);
+
     sd_spi_release(pSD);
     sd_unlock(pSD);
 
@@ -1265,6 +1576,7 @@ static bool sd_test_com(sd_card_t *pSD) {
             if (!success) {
                 // Card no longer sensed - ensure card is initialized once re-attached
                 pSD->m_Status |= STA_NOINIT;
+                pSD->baud_rate = 0;  // It may be a different card: negotiate again
             }
         } else {
             // SD card is currently holding DO which is sufficient enough to know it's still there
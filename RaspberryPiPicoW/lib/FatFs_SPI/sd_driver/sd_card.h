@@ -54,6 +54,13 @@ struct sd_card_t {
     mutex_t mutex;
     FATFS fatfs;
     bool mounted;
+    uint32_t write_calls;       // Write commands issued (CMD24/CMD25)
+    uint32_t sectors_written;   // Sectors written to the card
+    uint baud_rate;             // Negotiated SCK rate (0: not negotiated yet)
+    uint32_t clock_fallbacks;   // Clock step-downs after CRC errors
+    bool stream_open;           // Card is inside a streaming CMD25 session
+    uint64_t stream_next;       // Next LBA of the streaming session
+    uint64_t stream_end;        // End (exclusive) of the streaming session
 
     int (*init)(sd_card_t *sd_card_p);
     int (*write_blocks)(sd_card_t *sd_card_p, const uint8_t *buffer,
@@ -91,6 +98,11 @@ bool sd_card_detect(sd_card_t *pSD);
 uint64_t sd_sectors(sd_card_t *pSD);
 
 bool sd_init_driver();
+
+// Streaming write session: keeps the card in CMD25 between pushes
+int sd_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber, uint32_t blockCnt);
+int sd_stream_write(sd_card_t *pSD, const uint8_t *buffer, uint32_t blockCnt);
+int sd_stream_close(sd_card_t *pSD);
 bool sd_card_detect(sd_card_t *sd_card_p);
 
 #ifdef __cplusplus
@@ -59,10 +59,16 @@ void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
 //   If the data that will be transmitted is not important,
 //     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
 //     element.
-bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+//   If crc is not NULL, the DMA sniffer computes the CRC16 (CCITT, seed 0, as
+//     used by SD data blocks) of the data bytes while they are transferred:
+//     on the TX channel when tx is given, otherwise on the RX channel.
+bool spi_transfer_crc16(spi_t *spi_p, const uint8_t *tx, uint8_t *rx,
+                        size_t length, uint16_t *crc) {
     // assert(512 == length || 1 == length);
     assert(tx || rx);
     // assert(!(tx && rx));
+    // The data worth checksumming is on the TX side for writes, RX for reads
+    uint sniff_dma = tx ? spi_p->tx_dma : spi_p->rx_dma;
 
     // tx write increment is already false
     if (tx) {
@@ -82,6 +88,15 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
         channel_config_set_write_increment(&spi_p->rx_dma_cfg, false);
     }
 
+    channel_config_set_sniff_enable(&spi_p->tx_dma_cfg,
+                                    crc && sniff_dma == spi_p->tx_dma);
+    channel_config_set_sniff_enable(&spi_p->rx_dma_cfg,
+                                    crc && sniff_dma == spi_p->rx_dma);
+    if (crc) {
+        dma_sniffer_enable(sniff_dma, DMA_SNIFF_CTRL_CALC_VALUE_CRC16, true);
+        dma_hw->sniff_data = 0;  // Seed
+    }
+
     dma_channel_configure(spi_p->tx_dma, &spi_p->tx_dma_cfg,
                           &spi_get_hw(spi_p->hw_inst)->dr,  // write address
                           tx,                              // read address
@@ -118,12 +133,18 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     if (!rc) {
         // If the timeout is reached the function will return false
         DBG_PRINTF("Notification wait timed out in %s\n", __FUNCTION__);
+        if (crc) dma_sniffer_disable();
         return false;
     }
     // Shouldn't be necessary:
     dma_channel_wait_for_finish_blocking(spi_p->tx_dma);
     dma_channel_wait_for_finish_blocking(spi_p->rx_dma);
 
+    if (crc) {
+        *crc = (uint16_t)dma_hw->sniff_data;
+        dma_sniffer_disable();
+    }
+
     assert(!sem_available(&spi_p->sem));
     assert(!dma_channel_is_busy(spi_p->tx_dma));
     assert(!dma_channel_is_busy(spi_p->rx_dma));
@@ -131,6 +152,10 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     return true;
 }
 
+bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+    return spi_transfer_crc16(spi_p, tx, rx, length, NULL);
+}
+
 void spi_lock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
     mutex_enter_blocking(&spi_p->mutex);
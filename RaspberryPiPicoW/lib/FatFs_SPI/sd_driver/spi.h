@@ -60,6 +60,7 @@ extern "C" {
 #endif
   
 bool __not_in_flash_func(spi_transfer)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);  
+bool __not_in_flash_func(spi_transfer_crc16)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length, uint16_t *crc);
 void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
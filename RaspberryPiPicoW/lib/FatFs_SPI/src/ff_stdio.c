@@ -27,6 +27,59 @@ specific language governing permissions and limitations under the License.
 #define TRACE_PRINTF(fmt, args...) {}
 //#define TRACE_PRINTF printf
 
+// Write-back cache pool. A slot is owned by at most one open stream; the
+// pending bytes belong at the stream's current f_tell() position.
+typedef struct {
+    FF_FILE *pxStream;  // Owner, or NULL if the slot is free
+    UINT len;           // Bytes waiting to be written
+    BYTE buf[FF_STDIO_WBUF_SIZE];
+} wbuf_t;
+#if FF_STDIO_WBUF_COUNT
+static wbuf_t wbufs[FF_STDIO_WBUF_COUNT];
+#endif
+
+static wbuf_t *wbuf_find(FF_FILE *pxStream) {
+#if FF_STDIO_WBUF_COUNT
+    for (size_t i = 0; i < FF_STDIO_WBUF_COUNT; ++i)
+        if (wbufs[i].pxStream == pxStream) return &wbufs[i];
+#endif
+    return NULL;
+}
+static wbuf_t *wbuf_alloc(FF_FILE *pxStream) {
+    wbuf_t *wb = wbuf_find(pxStream);
+    if (wb) return wb;
+    wb = wbuf_find(NULL);
+    if (wb) {
+        wb->pxStream = pxStream;
+        wb->len = 0;
+    }
+    return wb;
+}
+// Bytes that may be gathered before the buffer ends on a sector boundary of
+// the file, so that every flush is a whole, aligned sector when possible.
+static UINT wbuf_limit(FF_FILE *pxStream) {
+    return FF_STDIO_WBUF_SIZE - (UINT)(f_tell(pxStream) % FF_STDIO_WBUF_SIZE);
+}
+// Writes the pending bytes. On failure the bytes that did not reach the file
+// are discarded and their number is returned in *pLost (if not NULL).
+static FRESULT wbuf_flush(FF_FILE *pxStream, wbuf_t *wb, UINT *pLost) {
+    if (pLost) *pLost = 0;
+    if (!wb || !wb->len) return FR_OK;
+    UINT bw = 0;
+    FRESULT fr = f_write(pxStream, wb->buf, wb->len, &bw);
+    if (FR_OK == fr && bw != wb->len) fr = FR_DENIED;  // Volume full
+    if (FR_OK != fr) {
+        TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
+        if (pLost) *pLost = wb->len - bw;
+    }
+    wb->len = 0;
+    return fr;
+}
+// Flushes the stream's cache, if it has one, ahead of another operation.
+static FRESULT ff_flush_pending(FF_FILE *pxStream) {
+    return wbuf_flush(pxStream, wbuf_find(pxStream), NULL);
+}
+
 static BYTE posix2mode(const char *pcMode) {
     if (0 == strcmp("r", pcMode)) return FA_READ;
     if (0 == strcmp("r+", pcMode)) return FA_READ | FA_WRITE;
@@ -99,12 +152,15 @@ FF_FILE *ff_fopen(const char *pcFile, const char *pcMode) {
         errno = ENOMEM;
         return NULL;
     }
-    FRESULT fr = f_open(fp, pcFile, posix2mode(pcMode));
+    BYTE mode = posix2mode(pcMode);
+    FRESULT fr = f_open(fp, pcFile, mode);
     errno = fresult2errno(fr);
     if (FR_OK != fr) {
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
         free(fp);
         fp = 0;
+    } else if (mode & FA_WRITE) {
+        wbuf_alloc(fp);  // Unbuffered if the pool is exhausted
     }
     return fp;
 }
@@ -113,7 +169,11 @@ int ff_fclose(FF_FILE *pxStream) {
     // FRESULT f_close (
     //  FIL* fp     /* [IN] Pointer to the file object */
     //);
-    FRESULT fr = f_close(pxStream);
+    wbuf_t *wb = wbuf_find(pxStream);
+    FRESULT fr = wbuf_flush(pxStream, wb, NULL);
+    if (wb) wb->pxStream = NULL;
+    FRESULT fr2 = f_close(pxStream);
+    if (FR_OK == fr) fr = fr2;
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
@@ -152,12 +212,54 @@ size_t ff_fwrite(const void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
-    UINT bw = 0;
-    FRESULT fr = f_write(pxStream, pvBuffer, xSize * xItems, &bw);
+    if (!xSize) return 0;
+    wbuf_t *wb = wbuf_find(pxStream);
+    if (!wb) {
+        UINT bw = 0;
+        FRESULT fr = f_write(pxStream, pvBuffer, xSize * xItems, &bw);
+        if (FR_OK != fr)
+            TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
+        errno = fresult2errno(fr);
+        return bw / xSize;
+    }
+    const BYTE *src = pvBuffer;
+    size_t total = xSize * xItems;
+    size_t done = 0;
+    FRESULT fr = FR_OK;
+    while (done < total) {
+        UINT limit = wbuf_limit(pxStream);
+        size_t left = total - done;
+        if (0 == wb->len && left >= limit) {
+            // Nothing pending and enough data to reach a sector boundary:
+            // write up to the last whole sector straight from the caller.
+            UINT btw = limit + (UINT)((left - limit) / FF_STDIO_WBUF_SIZE) *
+                                   FF_STDIO_WBUF_SIZE;
+            UINT bw = 0;
+            fr = f_write(pxStream, src + done, btw, &bw);
+            done += bw;
+            if (FR_OK == fr && bw != btw) fr = FR_DENIED;  // Volume full
+            if (FR_OK != fr) break;
+            continue;
+        }
+        UINT n = limit - wb->len;
+        if (n > left) n = left;
+        memcpy(wb->buf + wb->len, src + done, n);
+        wb->len += n;
+        done += n;
+        if (wb->len == limit) {
+            UINT lost = 0;
+            fr = wbuf_flush(pxStream, wb, &lost);
+            if (FR_OK != fr) {
+                // Bytes cached by earlier calls may be among the lost ones
+                done = done > lost ? done - lost : 0;
+                break;
+            }
+        }
+    }
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
-    return bw / xSize;
+    return done / xSize;
 }
 size_t ff_fread(void *pvBuffer, size_t xSize, size_t xItems,
                 FF_FILE *pxStream) {
@@ -169,7 +271,8 @@ size_t ff_fread(void *pvBuffer, size_t xSize, size_t xItems,
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
     UINT br = 0;
-    FRESULT fr = f_read(pxStream, pvBuffer, xSize * xItems, &br);
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK == fr) fr = f_read(pxStream, pvBuffer, xSize * xItems, &br);
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
@@ -237,6 +340,14 @@ int ff_fputc(int iChar, FF_FILE *pxStream) {
     //  UINT* bw          /* [OUT] Pointer to the variable to return number of
     //  bytes written */
     //);
+    wbuf_t *wb = wbuf_find(pxStream);
+    if (wb) {
+        wb->buf[wb->len++] = (BYTE)iChar;
+        if (wb->len < wbuf_limit(pxStream)) return iChar;
+        FRESULT fr = wbuf_flush(pxStream, wb, NULL);
+        errno = fresult2errno(fr);
+        return FR_OK == fr ? iChar : -1;
+    }
     UINT bw = 0;
     uint8_t buff[1];
     buff[0] = iChar;
@@ -262,8 +373,9 @@ int ff_fgetc(FF_FILE *pxStream) {
     //  UINT* br     /* [OUT] Number of bytes read */
     //);
     uint8_t buff[1] = {0};
-    UINT br;
-    FRESULT fr = f_read(pxStream, buff, 1, &br);
+    UINT br = 0;
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK == fr) fr = f_read(pxStream, buff, 1, &br);
     if (FR_OK != fr)
         TRACE_PRINTF("%s error: %s (%d)\n", __func__, FRESULT_str(fr), fr);
     errno = fresult2errno(fr);
@@ -305,12 +417,19 @@ long ff_ftell(FF_FILE *pxStream) {
     //  FIL* fp   /* [IN] File object */
     //);
     FSIZE_t pos = f_tell(pxStream);
+    wbuf_t *wb = wbuf_find(pxStream);
+    if (wb) pos += wb->len;
     myASSERT(pos < LONG_MAX);
     return pos;
 }
 int ff_fseek(FF_FILE *pxStream, int iOffset, int iWhence) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = -1;
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK != fr) {
+        errno = fresult2errno(fr);
+        return -1;
+    }
+    fr = -1;
     switch (iWhence) {
         case FF_SEEK_CUR:  // The current file position.
             if ((int)f_tell(pxStream) + iOffset < 0) return -1;
@@ -425,7 +544,8 @@ FF_FILE *ff_truncate(const char *pcFileName, long lTruncateSize) {
 }
 int ff_seteof(FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
-    FRESULT fr = f_truncate(pxStream);
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK == fr) fr = f_truncate(pxStream);
     errno = fresult2errno(fr);
     if (FR_OK == fr)
         return 0;
@@ -451,6 +571,11 @@ int ff_rename(const char *pcOldName, const char *pcNewName,
 }
 char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream) {
     TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK != fr) {
+        errno = fresult2errno(fr);
+        return NULL;
+    }
     TCHAR *p = f_gets(pcBuffer, xCount, pxStream);
     // On success a pointer to pcBuffer is returned. If there is a read error
     // then NULL is returned and the task's errno is set to indicate the reason.
@@ -461,3 +586,66 @@ char *ff_fgets(char *pcBuffer, size_t xCount, FF_FILE *pxStream) {
         return NULL;
     }
 }
+// Writes any cached bytes to the file (FatFs may still hold them in its own
+// sector buffer until ff_fsync() or ff_fclose()).
+int ff_fflush(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = ff_flush_pending(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return FF_EOF;
+}
+// Writes any cached bytes and commits them, with the directory entry, to the
+// medium.
+int ff_fsync(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK == fr) fr = f_sync(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return -1;
+}
+// Attaches (bEnable) or detaches a write-back buffer. Detaching flushes first.
+// Returns -1 with errno ENOMEM if no buffer is free.
+int ff_setbuf(FF_FILE *pxStream, int bEnable) {
+    TRACE_PRINTF("%s\n", __func__);
+    if (bEnable) {
+        if (wbuf_alloc(pxStream)) return 0;
+        errno = ENOMEM;
+        return -1;
+    }
+    wbuf_t *wb = wbuf_find(pxStream);
+    FRESULT fr = wbuf_flush(pxStream, wb, NULL);
+    if (wb) wb->pxStream = NULL;
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return -1;
+}
+int ff_rewind(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = ff_flush_pending(pxStream);
+    if (FR_OK == fr) fr = f_rewind(pxStream);
+    errno = fresult2errno(fr);
+    if (FR_OK == fr)
+        return 0;
+    else
+        return -1;
+}
+long ff_filelength(FF_FILE *pxStream) {
+    TRACE_PRINTF("%s\n", __func__);
+    FRESULT fr = ff_flush_pending(pxStream);
+    errno = fresult2errno(fr);
+    FSIZE_t size = f_size(pxStream);
+    myASSERT(size < LONG_MAX);
+    return size;
+}
+int ff_feof(FF_FILE *pxStream) {
+    ff_flush_pending(pxStream);
+    return f_eof(pxStream);
+}
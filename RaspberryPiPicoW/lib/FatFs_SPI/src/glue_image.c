@@ -0,0 +1,279 @@
+/* glue_image.c
+Host-side FatFs disk backend on a memory-mapped image file.
+Build this instead of glue.c on Linux; see disk_image.h.
+*/
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+//
+#include "ff.h" /* Obtains integer types */
+//
+#include "diskio.h" /* Declarations of disk functions */
+//
+#include "disk_image.h"
+
+#define TRACE_PRINTF(fmt, args...)
+//#define TRACE_PRINTF printf
+
+#if FF_MAX_SS != DISK_IMAGE_SECTOR_SIZE
+#error "disk_image supports 512-byte sectors only"
+#endif
+
+typedef struct {
+    int fd;
+    BYTE *map;
+    LBA_t sectors;
+    disk_image_profile_t profile;
+    disk_image_stats_t stats;
+    uint32_t writes;  // Writes since the profile was set
+    uint32_t rng;     // xorshift32 state
+} disk_image_t;
+
+static disk_image_t images[DISK_IMAGE_MAX_DRIVES] = {
+    [0 ... DISK_IMAGE_MAX_DRIVES - 1] = {.fd = -1}};
+
+static disk_image_t *image_get(BYTE pdrv) {
+    if (pdrv >= DISK_IMAGE_MAX_DRIVES) return NULL;
+    return &images[pdrv];
+}
+
+static uint32_t image_rand(disk_image_t *p) {
+    uint32_t x = p->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return p->rng = x;
+}
+// True with probability ppm / 1e6
+static bool image_draw(disk_image_t *p, uint32_t ppm) {
+    return ppm && image_rand(p) % 1000000 < ppm;
+}
+
+static void image_delay(disk_image_t *p, uint64_t us) {
+    if (!us) return;
+    p->stats.simulated_us += us;
+    if (p->profile.sleep) {
+        struct timespec ts = {.tv_sec = us / 1000000,
+                              .tv_nsec = (us % 1000000) * 1000};
+        while (nanosleep(&ts, &ts)) {
+        }
+    }
+}
+
+bool disk_image_open(BYTE pdrv, const char *path, LBA_t sectors) {
+    disk_image_t *p = image_get(pdrv);
+    if (!p) return false;
+    disk_image_close(pdrv);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(path);
+        close(fd);
+        return false;
+    }
+    off_t size = sectors ? (off_t)sectors * DISK_IMAGE_SECTOR_SIZE : st.st_size;
+    if (size < DISK_IMAGE_SECTOR_SIZE || size % DISK_IMAGE_SECTOR_SIZE) {
+        printf("%s: bad image size %lld\n", path, (long long)size);
+        close(fd);
+        return false;
+    }
+    if (size != st.st_size && ftruncate(fd, size) < 0) {
+        perror(path);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == map) {
+        perror(path);
+        close(fd);
+        return false;
+    }
+    p->fd = fd;
+    p->map = map;
+    p->sectors = size / DISK_IMAGE_SECTOR_SIZE;
+    memset(&p->stats, 0, sizeof p->stats);
+    disk_image_set_profile(pdrv, &p->profile);
+    return true;
+}
+
+void disk_image_close(BYTE pdrv) {
+    disk_image_t *p = image_get(pdrv);
+    if (!p || !p->map) return;
+    size_t size = (size_t)p->sectors * DISK_IMAGE_SECTOR_SIZE;
+    msync(p->map, size, MS_SYNC);
+    munmap(p->map, size);
+    close(p->fd);
+    p->fd = -1;
+    p->map = NULL;
+    p->sectors = 0;
+}
+
+// Also clears the write count, ending a simulated power cut.
+void disk_image_set_profile(BYTE pdrv, const disk_image_profile_t *profile) {
+    disk_image_t *p = image_get(pdrv);
+    if (!p) return;
+    if (profile != &p->profile) {
+        if (profile)
+            p->profile = *profile;
+        else
+            memset(&p->profile, 0, sizeof p->profile);
+    }
+    p->writes = 0;
+    p->rng = p->profile.seed ? p->profile.seed : 0x2545F491;
+}
+
+disk_image_stats_t disk_image_stats(BYTE pdrv, bool reset) {
+    disk_image_stats_t stats = {0};
+    disk_image_t *p = image_get(pdrv);
+    if (!p) return stats;
+    stats = p->stats;
+    if (reset) memset(&p->stats, 0, sizeof p->stats);
+    return stats;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Get Drive Status                                                      */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status(BYTE pdrv /* Physical drive nmuber to identify the drive */
+) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    disk_image_t *p = image_get(pdrv);
+    if (!p || !p->map) return STA_NOINIT | STA_NODISK;
+    return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Inidialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize(
+    BYTE pdrv /* Physical drive nmuber to identify the drive */
+) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    // The image is attached by disk_image_open(); nothing else to set up.
+    return disk_status(pdrv);
+}
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read(BYTE pdrv,  /* Physical drive nmuber to identify the drive */
+                  BYTE *buff, /* Data buffer to store read data */
+                  LBA_t sector, /* Start sector in LBA */
+                  UINT count    /* Number of sectors to read */
+) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    disk_image_t *p = image_get(pdrv);
+    if (!p || !p->map) return RES_NOTRDY;
+    if (!count || sector >= p->sectors || count > p->sectors - sector)
+        return RES_PARERR;
+    p->stats.reads++;
+    image_delay(p, p->profile.read_us +
+                       (uint64_t)p->profile.read_us_per_sector * count);
+    if (image_draw(p, p->profile.crc_error_ppm)) {
+        p->stats.crc_errors++;
+        return RES_ERROR;
+    }
+    memcpy(buff, p->map + (size_t)sector * DISK_IMAGE_SECTOR_SIZE,
+           (size_t)count * DISK_IMAGE_SECTOR_SIZE);
+    p->stats.sectors_read += count;
+    return RES_OK;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+#if FF_FS_READONLY == 0
+
+// command: charge the per-command write_us (false inside a multi-block session)
+static DRESULT image_write(BYTE pdrv, const BYTE *buff, LBA_t sector,
+                           UINT count, bool command) {
+    disk_image_t *p = image_get(pdrv);
+    if (!p || !p->map) return RES_NOTRDY;
+    if (!count || sector >= p->sectors || count > p->sectors - sector)
+        return RES_PARERR;
+    const disk_image_profile_t *prof = &p->profile;
+    p->stats.writes++;
+    if (prof->power_cut_after_writes &&
+        p->writes >= prof->power_cut_after_writes) {
+        p->stats.write_failures++;
+        return RES_NOTRDY;
+    }
+    p->writes++;
+    uint64_t us = (command ? prof->write_us : 0) +
+                  (uint64_t)prof->write_us_per_sector * count;
+    if (prof->busy_every_writes && 0 == p->writes % prof->busy_every_writes) {
+        p->stats.busy_events++;
+        us += prof->busy_us;
+    }
+    image_delay(p, us);
+    UINT done = count;
+    if (image_draw(p, prof->write_fail_ppm)) done = image_rand(p) % count;
+    memcpy(p->map + (size_t)sector * DISK_IMAGE_SECTOR_SIZE, buff,
+           (size_t)done * DISK_IMAGE_SECTOR_SIZE);
+    p->stats.sectors_written += done;
+    if (done != count) {
+        p->stats.write_failures++;
+        if (done) p->stats.torn_writes++;
+        return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, /* Physical drive nmuber to identify the drive */
+                   const BYTE *buff, /* Data to be written */
+                   LBA_t sector,     /* Start sector in LBA */
+                   UINT count        /* Number of sectors to write */
+) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    return image_write(pdrv, buff, sector, count, true);
+}
+
+DRESULT disk_image_write_stream(BYTE pdrv, const BYTE *buff, LBA_t sector,
+                                UINT count) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    return image_write(pdrv, buff, sector, count, false);
+}
+
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl(BYTE pdrv, /* Physical drive nmuber (0..) */
+                   BYTE cmd,  /* Control code */
+                   void *buff /* Buffer to send/receive control data */
+) {
+    TRACE_PRINTF(">>> %s\n", __FUNCTION__);
+    disk_image_t *p = image_get(pdrv);
+    if (!p || !p->map) return RES_NOTRDY;
+    switch (cmd) {
+        case GET_SECTOR_COUNT:
+            *(LBA_t *)buff = p->sectors;
+            return RES_OK;
+        case GET_BLOCK_SIZE:  // Unknown erase block size, as glue.c reports
+            *(DWORD *)buff = 1;
+            return RES_OK;
+        case CTRL_SYNC:
+            p->stats.syncs++;
+            if (msync(p->map, (size_t)p->sectors * DISK_IMAGE_SECTOR_SIZE,
+                      MS_SYNC) < 0)
+                return RES_ERROR;
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
@@ -31,11 +31,15 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
     uint8_t buffer[6];
 
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
+    if (metrics_i2c(METRICS_I2C_AHT20, i2c_write_timeout_us(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false, I2C_TIMEOUT_US)) < 0) {
+        return false;
+    }
     
-    uint8_t status;
+    uint8_t status = AHT20_STATUS_BUSY;
     for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
+        if (metrics_i2c(METRICS_I2C_AHT20, i2c_read_timeout_us(i2c, AHT20_I2C_ADDR, &status, 1, false, I2C_TIMEOUT_US)) < 0) {
+            return false;
+        }
         if (!(status & AHT20_STATUS_BUSY)) {
             break;
         }
@@ -48,7 +52,7 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     }
 
     // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
+    if (metrics_i2c(METRICS_I2C_AHT20, i2c_read_timeout_us(i2c, AHT20_I2C_ADDR, buffer, 6, false, I2C_TIMEOUT_US)) != 6) {
         return false;
     }
 
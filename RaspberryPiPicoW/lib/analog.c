@@ -0,0 +1,94 @@
+#include "analog.h"
+
+static volatile uint16_t ring[ANALOG_RING_LEN]; // Conversões, ANALOG_CHANNELS por rodada, gravadas pelo DMA
+static volatile uint16_t *volatile ring_start = ring; // Lido pelo canal de controle para rearmar o de dados
+static int data_channel = -1; // DMA: FIFO do ADC -> anel
+static int ctrl_channel; // DMA: volta o canal de dados ao início do anel e o dispara de novo
+
+/**
+ * @brief Inicia o ADC em rodízio contínuo, com o DMA gravando as conversões em um anel
+ *
+ * O canal de dados encadeia no de controle ao fim de cada volta, e o de
+ * controle reescreve o endereço de destino (com disparo) do de dados:
+ * a amostragem segue na taxa fixa do ADC sem nenhuma ação da CPU.
+ */
+void analog_init(void) {
+    if (data_channel >= 0)
+        return;
+    adc_init();
+    adc_gpio_init(ANALOG_JOYSTICK_Y_PIN);
+    adc_gpio_init(ANALOG_JOYSTICK_X_PIN);
+    adc_set_temp_sensor_enabled(true);
+    adc_select_input(0); // O rodízio parte da menor entrada, então a posição no anel define o canal
+    adc_set_round_robin(ANALOG_ADC_MASK);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)ANALOG_ADC_CLOCK_HZ / (ANALOG_RATE_HZ * ANALOG_CHANNELS) - 1);
+
+    data_channel = dma_claim_unused_channel(true);
+    ctrl_channel = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(data_channel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, ctrl_channel);
+    dma_channel_configure(data_channel, &cfg, ring, &adc_hw->fifo, ANALOG_RING_LEN, false);
+
+    cfg = dma_channel_get_default_config(ctrl_channel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    dma_channel_configure(ctrl_channel, &cfg, &dma_hw->ch[data_channel].al2_write_addr_trig, &ring_start, 1, false);
+
+    adc_fifo_drain();
+    dma_channel_start(data_channel);
+    adc_run(true);
+}
+
+/**
+ * @brief Posição no anel da última conversão de um canal
+ */
+static uint32_t analog_last_index(analog_channel_t channel) {
+    uint32_t written = (dma_hw->ch[data_channel].write_addr - (uintptr_t)ring) / sizeof(ring[0]);
+    if (written > ANALOG_RING_LEN)
+        written = ANALOG_RING_LEN; // Canal de controle rearmando: a volta acabou de terminar
+    uint32_t round = written / ANALOG_CHANNELS * ANALOG_CHANNELS; // Início da rodada em andamento
+    if (round + channel < written)
+        return round + channel;
+    return (round + ANALOG_RING_LEN - ANALOG_CHANNELS + channel) % ANALOG_RING_LEN;
+}
+
+/**
+ * @brief Última conversão de um canal
+ * @param channel Canal
+ * @return Valor de 12 bits
+ */
+uint16_t analog_latest(analog_channel_t channel) {
+    if (data_channel < 0)
+        return 0;
+    return ring[analog_last_index(channel)];
+}
+
+/**
+ * @brief Média das últimas ANALOG_DEPTH conversões de um canal (reduz o ruído do ADC)
+ * @param channel Canal
+ * @return Valor de 12 bits
+ */
+uint16_t analog_average(analog_channel_t channel) {
+    if (data_channel < 0)
+        return 0;
+    uint32_t sum = 0;
+    for (uint32_t i = channel; i < ANALOG_RING_LEN; i += ANALOG_CHANNELS)
+        sum += ring[i];
+    return (uint16_t)((sum + ANALOG_DEPTH / 2) / ANALOG_DEPTH);
+}
+
+/**
+ * @brief Temperatura do chip pelo sensor interno (fórmula do datasheet do RP2040)
+ * @return Temperatura em °C
+ */
+float analog_temperature_c(void) {
+    float volts = analog_average(ANALOG_TEMPERATURE) * 3.3f / 4096;
+    return 27.0f - (volts - 0.706f) / 0.001721f;
+}
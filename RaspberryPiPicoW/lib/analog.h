@@ -0,0 +1,34 @@
+#ifndef ANALOG_H
+#define ANALOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#define ANALOG_JOYSTICK_Y_PIN 26 // ADC0
+#define ANALOG_JOYSTICK_X_PIN 27 // ADC1
+#define ANALOG_RATE_HZ 1000 // Amostras por segundo de cada canal
+#define ANALOG_DEPTH 16 // Amostras guardadas por canal (janela da média)
+#define ANALOG_ADC_CLOCK_HZ 48000000 // Clock do ADC (USB PLL)
+
+// Canais lidos em rodízio pelo ADC, na ordem em que ele os converte (entrada crescente).
+// O VSYS (ADC3, GPIO29) fica de fora: na Pico W o pino é o clock do SPI do CYW43.
+typedef enum {
+    ANALOG_JOYSTICK_Y = 0, // ADC0
+    ANALOG_JOYSTICK_X, // ADC1
+    ANALOG_TEMPERATURE, // ADC4, sensor interno
+    ANALOG_CHANNELS
+} analog_channel_t;
+
+#define ANALOG_ADC_MASK ((1u << 0) | (1u << 1) | (1u << 4)) // Entradas do rodízio
+#define ANALOG_RING_LEN (ANALOG_CHANNELS * ANALOG_DEPTH) // Amostras no anel do DMA
+
+void analog_init(void); // Inicia a conversão contínua com DMA (pode ser chamada mais de uma vez)
+uint16_t analog_latest(analog_channel_t channel); // Última conversão de um canal
+uint16_t analog_average(analog_channel_t channel); // Média das últimas ANALOG_DEPTH conversões
+float analog_temperature_c(void); // Temperatura do chip (°C)
+
+#endif
@@ -0,0 +1,196 @@
+#include "anomaly.h"
+#include <math.h>
+#include <string.h>
+
+#define ANOMALY_MIN_VAR ((uint32_t)ANOMALY_MIN_STD * ANOMALY_MIN_STD << 8)
+
+static const char *const ANOMALY_KIND_NAMES[ANOMALY_KIND_COUNT] = {"level", "rate"};
+
+// Estatísticas móveis de um canal, em ponto fixo Q8 sobre o formato do histórico
+typedef struct {
+    int32_t mean; // Média (Q8)
+    uint32_t var; // Variância em torno da média (Q8)
+    uint32_t rate_var; // Variância da diferença entre amostras, supondo média nula (Q8)
+    int16_t prev; // Valor anterior (após o filtro)
+    int16_t window[ANOMALY_MEDIAN_N]; // Últimos valores brutos, para a mediana
+    uint8_t window_pos; // Próxima posição da janela
+    uint8_t window_len; // Valores na janela
+    uint8_t active; // Um bit por anomaly_kind_t em andamento
+    uint16_t count; // Amostras vistas (para no fim do aprendizado)
+} channel_stats_t;
+
+static channel_stats_t stats[SENSOR_CH_COUNT];
+static uint32_t last_t_ms; // Instante da amostra anterior
+
+/**
+ * @brief Satura um valor Q8 em 32 bits
+ */
+static uint32_t anomaly_sat(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+/**
+ * @brief Passo da variância móvel exponencial: var = (1 - a)(var + a·x), com a = 2^-shift
+ * @param var Variância atual (Q8)
+ * @param sq Quadrado do desvio da amostra (Q8)
+ * @param shift Peso da amostra
+ */
+static uint32_t anomaly_ewmv(uint32_t var, uint64_t sq, int shift) {
+    uint64_t next = var + (sq >> shift);
+    return anomaly_sat(next - (next >> shift));
+}
+
+/**
+ * @brief Mediana da janela (ordenação por inserção de no máximo 7 valores)
+ */
+static int16_t anomaly_median(const channel_stats_t *s) {
+    int16_t sorted[ANOMALY_MEDIAN_N];
+    for (int i = 0; i < ANOMALY_MEDIAN_N; i++) {
+        int16_t v = s->window[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+    return sorted[ANOMALY_MEDIAN_N / 2];
+}
+
+/**
+ * @brief Publica um evento de anomalia com o escore e as últimas amostras do canal
+ */
+static void anomaly_publish(MQTT_CLIENT_DATA_T *mqtt, sensor_channel_t ch, anomaly_kind_t kind, bool firing,
+                            float score, int16_t value, float rate, uint32_t t_ms) {
+    if (firing)
+        metrics_add(kind == ANOMALY_LEVEL ? &metrics.anomaly_level : &metrics.anomaly_rate, 1);
+    if (!mqtt || !mqtt->mqtt_client_inst || !mqtt_client_is_connected(mqtt->mqtt_client_inst))
+        return;
+    char payload[384];
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"channel\":\"%s\",\"kind\":\"%s\",\"state\":\"%s\",\"score\":%.1f,\"value\":%g,"
+                       "\"mean\":%g,\"std\":%g,\"rate\":%g,\"t_ms\":%lu,\"context\":[",
+                       SENSOR_CHANNEL_NAMES[ch], ANOMALY_KIND_NAMES[kind], firing ? "firing" : "resolved", score,
+                       history_to_float(ch, value), anomaly_mean(ch), anomaly_std(ch), rate, (unsigned long)t_ms);
+    int16_t context[ANOMALY_CONTEXT];
+    uint32_t n = history_recent(ch, context, ANOMALY_CONTEXT);
+    for (uint32_t i = 0; i < n && len < (int)sizeof(payload); i++)
+        len += snprintf(payload + len, sizeof(payload) - len, "%s%g", i ? "," : "", history_to_float(ch, context[i]));
+    if (len < (int)sizeof(payload))
+        snprintf(payload + len, sizeof(payload) - len, "]}");
+    power_radio_burst(); // Como os alertas das regras, o evento não espera a próxima rajada
+    publish_message(mqtt, full_topic(mqtt, ANOMALY_TOPIC), payload, false);
+}
+
+/**
+ * @brief Atualiza as estatísticas de cada canal com a amostra e publica as anomalias;
+ * chamada a cada amostra, com o lwIP bloqueado
+ *
+ * Nível: o desvio da média móvel é comparado com ANOMALY_Z_LIMIT desvios-padrão
+ * e o evento normaliza abaixo de ANOMALY_Z_CLEAR. Taxa: a diferença para a
+ * amostra anterior é comparada com ANOMALY_RATE_LIMIT desvios-padrão das
+ * diferenças habituais, e só o disparo é publicado. As comparações usam os
+ * quadrados (sem raiz) e a contribuição de cada amostra à variância é limitada
+ * ao próprio limite, para que um pico não mascare os seguintes. A média
+ * acompanha uma mudança de patamar, que gera um só evento de nível.
+ * Nos canais filtrados pela mediana, picos de uma amostra são descartados
+ * antes das estatísticas, ao custo de ANOMALY_MEDIAN_N / 2 amostras de atraso.
+ * @param sample Amostra (formato do histórico)
+ * @param mqtt Cliente MQTT para os eventos
+ */
+void anomaly_update(const history_sample_t *sample, MQTT_CLIENT_DATA_T *mqtt) {
+    uint32_t dt_ms = sample->t_ms - last_t_ms;
+    last_t_ms = sample->t_ms;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        channel_stats_t *s = &stats[ch];
+        int16_t x = sample->value[ch];
+
+        if (ANOMALY_MEDIAN_MASK & (1u << ch)) {
+            s->window[s->window_pos] = x;
+            s->window_pos = (s->window_pos + 1) % ANOMALY_MEDIAN_N;
+            if (s->window_len < ANOMALY_MEDIAN_N)
+                s->window_len++;
+            if (s->window_len == ANOMALY_MEDIAN_N) {
+                int16_t m = anomaly_median(s);
+                int64_t removed = ((int64_t)x - m) << 8; // Q8
+                if (s->count >= ANOMALY_WARMUP &&
+                    (uint64_t)(removed * removed >> 8) > (uint64_t)ANOMALY_Z_LIMIT * ANOMALY_Z_LIMIT * MAX(s->var, ANOMALY_MIN_VAR))
+                    metrics_add(&metrics.anomaly_spikes, 1); // Só conta o que seria uma anomalia de nível
+                x = m;
+            }
+        }
+        if (s->count == 0) {
+            s->mean = (int32_t)x << 8;
+            s->prev = x;
+            s->count = 1;
+            continue;
+        }
+
+        int32_t d = ((int32_t)x << 8) - s->mean; // Q8
+        int32_t delta = (int32_t)x - s->prev;
+        uint64_t d_sq = ((uint64_t)((int64_t)d * d)) >> 8; // Q8
+        uint64_t delta_sq = (uint64_t)((int64_t)delta * delta) << 8; // Q8
+        uint64_t var = MAX(s->var, ANOMALY_MIN_VAR);
+        uint64_t rate_var = MAX(s->rate_var, ANOMALY_MIN_VAR);
+        uint64_t level_limit = (uint64_t)ANOMALY_Z_LIMIT * ANOMALY_Z_LIMIT * var;
+        uint64_t rate_limit = (uint64_t)ANOMALY_RATE_LIMIT * ANOMALY_RATE_LIMIT * rate_var;
+
+        if (s->count >= ANOMALY_WARMUP) {
+            float rate = dt_ms ? history_to_float(ch, delta) * 1000.0f / dt_ms : 0;
+            if (!(s->active & (1u << ANOMALY_LEVEL)) && d_sq > level_limit) {
+                s->active |= 1u << ANOMALY_LEVEL;
+                anomaly_publish(mqtt, ch, ANOMALY_LEVEL, true, sqrtf((float)d_sq / var), x, rate, sample->t_ms);
+            } else if ((s->active & (1u << ANOMALY_LEVEL)) &&
+                       d_sq < (uint64_t)ANOMALY_Z_CLEAR * ANOMALY_Z_CLEAR * var) {
+                s->active &= ~(1u << ANOMALY_LEVEL);
+                anomaly_publish(mqtt, ch, ANOMALY_LEVEL, false, sqrtf((float)d_sq / var), x, rate, sample->t_ms);
+            }
+            if (delta_sq > rate_limit) {
+                if (!(s->active & (1u << ANOMALY_RATE)))
+                    anomaly_publish(mqtt, ch, ANOMALY_RATE, true, sqrtf((float)delta_sq / rate_var), x, rate, sample->t_ms);
+                s->active |= 1u << ANOMALY_RATE;
+            } else {
+                s->active &= ~(1u << ANOMALY_RATE);
+            }
+        } else {
+            level_limit = rate_limit = UINT64_MAX; // Aprendizado: a variância cresce sem limite
+        }
+
+        // No aprendizado o peso cai com as amostras vistas (~1/n), para não subestimar a variância inicial
+        int shift = MIN(ANOMALY_ALPHA_SHIFT, 32 - __builtin_clz(s->count));
+        s->mean += d >> shift;
+        s->var = anomaly_ewmv(s->var, MIN(d_sq, level_limit), shift);
+        s->rate_var = anomaly_ewmv(s->rate_var, MIN(delta_sq, rate_limit), shift);
+        s->prev = x;
+        if (s->count < ANOMALY_WARMUP)
+            s->count++;
+    }
+}
+
+/**
+ * @brief Canais em anomalia
+ * @return Um bit por sensor_channel_t
+ */
+uint32_t anomaly_active_mask(void) {
+    uint32_t mask = 0;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        if (stats[ch].active)
+            mask |= 1u << ch;
+    return mask;
+}
+
+/**
+ * @brief Média móvel de um canal
+ * @param channel Canal
+ * @return Média na unidade do canal
+ */
+float anomaly_mean(sensor_channel_t channel) {
+    return history_to_float(channel, 1) * stats[channel].mean / 256.0f;
+}
+
+/**
+ * @brief Desvio-padrão móvel de um canal
+ * @param channel Canal
+ * @return Desvio-padrão na unidade do canal
+ */
+float anomaly_std(sensor_channel_t channel) {
+    return history_to_float(channel, 1) * sqrtf(stats[channel].var / 256.0f);
+}
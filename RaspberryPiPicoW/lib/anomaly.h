@@ -0,0 +1,42 @@
+#ifndef ANOMALY_H
+#define ANOMALY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "history.h"
+#include "mqtt_client.h"
+#include "power.h"
+#include "metrics.h"
+
+#define ANOMALY_TOPIC "/anomaly" // Eventos de anomalia
+#define ANOMALY_ALPHA_SHIFT 5 // Peso das médias móveis exponenciais: 1/32 (~16 s a 500 ms)
+#define ANOMALY_WARMUP 32 // Amostras de aprendizado antes de avaliar um canal
+#define ANOMALY_Z_LIMIT 5 // Desvio (em desvios-padrão) da média que caracteriza anomalia de nível
+#define ANOMALY_Z_CLEAR 3 // Desvio abaixo do qual a anomalia de nível normaliza
+#define ANOMALY_RATE_LIMIT 6 // Variação entre amostras (em desvios-padrão) que caracteriza anomalia de taxa
+#define ANOMALY_MIN_STD 4 // Desvio-padrão mínimo (formato do histórico), evita alarmes em canais quase constantes
+#define ANOMALY_CONTEXT 8 // Amostras anteriores enviadas junto com o evento
+
+#ifndef ANOMALY_MEDIAN_N
+#define ANOMALY_MEDIAN_N 3 // Janela do filtro de mediana (ímpar, até 7)
+#endif
+
+#ifndef ANOMALY_MEDIAN_MASK
+#define ANOMALY_MEDIAN_MASK (1u << SENSOR_CH_ALTITUDE) // Canais filtrados pela mediana (um bit por sensor_channel_t)
+#endif
+
+// Tipo de anomalia
+typedef enum {
+    ANOMALY_LEVEL = 0, // Valor longe da média (z-score)
+    ANOMALY_RATE, // Variação entre amostras fora do habitual
+    ANOMALY_KIND_COUNT
+} anomaly_kind_t;
+
+void anomaly_update(const history_sample_t *sample, MQTT_CLIENT_DATA_T *mqtt); // Atualiza as estatísticas e avalia a amostra (O(1) por canal)
+uint32_t anomaly_active_mask(void); // Canais em anomalia (um bit por sensor_channel_t)
+float anomaly_mean(sensor_channel_t channel); // Média móvel de um canal, na unidade do canal
+float anomaly_std(sensor_channel_t channel); // Desvio-padrão móvel de um canal, na unidade do canal
+
+#endif
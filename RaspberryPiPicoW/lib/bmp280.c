@@ -28,8 +28,10 @@ void bmp280_init(i2c_inst_t *i2c) {
 void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
     uint8_t buf[6];
     uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    if (metrics_i2c(METRICS_I2C_BMP280, i2c_write_timeout_us(i2c, ADDR, &reg, 1, true, I2C_TIMEOUT_US)) < 0 ||
+        metrics_i2c(METRICS_I2C_BMP280, i2c_read_timeout_us(i2c, ADDR, buf, 6, false, I2C_TIMEOUT_US)) < 0) {
+        memset(buf, 0, sizeof(buf));
+    }
 
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
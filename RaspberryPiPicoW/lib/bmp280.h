@@ -1,7 +1,9 @@
 #ifndef BMP280_H
 #define BMP280_H
 
+#include <string.h>
 #include "hardware/i2c.h"
+#include "metrics.h"
 
 // Defina os endereços e registros conforme o código original
 #define ADDR _u(0x77)
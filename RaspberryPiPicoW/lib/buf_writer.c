@@ -0,0 +1,38 @@
+#include "buf_writer.h"
+
+/**
+ * @brief Acrescenta texto formatado ao buffer de saída
+ * @param w Buffer de saída
+ * @param fmt Formato (printf)
+ */
+void buf_printf(buf_writer_t *w, const char *fmt, ...) {
+    if (w->overflow)
+        return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->buf + w->len, w->size - w->len, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= w->size - w->len)
+        w->overflow = true;
+    else
+        w->len += n;
+}
+
+/**
+ * @brief Marca a posição atual para um possível descarte
+ * @param w Buffer de saída
+ * @return Posição atual
+ */
+size_t buf_mark(buf_writer_t *w) {
+    return w->len;
+}
+
+/**
+ * @brief Descarta o que foi escrito após a marca
+ * @param w Buffer de saída
+ * @param mark Posição retornada por buf_mark
+ */
+void buf_rewind(buf_writer_t *w, size_t mark) {
+    w->len = mark;
+    w->overflow = false;
+}
@@ -0,0 +1,21 @@
+#ifndef BUF_WRITER_H
+#define BUF_WRITER_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Buffer de saída usado para montar trechos de texto sem estourar o espaço disponível
+typedef struct {
+    char *buf; // Início do buffer
+    size_t size; // Capacidade do buffer
+    size_t len; // Bytes já escritos
+    bool overflow; // Algum texto não coube
+} buf_writer_t;
+
+void buf_printf(buf_writer_t *w, const char *fmt, ...); // Acrescenta texto formatado ao buffer
+size_t buf_mark(buf_writer_t *w); // Marca a posição atual para um possível descarte
+void buf_rewind(buf_writer_t *w, size_t mark); // Descarta o que foi escrito após a marca
+
+#endif
@@ -21,15 +21,65 @@ void button_init_all(void){
 
 /**
  * @brief Função para debouncing
- * @param last_time Ponteiro para a última vez que o botão foi pressionado
+ * @param last_time_us Instante do último toque aceito
+ * @param time_us Instante do toque atual (time_us_32)
  * @return true se o botão foi pressionado, false caso contrário
  */
-bool debounce(volatile uint32_t *last_time){
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
-    if (current_time - *last_time > 250){ 
-        *last_time = current_time;
+bool debounce(uint32_t *last_time_us, uint32_t time_us){
+    if (time_us - *last_time_us > BUTTON_DEBOUNCE_US){
+        *last_time_us = time_us;
         return true;
     }
     return false;
 }
 
+// Fila sem trava de um produtor (interrupção) e um consumidor (laço principal):
+// cada índice só é escrito por um dos lados
+static button_event_t event_queue[BUTTON_EVENT_QUEUE_LEN];
+static volatile uint32_t event_head = 0; // Escrito só pela interrupção
+static volatile uint32_t event_tail = 0; // Escrito só pelo laço principal
+static volatile uint32_t event_dropped = 0;
+
+/**
+ * @brief Registra um evento de GPIO com o instante atual; chamada na interrupção
+ * @param gpio Pino
+ * @param events Eventos da interrupção
+ * @return false se a fila estava cheia (o evento é descartado)
+ */
+bool button_event_push(uint gpio, uint32_t events){
+    uint32_t head = event_head;
+    if (head - event_tail == BUTTON_EVENT_QUEUE_LEN) {
+        event_dropped++; // Em geral, repiques do mesmo toque: o primeiro já está na fila
+        return false;
+    }
+    button_event_t *event = &event_queue[head % BUTTON_EVENT_QUEUE_LEN];
+    event->gpio = gpio;
+    event->events = events;
+    event->time_us = time_us_32();
+    __mem_fence_release(); // O evento fica visível antes do novo índice
+    event_head = head + 1;
+    return true;
+}
+
+/**
+ * @brief Retira o evento mais antigo da fila
+ * @param event Destino do evento
+ * @return false se a fila estava vazia
+ */
+bool button_event_pop(button_event_t *event){
+    uint32_t tail = event_tail;
+    if (tail == event_head)
+        return false;
+    __mem_fence_acquire();
+    *event = event_queue[tail % BUTTON_EVENT_QUEUE_LEN];
+    __mem_fence_release(); // A cópia termina antes de liberar a posição
+    event_tail = tail + 1;
+    return true;
+}
+
+/**
+ * @brief Eventos perdidos com a fila cheia
+ */
+uint32_t button_events_dropped(void){
+    return event_dropped;
+}
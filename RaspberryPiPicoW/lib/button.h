@@ -6,14 +6,27 @@
 #include "pico/stdlib.h"
 #include "pico/time.h"
 #include "pico/bootrom.h"
+#include "hardware/sync.h"
 
 #define BUTTON_A_PIN 5 // Define o pino do botão A
 #define BUTTON_B_PIN 6 // Define o pino do botão B
 #define JOYSTICK_BUTTON_PIN 22 // Define o pino do botão do joystick
+#define BUTTON_DEBOUNCE_US 250000 // Intervalo mínimo entre dois toques aceitos
+#define BUTTON_EVENT_QUEUE_LEN 16 // Eventos pendentes (potência de 2)
+
+// Evento de GPIO registrado pela interrupção e tratado no laço principal
+typedef struct {
+    uint8_t gpio;
+    uint32_t events; // Máscara GPIO_IRQ_*
+    uint32_t time_us; // time_us_32() na interrupção
+} button_event_t;
 
 void button_init(uint gpio); // Inicializa o botão
 void button_init_all(); // Inicializa todos os botões
-bool debounce(volatile uint32_t *last_time); // Função para debouncing
+bool debounce(uint32_t *last_time_us, uint32_t time_us); // Função para debouncing
 void irq_handler(uint gpio, uint32_t events); // Função para gerenciar a interrupção dos botões
+bool button_event_push(uint gpio, uint32_t events); // Registra um evento (só na interrupção)
+bool button_event_pop(button_event_t *event); // Retira o evento mais antigo (só no laço principal)
+uint32_t button_events_dropped(void); // Eventos perdidos com a fila cheia
 
 #endif
\ No newline at end of file
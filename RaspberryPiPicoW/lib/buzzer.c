@@ -1,5 +1,28 @@
 #include "buzzer.h"
 
+// Sequência tocada pelo sequenciador
+typedef struct {
+    uint pin;
+    const buzzer_note_t *notes; // NULL: toca só a nota copiada em note
+    buzzer_note_t note;
+    size_t count;
+    uint8_t repeat; // Repetições restantes
+    buzzer_priority_t priority;
+    void (*on_done)(void);
+} buzzer_job_t;
+
+/**
+ * @brief Estado do sequenciador; alterado pelo alarme e, com interrupções desligadas, pelas chamadas de fora
+ */
+static struct {
+    buzzer_job_t current; // Sequência tocando
+    size_t index; // Próxima nota da sequência atual
+    bool playing;
+    alarm_id_t alarm; // Alarme que avança a sequência atual
+    buzzer_job_t queue[BUZZER_QUEUE_LEN]; // Em espera, da maior para a menor prioridade
+    uint8_t queued;
+} buzzer_seq;
+
 /**
  * @brief Inicializa o buzzer no pino especificado
  * @param gpio Pino do buzzer
@@ -39,35 +62,201 @@ void set_buzzer_frequency(uint pin, uint frequency) {
 }
 
 /**
- * @brief Toca o buzzer
+ * @brief Alarme que avança a sequência: toca a nota atual e agenda a próxima
+ *
+ * Ao fim de uma sequência (e das repetições), chama on_done e segue com a
+ * próxima da fila; só para quando a fila esvazia.
+ * @return Intervalo até a próxima nota (µs) ou 0 quando não há mais nada a tocar
+ */
+static int64_t buzzer_seq_alarm(alarm_id_t id, void *user_data) {
+    buzzer_job_t *job = &buzzer_seq.current;
+    pwm_set_gpio_level(job->pin, 0);
+    if (buzzer_seq.index >= job->count) {
+        if (job->repeat) {
+            if (job->repeat != BUZZER_REPEAT_FOREVER)
+                job->repeat--;
+            buzzer_seq.index = 0;
+        } else {
+            void (*on_done)(void) = job->on_done;
+            uint32_t irq = save_and_disable_interrupts();
+            bool next = buzzer_seq.queued > 0;
+            if (next) {
+                *job = buzzer_seq.queue[0];
+                buzzer_seq.queued--;
+                for (uint8_t i = 0; i < buzzer_seq.queued; i++)
+                    buzzer_seq.queue[i] = buzzer_seq.queue[i + 1];
+                buzzer_seq.index = 0;
+            } else {
+                buzzer_seq.playing = false;
+                buzzer_seq.alarm = 0;
+            }
+            restore_interrupts(irq);
+            if (on_done)
+                on_done();
+            if (!next)
+                return 0;
+        }
+    }
+    const buzzer_note_t *note = job->notes ? &job->notes[buzzer_seq.index] : &job->note;
+    buzzer_seq.index++;
+    if (note->frequency) {
+        set_buzzer_frequency(job->pin, note->frequency);
+        pwm_set_gpio_level(job->pin, 32768);
+    }
+    led_set(note->led);
+    return (int64_t)MAX(note->duration_ms, 1u) * 1000;
+}
+
+/**
+ * @brief Começa a tocar uma sequência (com interrupções desligadas)
+ * @return false se não houver alarme livre
+ */
+static bool buzzer_start(const buzzer_job_t *job) {
+    buzzer_seq.current = *job;
+    buzzer_seq.index = 0;
+    buzzer_seq.playing = true;
+    // O primeiro passo roda no alarme, como os demais; se já venceu, roda aqui mesmo
+    buzzer_seq.alarm = add_alarm_in_us(1, buzzer_seq_alarm, NULL, true);
+    if (buzzer_seq.alarm < 0) {
+        buzzer_seq.playing = false;
+        buzzer_seq.alarm = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Para a sequência atual sem chamar on_done (com interrupções desligadas)
+ */
+static void buzzer_stop_current(void) {
+    if (buzzer_seq.alarm > 0)
+        cancel_alarm(buzzer_seq.alarm);
+    buzzer_seq.alarm = 0;
+    buzzer_seq.playing = false;
+    pwm_set_gpio_level(buzzer_seq.current.pin, 0);
+}
+
+/**
+ * @brief Toca a sequência agora, interrompe a atual ou a coloca na fila, conforme a prioridade
+ *
+ * Uma sequência de prioridade maior interrompe a atual, que é descartada;
+ * com a fila cheia, a de menor prioridade na fila dá lugar a uma maior.
+ * on_done das sequências descartadas também é chamada.
+ * @return false se a sequência foi descartada
+ */
+static bool buzzer_submit(const buzzer_job_t *job) {
+    void (*dropped)(void) = NULL;
+    bool ok = true;
+    uint32_t irq = save_and_disable_interrupts();
+    if (!buzzer_seq.playing || job->priority > buzzer_seq.current.priority) {
+        if (buzzer_seq.playing) {
+            buzzer_stop_current();
+            dropped = buzzer_seq.current.on_done;
+        }
+        ok = buzzer_start(job);
+    } else {
+        uint8_t pos = 0;
+        while (pos < buzzer_seq.queued && buzzer_seq.queue[pos].priority >= job->priority)
+            pos++; // Mesma prioridade: ordem de chegada
+        if (pos == BUZZER_QUEUE_LEN) {
+            ok = false;
+        } else {
+            if (buzzer_seq.queued == BUZZER_QUEUE_LEN)
+                dropped = buzzer_seq.queue[--buzzer_seq.queued].on_done;
+            for (uint8_t i = buzzer_seq.queued; i > pos; i--)
+                buzzer_seq.queue[i] = buzzer_seq.queue[i - 1];
+            buzzer_seq.queue[pos] = *job;
+            buzzer_seq.queued++;
+        }
+    }
+    restore_interrupts(irq);
+    if (dropped)
+        dropped();
+    if (!ok && job->on_done)
+        job->on_done();
+    return ok;
+}
+
+/**
+ * @brief Enfileira uma sequência de notas; cada passo roda em um alarme, sem bloquear
+ * @param pin Pino do buzzer
+ * @param notes Notas (devem continuar válidas até o fim da sequência)
+ * @param count Quantidade de notas
+ * @param repeat Repetições após a primeira vez (BUZZER_REPEAT_FOREVER: até ser cancelada)
+ * @param priority Prioridade: uma maior interrompe a que está tocando
+ * @param on_done Chamada quando a sequência termina ou é descartada, possivelmente em contexto de interrupção;
+ *                não deve enfileirar outra sequência (opcional)
+ * @return false se a sequência foi descartada (fila cheia de prioridades iguais ou maiores)
+ */
+bool buzzer_play(uint pin, const buzzer_note_t *notes, size_t count, uint8_t repeat, buzzer_priority_t priority, void (*on_done)(void)) {
+    buzzer_job_t job = {.pin = pin, .notes = notes, .count = count, .repeat = repeat, .priority = priority, .on_done = on_done};
+    return buzzer_submit(&job);
+}
+
+/**
+ * @brief Interrompe a sequência atual e descarta as da fila com prioridade até max_priority
+ * @param max_priority Maior prioridade afetada
+ */
+void buzzer_cancel(buzzer_priority_t max_priority) {
+    void (*dropped[BUZZER_QUEUE_LEN + 1])(void);
+    uint8_t count = 0;
+    uint32_t irq = save_and_disable_interrupts();
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < buzzer_seq.queued; i++) {
+        if (buzzer_seq.queue[i].priority <= max_priority)
+            dropped[count++] = buzzer_seq.queue[i].on_done;
+        else
+            buzzer_seq.queue[kept++] = buzzer_seq.queue[i];
+    }
+    buzzer_seq.queued = kept;
+    if (buzzer_seq.playing && buzzer_seq.current.priority <= max_priority) {
+        buzzer_stop_current();
+        dropped[count++] = buzzer_seq.current.on_done;
+        if (buzzer_seq.queued) { // Segue com a próxima da fila
+            buzzer_job_t next = buzzer_seq.queue[0];
+            buzzer_seq.queued--;
+            for (uint8_t i = 0; i < buzzer_seq.queued; i++)
+                buzzer_seq.queue[i] = buzzer_seq.queue[i + 1];
+            buzzer_start(&next);
+        }
+    }
+    restore_interrupts(irq);
+    for (uint8_t i = 0; i < count; i++)
+        if (dropped[i])
+            dropped[i]();
+}
+
+/**
+ * @brief Indica se alguma sequência está tocando
+ */
+bool buzzer_busy(void) {
+    return buzzer_seq.playing;
+}
+
+/**
+ * @brief Toca o buzzer sem bloquear
  * @param pin Pino do buzzer
  * @param frequency Frequência do som
  * @param duration_ms Duração do som em ms
  */
 void play_buzzer(uint pin, uint frequency, uint duration_ms) {
-
-    set_buzzer_frequency(pin, frequency);   
-    pwm_set_gpio_level(pin, 32768);           
-    sleep_ms(duration_ms);                   
-    pwm_set_gpio_level(pin, 0);              
+    buzzer_job_t job = {.pin = pin, .note = {frequency, duration_ms, LED_KEEP}, .count = 1, .priority = BUZZER_PRIO_STATUS};
+    buzzer_submit(&job);
 }
 
 /**
  * @brief Toca um som de erro
  */
 void play_denied_sound(void){
-    play_buzzer(BUZZER_A_PIN, MI, 100);
-    sleep_ms(50);
-    play_buzzer(BUZZER_A_PIN, MI, 100);
+    static const buzzer_note_t notes[] = {{MI, 100}, {0, 50}, {MI, 100}};
+    buzzer_play(BUZZER_A_PIN, notes, count_of(notes), 0, BUZZER_PRIO_STATUS, NULL);
 }
 
 /**
  * @brief Toca um som de sucesso
  */
 void play_success_sound(void){
-    play_buzzer(BUZZER_A_PIN, SOL, 100);
-    sleep_ms(50);
-    play_buzzer(BUZZER_A_PIN, SOL, 100);
+    play_success_sound_async(NULL);
 }
 
 
@@ -75,11 +264,43 @@ void play_success_sound(void){
  * @brief Toca um som referente à configuração
  */
 void play_setup_sound(void) {
-    play_buzzer(BUZZER_A_PIN, LA, 100);
-    sleep_ms(50);
-    play_buzzer(BUZZER_A_PIN, SI, 100);
-    sleep_ms(50);
-    play_buzzer(BUZZER_A_PIN, DO, 100);
-    sleep_ms(50);
-    play_buzzer(BUZZER_A_PIN, RE, 100);
-}
\ No newline at end of file
+    static const buzzer_note_t notes[] = {{LA, 100}, {0, 50}, {SI, 100}, {0, 50}, {DO, 100}, {0, 50}, {RE, 100}};
+    buzzer_play(BUZZER_A_PIN, notes, count_of(notes), 0, BUZZER_PRIO_STATUS, NULL);
+}
+
+/**
+ * @brief Toca o som de alerta com o LED amarelo
+ */
+void play_warning_sound(void) {
+    static const buzzer_note_t notes[] = {{MI, 150, LED_YELLOW}, {0, 100, LED_OFF}, {MI, 150, LED_YELLOW}, {0, 1, LED_OFF}};
+    buzzer_play(BUZZER_A_PIN, notes, count_of(notes), 0, BUZZER_PRIO_WARNING, NULL);
+}
+
+/**
+ * @brief Toca o alarme crítico, com o LED vermelho piscando, até buzzer_cancel
+ */
+void play_critical_sound(void) {
+    static const buzzer_note_t notes[] = {{LA, 200, LED_RED}, {SI, 200, LED_OFF}};
+    buzzer_play(BUZZER_A_PIN, notes, count_of(notes), BUZZER_REPEAT_FOREVER, BUZZER_PRIO_CRITICAL, black);
+}
+
+/**
+ * @brief Toca uma sequência de notas sem bloquear, com prioridade de aviso de estado
+ * @param pin Pino do buzzer
+ * @param notes Notas (devem continuar válidas até o fim da sequência)
+ * @param count Quantidade de notas
+ * @param on_done Chamada ao fim da sequência, em contexto de interrupção (opcional)
+ * @return false se a sequência foi descartada
+ */
+bool play_buzzer_async(uint pin, const buzzer_note_t *notes, size_t count, void (*on_done)(void)) {
+    return buzzer_play(pin, notes, count, 0, BUZZER_PRIO_STATUS, on_done);
+}
+
+/**
+ * @brief Toca o som de sucesso sem bloquear
+ * @param on_done Chamada ao fim do som (opcional)
+ */
+void play_success_sound_async(void (*on_done)(void)) {
+    static const buzzer_note_t notes[] = {{SOL, 100}, {0, 50}, {SOL, 100}};
+    play_buzzer_async(BUZZER_A_PIN, notes, count_of(notes), on_done);
+}
@@ -5,17 +5,43 @@
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "led_rgb.h"
 
 #define BUZZER_A_PIN 10 // Define o pino do buzzer A
 #define BUZZER_B_PIN 21 // Define o pino do buzzer B
+#define BUZZER_QUEUE_LEN 4 // Sequências aguardando a vez
+#define BUZZER_REPEAT_FOREVER 0xFF // Repete até buzzer_cancel ou ser interrompida
+
+// Prioridade de uma sequência: uma maior interrompe a que está tocando
+typedef enum {
+    BUZZER_PRIO_STATUS = 0, // Avisos de estado (boot, configuração)
+    BUZZER_PRIO_WARNING, // Alertas
+    BUZZER_PRIO_CRITICAL // Alarmes críticos
+} buzzer_priority_t;
+
+// Nota de uma sequência tocada em segundo plano (frequency 0: pausa)
+typedef struct {
+    uint frequency;
+    uint duration_ms;
+    led_color_t led; // Cor do LED durante a nota (LED_KEEP: não altera)
+} buzzer_note_t;
 
 void buzzer_init(uint gpio); // Inicializa o buzzer
 void buzzer_init_all(); // Inicializa todos os buzzers
 void set_buzzer_frequency(uint pin, uint frequency); // Configura a frequência do buzzer
-void play_buzzer(uint pin, uint frequency, uint duration_ms); // Toca o buzzer
+bool buzzer_play(uint pin, const buzzer_note_t *notes, size_t count, uint8_t repeat, buzzer_priority_t priority, void (*on_done)(void)); // Enfileira uma sequência
+void buzzer_cancel(buzzer_priority_t max_priority); // Interrompe e descarta as sequências até essa prioridade
+bool buzzer_busy(void); // Indica se alguma sequência está tocando
+void play_buzzer(uint pin, uint frequency, uint duration_ms); // Toca o buzzer (sem bloquear)
 void play_denied_sound(); // Toca o som de negação
 void play_success_sound(); // Toca o som de sucesso
 void play_setup_sound(); // Toca o som referente à configuração
+void play_warning_sound(void); // Toca o alerta (LED amarelo)
+void play_critical_sound(void); // Toca o alarme crítico até buzzer_cancel (LED vermelho piscando)
+
+bool play_buzzer_async(uint pin, const buzzer_note_t *notes, size_t count, void (*on_done)(void)); // Toca uma sequência sem bloquear
+void play_success_sound_async(void (*on_done)(void)); // Toca o som de sucesso sem bloquear
 
 // Frequências das notas musicais (em Hz)
 enum NotasMusicais {
@@ -0,0 +1,208 @@
+#include "dashboard.h"
+#include <string.h>
+
+// Canais exibidos (os agregados do histórico): rótulo curto e casas decimais
+static const struct {
+    const char *label;
+    uint8_t decimals;
+} DASH_CHANNELS[HISTORY_AGG_CHANNELS] = {
+    {"Temp", 2}, {"Umid", 2}, {"Alt", 1}, {"Giro", 1}, {"Acel", 3},
+};
+
+static volatile int8_t page_request = 0; // Passos pedidos pelos botões, ainda não aplicados
+static uint8_t page = DASH_PAGE_VALUES; // Página exibida
+static bool page_drawn = false; // A página atual já foi desenhada ao menos uma vez
+static uint32_t drawn_sample_ms = 0; // Instante da amostra usada no último desenho
+static absolute_time_t status_deadline; // Próxima atualização da página de estado
+
+/**
+ * @brief Pede a troca de página; só altera um contador, o desenho fica com dashboard_update
+ * @param step Páginas a avançar (negativo: voltar)
+ */
+void dashboard_page_step(int step) {
+    page_request += step;
+}
+
+/**
+ * @brief Escreve uma linha de texto com largura fixa, sobrescrevendo o conteúdo anterior
+ *
+ * Como os glifos são opacos, não é preciso apagar a linha: só os bytes que mudam são enviados.
+ * @param ssd Ponteiro para a estrutura do display
+ * @param row Linha de texto (0 a 7)
+ * @param text Texto (truncado ou completado com espaços)
+ */
+static void dashboard_line(ssd1306_t *ssd, uint8_t row, const char *text) {
+    char line[DASHBOARD_CHARS + 1];
+    snprintf(line, sizeof(line), "%-*s", DASHBOARD_CHARS, text);
+    for (uint8_t i = 0; i < DASHBOARD_CHARS; i++)
+        ssd1306_draw_char(ssd, line[i], i * 8, row * 8);
+}
+
+/**
+ * @brief Formata um valor armazenado no histórico com as casas decimais do canal
+ */
+static void dashboard_format(char *buf, size_t size, int ch, int16_t value) {
+    snprintf(buf, size, "%.*f", DASH_CHANNELS[ch].decimals, history_to_float(ch, value));
+}
+
+/**
+ * @brief Desenha o título da página com o número dela
+ */
+static void dashboard_title(ssd1306_t *ssd, const char *title) {
+    char line[DASHBOARD_CHARS + 1];
+    snprintf(line, sizeof(line), "%-11s %d/%d", title, page + 1, DASH_PAGE_COUNT);
+    dashboard_line(ssd, 0, line);
+}
+
+/**
+ * @brief Página de valores atuais
+ */
+static void dashboard_values(ssd1306_t *ssd, const history_sample_t *sample) {
+    dashboard_title(ssd, "Agora");
+    for (int ch = 0; ch < HISTORY_AGG_CHANNELS; ch++) {
+        char value[12], line[DASHBOARD_CHARS + 1];
+        dashboard_format(value, sizeof(value), ch, sample->value[ch]);
+        snprintf(line, sizeof(line), "%-5s%11s", DASH_CHANNELS[ch].label, value);
+        dashboard_line(ssd, 2 + ch, line);
+    }
+}
+
+/**
+ * @brief Página de mínimo e máximo desde o boot
+ */
+static void dashboard_extremes(ssd1306_t *ssd) {
+    dashboard_title(ssd, "Min/Max");
+    for (int ch = 0; ch < HISTORY_AGG_CHANNELS; ch++) {
+        int16_t min, max;
+        char lo[8], hi[8], line[DASHBOARD_CHARS + 1];
+        if (!history_extremes(ch, &min, &max))
+            min = max = 0;
+        dashboard_format(lo, sizeof(lo), ch, min);
+        dashboard_format(hi, sizeof(hi), ch, max);
+        snprintf(line, sizeof(line), "%-4s%6s%6s", DASH_CHANNELS[ch].label, lo, hi);
+        dashboard_line(ssd, 2 + ch, line);
+    }
+}
+
+/**
+ * @brief Página de gráfico de um canal: últimas DASHBOARD_SPARK_POINTS amostras, escala automática
+ */
+static void dashboard_spark(ssd1306_t *ssd, int ch, const history_sample_t *sample) {
+    int16_t values[DASHBOARD_SPARK_POINTS];
+    uint32_t count = history_recent(ch, values, DASHBOARD_SPARK_POINTS);
+    int16_t min = INT16_MAX, max = INT16_MIN;
+    for (uint32_t i = 0; i < count; i++) {
+        if (values[i] < min) min = values[i];
+        if (values[i] > max) max = values[i];
+    }
+
+    char value[12], line[DASHBOARD_CHARS + 1];
+    dashboard_title(ssd, DASH_CHANNELS[ch].label);
+    dashboard_format(value, sizeof(value), ch, sample->value[ch]);
+    snprintf(line, sizeof(line), "%s", value);
+    dashboard_line(ssd, 1, line);
+
+    // O gráfico rola a cada amostra, então a área inteira muda de qualquer forma
+    const uint8_t height = ssd->height - DASHBOARD_SPARK_TOP;
+    ssd1306_rect(ssd, DASHBOARD_SPARK_TOP, 0, ssd->width, height, false, true);
+    if (count == 0)
+        return;
+    int32_t span = (int32_t)max - min;
+    uint8_t x = ssd->width - count; // Alinha à direita: a amostra mais nova fica na última coluna
+    uint8_t prev = 0;
+    for (uint32_t i = 0; i < count; i++, x++) {
+        uint8_t y = ssd->height - 1;
+        if (span > 0)
+            y -= (uint8_t)(((int32_t)values[i] - min) * (height - 1) / span);
+        else
+            y -= height / 2;
+        // Liga ao ponto anterior com um traço vertical, para o gráfico não ficar pontilhado
+        if (i == 0)
+            prev = y;
+        ssd1306_vline(ssd, x, MIN(prev, y), MAX(prev, y), true);
+        prev = y;
+    }
+}
+
+/**
+ * @brief Página de estado: enlace Wi-Fi, broker MQTT e log no cartão
+ */
+static void dashboard_status(ssd1306_t *ssd, MQTT_CLIENT_DATA_T *mqtt) {
+    char line[DASHBOARD_CHARS + 1];
+    char ip[IPADDR_STRLEN_MAX] = "";
+    // Estado do enlace, endereço e cliente MQTT são do lwIP: lidos com ele travado, como nos callbacks
+    cyw43_arch_lwip_begin();
+    bool link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP;
+    if (link && netif_default)
+        ipaddr_ntoa_r(&netif_default->ip_addr, ip, sizeof(ip));
+    bool broker = mqtt && mqtt->mqtt_client_inst && mqtt_client_is_connected(mqtt->mqtt_client_inst);
+    cyw43_arch_lwip_end();
+    uint32_t up_s = to_ms_since_boot(get_absolute_time()) / 1000;
+
+    dashboard_title(ssd, "Estado");
+    snprintf(line, sizeof(line), "WiFi  %s", link ? "ok" : "--");
+    dashboard_line(ssd, 2, line);
+    snprintf(line, sizeof(line), "%s", ip);
+    dashboard_line(ssd, 3, line);
+    snprintf(line, sizeof(line), "MQTT  %s", broker ? "ok" : "--");
+    dashboard_line(ssd, 4, line);
+    snprintf(line, sizeof(line), "SD    %s", log_writer_is_open() ? "gravando" : "--");
+    dashboard_line(ssd, 5, line);
+    snprintf(line, sizeof(line), "Perd  %lu", (unsigned long)metrics_read(&metrics.log_dropped));
+    dashboard_line(ssd, 6, line);
+    snprintf(line, sizeof(line), "Up %02lu:%02lu:%02lu", (unsigned long)(up_s / 3600),
+             (unsigned long)(up_s / 60 % 60), (unsigned long)(up_s % 60));
+    dashboard_line(ssd, 7, line);
+}
+
+/**
+ * @brief Redesenha a página atual se algo mudou e inicia o envio por DMA
+ *
+ * Chamada a cada volta do laço principal; não faz nada enquanto o envio
+ * anterior não termina ou antes de SSD1306_FRAME_MS. Uma página só é
+ * redesenhada quando chega amostra nova (ou, na de estado, a cada
+ * DASHBOARD_STATUS_MS), e só os bytes alterados vão para o barramento.
+ * @param ssd Ponteiro para a estrutura do display
+ * @param mqtt Estado do cliente MQTT (para a página de estado)
+ */
+void dashboard_update(ssd1306_t *ssd, MQTT_CLIENT_DATA_T *mqtt) {
+    if (!ssd1306_frame_due(ssd))
+        return;
+
+    uint32_t irq = save_and_disable_interrupts(); // O contador também é alterado pela interrupção dos botões
+    int8_t step = page_request;
+    page_request = 0;
+    restore_interrupts(irq);
+    if (step) {
+        page = (uint8_t)((page + step % DASH_PAGE_COUNT + DASH_PAGE_COUNT) % DASH_PAGE_COUNT);
+        page_drawn = false;
+    }
+
+    history_sample_t sample;
+    if (!history_latest(&sample))
+        return; // Mantém a tela de início até a primeira leitura
+    bool fresh = sample.t_ms != drawn_sample_ms;
+    if (page == DASH_PAGE_STATUS)
+        fresh = time_reached(status_deadline);
+    if (page_drawn && !fresh)
+        return;
+
+    uint64_t start = time_us_64();
+    if (!page_drawn)
+        ssd1306_fill(ssd, false);
+    if (page == DASH_PAGE_VALUES)
+        dashboard_values(ssd, &sample);
+    else if (page == DASH_PAGE_EXTREMES)
+        dashboard_extremes(ssd);
+    else if (page < DASH_PAGE_STATUS)
+        dashboard_spark(ssd, page - DASH_PAGE_SPARK, &sample);
+    else {
+        dashboard_status(ssd, mqtt);
+        status_deadline = make_timeout_time_ms(DASHBOARD_STATUS_MS);
+    }
+    page_drawn = true;
+    drawn_sample_ms = sample.t_ms;
+    metrics_observe(&metrics.display_render_latency, (uint32_t)(time_us_64() - start));
+
+    ssd1306_flush(ssd);
+}
@@ -0,0 +1,32 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+#include "history.h"
+#include "metrics.h"
+#include "web_server.h"
+#include "mqtt_client.h"
+#include "log_writer.h"
+
+#define DASHBOARD_CHARS (SSD1306_WIDTH / 8) // Caracteres por linha (fonte 8x8)
+#define DASHBOARD_SPARK_POINTS SSD1306_WIDTH // Amostras no gráfico: uma por coluna
+#define DASHBOARD_SPARK_TOP 16 // Primeira linha do gráfico (abaixo do título e do valor atual)
+#define DASHBOARD_STATUS_MS 1000 // Intervalo de atualização da página de estado
+
+// Páginas do painel, na ordem de navegação
+typedef enum {
+    DASH_PAGE_VALUES = 0, // Valores atuais
+    DASH_PAGE_EXTREMES, // Mínimo e máximo desde o boot
+    DASH_PAGE_SPARK, // Gráficos: uma página por canal agregado
+    DASH_PAGE_STATUS = DASH_PAGE_SPARK + HISTORY_AGG_CHANNELS, // Wi-Fi, MQTT e cartão SD
+    DASH_PAGE_COUNT
+} dashboard_page_t;
+
+void dashboard_page_step(int step); // Pede a troca de página (segura na interrupção dos botões)
+void dashboard_update(ssd1306_t *ssd, MQTT_CLIENT_DATA_T *mqtt); // Redesenha o que mudou e inicia o envio por DMA
+
+#endif
@@ -0,0 +1,379 @@
+#include "history.h"
+#include <string.h>
+
+// Escala de ponto fixo e casas decimais de cada canal (mesma ordem de sensor_channel_t)
+static const int16_t HISTORY_SCALE[SENSOR_CH_COUNT] = {100, 100, 10, 10, 1000, 10, 10, 10, 1000, 1000, 1000};
+static const uint8_t HISTORY_DECIMALS[SENSOR_CH_COUNT] = {2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 3};
+
+static history_sample_t raw_ring[HISTORY_RAW_LEN]; // Anel em taxa cheia
+static uint32_t raw_seq = 0; // Total de amostras já inseridas no anel em taxa cheia
+
+static int16_t boot_min[SENSOR_CH_COUNT]; // Menor valor de cada canal desde o boot
+static int16_t boot_max[SENSOR_CH_COUNT]; // Maior valor de cada canal desde o boot
+
+// Anel de agregados de período fixo, com o agregado do período corrente ainda aberto
+typedef struct {
+    history_agg_t *ring;
+    uint32_t len; // Entradas do anel
+    uint32_t period_ms; // Período de cada agregado
+    uint32_t seq; // Total de agregados já inseridos
+    struct {
+        uint32_t t_ms;
+        int16_t min[HISTORY_AGG_CHANNELS];
+        int16_t max[HISTORY_AGG_CHANNELS];
+        int32_t sum[HISTORY_AGG_CHANNELS];
+        uint32_t count;
+    } open;
+} history_tier_t;
+
+static history_agg_t agg_ring[HISTORY_AGG_LEN]; // Anel de agregados de 1 s
+static history_agg_t slow_ring[HISTORY_SLOW_LEN]; // Anel de agregados de 1 min
+
+// Anéis de agregados, indexados por history_source_t - 1
+static history_tier_t tiers[HISTORY_SOURCE_COUNT - 1] = {
+    {agg_ring, HISTORY_AGG_LEN, HISTORY_AGG_PERIOD_MS},
+    {slow_ring, HISTORY_SLOW_LEN, HISTORY_SLOW_PERIOD_MS},
+};
+
+static const char *const HISTORY_SOURCE_NAMES[HISTORY_SOURCE_COUNT] = {"raw", "agg_1s", "agg_1m"};
+
+/**
+ * @brief Converte um valor em ponto flutuante para o formato armazenado
+ * @param channel Canal do valor
+ * @param value Valor na unidade do canal
+ * @return Valor escalado e saturado em 16 bits
+ */
+int16_t history_from_float(sensor_channel_t channel, float value) {
+    float scaled = value * HISTORY_SCALE[channel];
+    if (scaled > INT16_MAX)
+        return INT16_MAX;
+    if (scaled < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+}
+
+/**
+ * @brief Converte um valor armazenado para a unidade do canal
+ * @param channel Canal do valor
+ * @param value Valor escalado
+ * @return Valor na unidade do canal
+ */
+float history_to_float(sensor_channel_t channel, int16_t value) {
+    return (float)value / HISTORY_SCALE[channel];
+}
+
+/**
+ * @brief Fecha o agregado corrente e o insere no anel
+ * @param tier Anel de agregados
+ */
+static void history_commit_agg(history_tier_t *tier) {
+    if (tier->open.count == 0)
+        return;
+    history_agg_t *slot = &tier->ring[tier->seq % tier->len];
+    slot->t_ms = tier->open.t_ms;
+    for (int ch = 0; ch < HISTORY_AGG_CHANNELS; ch++) {
+        slot->min[ch] = tier->open.min[ch];
+        slot->max[ch] = tier->open.max[ch];
+        slot->mean[ch] = (int16_t)(tier->open.sum[ch] / (int32_t)tier->open.count);
+    }
+    tier->seq++;
+    tier->open.count = 0;
+}
+
+/**
+ * @brief Acumula uma amostra no agregado aberto, fechando o anterior ao mudar de período
+ * @param tier Anel de agregados
+ * @param sample Amostra
+ */
+static void history_push_agg(history_tier_t *tier, const history_sample_t *sample) {
+    uint32_t period = sample->t_ms - (sample->t_ms % tier->period_ms);
+    if (tier->open.count > 0 && tier->open.t_ms != period)
+        history_commit_agg(tier);
+    if (tier->open.count == 0) {
+        tier->open.t_ms = period;
+        for (int ch = 0; ch < HISTORY_AGG_CHANNELS; ch++) {
+            tier->open.min[ch] = INT16_MAX;
+            tier->open.max[ch] = INT16_MIN;
+            tier->open.sum[ch] = 0;
+        }
+    }
+    for (int ch = 0; ch < HISTORY_AGG_CHANNELS; ch++) {
+        int16_t v = sample->value[ch];
+        if (v < tier->open.min[ch]) tier->open.min[ch] = v;
+        if (v > tier->open.max[ch]) tier->open.max[ch] = v;
+        tier->open.sum[ch] += v;
+    }
+    tier->open.count++;
+}
+
+/**
+ * @brief Adiciona uma amostra ao histórico
+ * @param readings Leitura dos sensores
+ * @param t_ms Instante da leitura (ms desde o boot)
+ */
+void history_push(const SensorReadings *readings, uint32_t t_ms) {
+    history_sample_t *slot = &raw_ring[raw_seq % HISTORY_RAW_LEN];
+    slot->t_ms = t_ms;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        int16_t v = history_from_float(ch, sensor_channel_value(readings, ch));
+        slot->value[ch] = v;
+        if (raw_seq == 0 || v < boot_min[ch]) boot_min[ch] = v;
+        if (raw_seq == 0 || v > boot_max[ch]) boot_max[ch] = v;
+    }
+    raw_seq++;
+
+    for (int i = 0; i < HISTORY_SOURCE_COUNT - 1; i++)
+        history_push_agg(&tiers[i], slot);
+}
+
+/**
+ * @brief Quantidade de amostras em taxa cheia armazenadas
+ * @return Quantidade de amostras
+ */
+uint32_t history_count(void) {
+    return raw_seq < HISTORY_RAW_LEN ? raw_seq : HISTORY_RAW_LEN;
+}
+
+/**
+ * @brief Obtém a amostra mais recente
+ * @param sample Ponteiro para armazenar a amostra
+ * @return true se existir alguma amostra
+ */
+bool history_latest(history_sample_t *sample) {
+    if (raw_seq == 0)
+        return false;
+    *sample = raw_ring[(raw_seq - 1) % HISTORY_RAW_LEN];
+    return true;
+}
+
+/**
+ * @brief Copia os valores mais recentes de um canal, do mais antigo ao mais novo
+ * @param channel Canal
+ * @param values Destino
+ * @param count Quantidade desejada
+ * @return Quantidade copiada (menor que count no início do boot)
+ */
+uint32_t history_recent(sensor_channel_t channel, int16_t *values, uint32_t count) {
+    uint32_t available = history_count();
+    if (count > available)
+        count = available;
+    uint32_t seq = raw_seq - count;
+    for (uint32_t i = 0; i < count; i++, seq++)
+        values[i] = raw_ring[seq % HISTORY_RAW_LEN].value[channel];
+    return count;
+}
+
+/**
+ * @brief Menor e maior valor de um canal desde o boot
+ * @param channel Canal
+ * @param min Ponteiro para o menor valor
+ * @param max Ponteiro para o maior valor
+ * @return true se existir alguma amostra
+ */
+bool history_extremes(sensor_channel_t channel, int16_t *min, int16_t *max) {
+    if (raw_seq == 0)
+        return false;
+    *min = boot_min[channel];
+    *max = boot_max[channel];
+    return true;
+}
+
+/**
+ * @brief Total de entradas já inseridas no anel consultado
+ */
+static uint32_t query_seq(const history_query_t *q) {
+    return q->source == HISTORY_SOURCE_RAW ? raw_seq : tiers[q->source - 1].seq;
+}
+
+/**
+ * @brief Primeira sequência ainda disponível no anel consultado
+ */
+static uint32_t query_oldest(const history_query_t *q) {
+    uint32_t seq = query_seq(q);
+    uint32_t len = q->source == HISTORY_SOURCE_RAW ? HISTORY_RAW_LEN : tiers[q->source - 1].len;
+    return seq > len ? seq - len : 0;
+}
+
+/**
+ * @brief Agregado de sequência seq no anel consultado (só para os anéis de agregados)
+ */
+static const history_agg_t *query_agg(const history_query_t *q, uint32_t seq) {
+    const history_tier_t *tier = &tiers[q->source - 1];
+    return &tier->ring[seq % tier->len];
+}
+
+/**
+ * @brief Instante da entrada de sequência seq no anel consultado
+ */
+static uint32_t query_time(const history_query_t *q, uint32_t seq) {
+    return q->source == HISTORY_SOURCE_RAW ? raw_ring[seq % HISTORY_RAW_LEN].t_ms : query_agg(q, seq)->t_ms;
+}
+
+/**
+ * @brief Busca binária pela primeira entrada com instante >= t_ms
+ */
+static uint32_t query_lower_bound(const history_query_t *q, uint32_t t_ms) {
+    uint32_t lo = query_oldest(q);
+    uint32_t hi = query_seq(q);
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (query_time(q, mid) < t_ms)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Inicia uma consulta ao histórico
+ * @param query Estado da consulta
+ * @param from Início do intervalo em ms desde o boot (negativo: relativo ao instante atual)
+ * @param to Fim do intervalo em ms desde o boot (negativo ou zero: relativo ao instante atual)
+ * @param points Quantidade de pontos desejada
+ */
+void history_query_begin(history_query_t *query, int64_t from, int64_t to, uint32_t points) {
+    int64_t now = to_ms_since_boot(get_absolute_time());
+    if (from < 0) from += now;
+    if (to <= 0) to += now;
+    if (from < 0) from = 0;
+    if (to > now) to = now;
+    if (to < from) to = from;
+
+    if (points == 0) points = HISTORY_DEFAULT_POINTS;
+    if (points > HISTORY_MAX_POINTS) points = HISTORY_MAX_POINTS;
+
+    memset(query, 0, sizeof(*query));
+    query->from = (uint32_t)from;
+    query->to = (uint32_t)to;
+    query->points = points;
+    query->step = (query->to - query->from + points - 1) / points;
+    if (query->step == 0) query->step = 1;
+    query->first = true;
+
+    // Usa o anel mais fino que cobre o início do intervalo; se nenhum cobre, o mais longo com dados
+    int covering = -1, longest = HISTORY_SOURCE_RAW;
+    for (int src = HISTORY_SOURCE_RAW; src < HISTORY_SOURCE_COUNT; src++) {
+        query->source = src;
+        if (query_seq(query) == 0)
+            continue;
+        longest = src;
+        if (covering < 0 && query_time(query, query_oldest(query)) <= query->from)
+            covering = src;
+    }
+    query->source = covering >= 0 ? covering : longest;
+    query->cursor = query_lower_bound(query, query->from);
+}
+
+/**
+ * @brief Escreve um ponto (mínimo, máximo e média de um intervalo) em JSON
+ * @param q Estado da consulta
+ * @param w Buffer de saída
+ * @param t_ms Início do ponto
+ * @param end_ms Fim do ponto
+ * @return true se havia amostras no intervalo
+ */
+static bool query_write_bucket(history_query_t *q, buf_writer_t *w, uint32_t t_ms, uint32_t end_ms) {
+    bool raw = q->source == HISTORY_SOURCE_RAW;
+    int nch = raw ? SENSOR_CH_COUNT : HISTORY_AGG_CHANNELS;
+    int16_t min[SENSOR_CH_COUNT], max[SENSOR_CH_COUNT];
+    int32_t sum[SENSOR_CH_COUNT];
+    uint32_t n = 0;
+    uint32_t end_seq = query_seq(q);
+
+    for (; q->cursor < end_seq && query_time(q, q->cursor) < end_ms; q->cursor++, n++) {
+        for (int ch = 0; ch < nch; ch++) {
+            int16_t lo, hi, mean;
+            if (raw) {
+                lo = hi = mean = raw_ring[q->cursor % HISTORY_RAW_LEN].value[ch];
+            } else {
+                const history_agg_t *a = query_agg(q, q->cursor);
+                lo = a->min[ch];
+                hi = a->max[ch];
+                mean = a->mean[ch];
+            }
+            if (n == 0 || lo < min[ch]) min[ch] = lo;
+            if (n == 0 || hi > max[ch]) max[ch] = hi;
+            sum[ch] = (n == 0 ? 0 : sum[ch]) + mean;
+        }
+    }
+    if (n == 0)
+        return false;
+
+    buf_printf(w, "%s{\"t\":%lu,\"n\":%lu", q->first ? "" : ",", (unsigned long)t_ms, (unsigned long)n);
+    const char *labels[3] = {"min", "max", "mean"};
+    for (int k = 0; k < 3; k++) {
+        buf_printf(w, ",\"%s\":[", labels[k]);
+        for (int ch = 0; ch < nch; ch++) {
+            int16_t v = k == 0 ? min[ch] : k == 1 ? max[ch] : (int16_t)(sum[ch] / (int32_t)n);
+            buf_printf(w, "%s%.*f", ch ? "," : "", HISTORY_DECIMALS[ch], history_to_float(ch, v));
+        }
+        buf_printf(w, "]");
+    }
+    buf_printf(w, "}");
+    return true;
+}
+
+/**
+ * @brief Gera o próximo trecho do JSON da consulta
+ * @param query Estado da consulta
+ * @param buf Buffer de saída
+ * @param size Tamanho do buffer
+ * @param done Indica que a consulta terminou
+ * @return Quantidade de bytes escritos (zero se nada coube no buffer)
+ */
+size_t history_query_read(history_query_t *query, char *buf, size_t size, bool *done) {
+    buf_writer_t w = {.buf = buf, .size = size};
+    *done = false;
+
+    if (query->stage == 0) {
+        buf_printf(&w, "{\"from\":%lu,\"to\":%lu,\"step\":%lu,\"source\":\"%s\",\"channels\":[",
+                      (unsigned long)query->from, (unsigned long)query->to, (unsigned long)query->step,
+                      HISTORY_SOURCE_NAMES[query->source]);
+        int nch = query->source == HISTORY_SOURCE_RAW ? SENSOR_CH_COUNT : HISTORY_AGG_CHANNELS;
+        for (int ch = 0; ch < nch; ch++)
+            buf_printf(&w, "%s\"%s\"", ch ? "," : "", SENSOR_CHANNEL_NAMES[ch]);
+        buf_printf(&w, "],\"points\":[");
+        if (w.overflow)
+            return 0;
+        query->stage = 1;
+    }
+
+    while (query->stage == 1) {
+        if (query->bucket >= query->points) {
+            query->stage = 2;
+            break;
+        }
+        // Entradas sobrescritas durante a consulta são descartadas
+        uint32_t oldest = query_oldest(query);
+        if (query->cursor < oldest)
+            query->cursor = oldest;
+
+        uint32_t start = query->from + query->bucket * query->step;
+        uint32_t end = (query->bucket + 1 == query->points) ? query->to + 1 : start + query->step;
+        uint32_t saved_cursor = query->cursor;
+        size_t mark = buf_mark(&w);
+        if (query_write_bucket(query, &w, start, end)) {
+            if (w.overflow) {
+                // Não coube: desfaz e continua no próximo trecho
+                query->cursor = saved_cursor;
+                buf_rewind(&w, mark);
+                return w.len;
+            }
+            query->first = false;
+        }
+        query->bucket++;
+    }
+
+    if (query->stage == 2) {
+        size_t mark = buf_mark(&w);
+        buf_printf(&w, "]}");
+        if (w.overflow) {
+            buf_rewind(&w, mark);
+            return w.len;
+        }
+        query->stage = 3;
+    }
+    *done = query->stage == 3;
+    return w.len;
+}
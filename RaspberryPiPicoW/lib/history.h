@@ -0,0 +1,77 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "sensors.h"
+#include "buf_writer.h"
+
+// Orçamento de RAM (valores padrão): 600 amostras × 28 B = 16,8 KB em taxa cheia,
+// 600 agregados de 1 s × 36 B = 21,6 KB e 720 agregados de 1 min × 36 B = 25,9 KB,
+// ~64 KB no total ao lado do heap do lwIP, dos buffers do TLS e do log. Agregados
+// de 1 s custam ~130 KB por hora, então as horas vêm do anel de 1 min.
+#ifndef HISTORY_RAW_LEN
+#define HISTORY_RAW_LEN 600 // Amostras em taxa cheia (5 min a 500 ms)
+#endif
+
+#ifndef HISTORY_AGG_LEN
+#define HISTORY_AGG_LEN 600 // Agregados de 1 s (10 min)
+#endif
+
+#ifndef HISTORY_SLOW_LEN
+#define HISTORY_SLOW_LEN 720 // Agregados de 1 min (12 h)
+#endif
+
+#define HISTORY_AGG_PERIOD_MS 1000 // Período de cada agregado do anel de 1 s
+#define HISTORY_SLOW_PERIOD_MS 60000 // Período de cada agregado do anel de 1 min
+#define HISTORY_AGG_CHANNELS 5 // Canais agregados (temperatura, umidade, altitude, giroscópio e aceleração)
+#define HISTORY_DEFAULT_POINTS 100 // Pontos retornados quando a consulta não informa "points"
+#define HISTORY_MAX_POINTS 1000 // Limite de pontos por consulta
+
+// Anel lido por uma consulta, do mais fino ao mais grosso
+typedef enum {
+    HISTORY_SOURCE_RAW = 0, // Taxa cheia
+    HISTORY_SOURCE_AGG, // Agregados de 1 s
+    HISTORY_SOURCE_SLOW, // Agregados de 1 min
+    HISTORY_SOURCE_COUNT
+} history_source_t;
+
+// Amostra em taxa cheia, com os canais em ponto fixo
+typedef struct {
+    uint32_t t_ms; // Instante da amostra (ms desde o boot)
+    int16_t value[SENSOR_CH_COUNT]; // Valores escalados por HISTORY_SCALE
+} history_sample_t;
+
+// Agregado de um período de HISTORY_AGG_PERIOD_MS
+typedef struct {
+    uint32_t t_ms; // Início do período
+    int16_t min[HISTORY_AGG_CHANNELS];
+    int16_t max[HISTORY_AGG_CHANNELS];
+    int16_t mean[HISTORY_AGG_CHANNELS];
+} history_agg_t;
+
+// Estado de uma consulta em andamento (gerada aos pedaços)
+typedef struct {
+    uint32_t from, to; // Intervalo consultado (ms desde o boot)
+    uint32_t step; // Largura de cada ponto (ms)
+    uint32_t points; // Quantidade de pontos pedida
+    uint32_t bucket; // Próximo ponto a ser gerado
+    uint32_t cursor; // Sequência da próxima entrada a ser lida do anel
+    uint8_t source; // history_source_t
+    bool first; // Ainda não escreveu nenhum ponto
+    uint8_t stage; // 0: cabeçalho, 1: pontos, 2: rodapé, 3: fim
+} history_query_t;
+
+void history_push(const SensorReadings *readings, uint32_t t_ms); // Adiciona uma amostra ao histórico
+uint32_t history_count(void); // Quantidade de amostras em taxa cheia armazenadas
+bool history_latest(history_sample_t *sample); // Obtém a amostra mais recente
+uint32_t history_recent(sensor_channel_t channel, int16_t *values, uint32_t count); // Copia os últimos valores de um canal
+bool history_extremes(sensor_channel_t channel, int16_t *min, int16_t *max); // Menor e maior valor de um canal desde o boot
+int16_t history_from_float(sensor_channel_t channel, float value); // Converte um valor para o formato armazenado
+float history_to_float(sensor_channel_t channel, int16_t value); // Converte um valor armazenado para a unidade do canal
+void history_query_begin(history_query_t *query, int64_t from, int64_t to, uint32_t points); // Inicia uma consulta
+size_t history_query_read(history_query_t *query, char *buf, size_t size, bool *done); // Gera o próximo trecho do JSON
+
+#endif
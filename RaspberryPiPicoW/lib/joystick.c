@@ -4,9 +4,7 @@
  * @brief Inicializa o joystick
  */
 void joystick_init(void){
-    adc_init();
-    adc_gpio_init(JOYSTICK_X_PIN);
-    adc_gpio_init(JOYSTICK_Y_PIN);
+    analog_init(); // Os eixos são amostrados continuamente pelo ADC em rodízio
 }
 
 /**
@@ -14,8 +12,7 @@ void joystick_init(void){
  * @return Valor do eixo x
  */
 uint joystick_read_x(void){
-    adc_select_input(1);
-    return adc_read();
+    return analog_latest(ANALOG_JOYSTICK_X); // Sem esperar a conversão
 }
 
 /**
@@ -23,8 +20,7 @@ uint joystick_read_x(void){
  * @return Valor do eixo y
  */
 uint joystick_read_y(void){
-    adc_select_input(0);
-    return adc_read();
+    return analog_latest(ANALOG_JOYSTICK_Y); // Sem esperar a conversão
 }
 
 /**
@@ -5,9 +5,10 @@
 #include "pico/stdio.h"
 #include "pico/stdlib.h"
 #include "hardware/adc.h"
+#include "analog.h"
 
-#define JOYSTICK_X_PIN 26 // Define o pino do eixo x do joystick
-#define JOYSTICK_Y_PIN 27 // Define o pino do eixo y do joystick
+#define JOYSTICK_X_PIN ANALOG_JOYSTICK_X_PIN // Define o pino do eixo x do joystick
+#define JOYSTICK_Y_PIN ANALOG_JOYSTICK_Y_PIN // Define o pino do eixo y do joystick
 #define JOYSTICK_UP_THRESHOLD 3000 // Define o limite para o movimento para cima
 #define JOYSTICK_DOWN_THRESHOLD 1000 // Define o limite para o movimento para baixo
 
@@ -90,4 +90,16 @@ void black(void){
     gpio_put(LED_RED_PIN, 0);
     gpio_put(LED_GREEN_PIN, 0);
     gpio_put(LED_BLUE_PIN, 0);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Acende uma cor do LED RGB
+ * @param color Cor (LED_OFF apaga, LED_KEEP não altera nada)
+ */
+void led_set(led_color_t color){
+    if (color == LED_KEEP)
+        return;
+    gpio_put(LED_RED_PIN, (color & LED_RED) != 0);
+    gpio_put(LED_GREEN_PIN, (color & LED_GREEN) != 0);
+    gpio_put(LED_BLUE_PIN, (color & LED_BLUE) != 0);
+}
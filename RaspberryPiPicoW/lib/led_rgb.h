@@ -10,6 +10,19 @@
 #define LED_BLUE_PIN 12 // Define o pino do LED azul
 #define LED_RED_PIN 13 // Define o pino do LED vermelho
 
+// Cores do LED RGB: bit 0 vermelho, bit 1 verde, bit 2 azul
+typedef enum {
+    LED_KEEP = 0, // Mantém a cor atual (usado nas sequências do buzzer)
+    LED_RED = 1,
+    LED_GREEN = 2,
+    LED_YELLOW = 3,
+    LED_BLUE = 4,
+    LED_MAGENTA = 5,
+    LED_CYAN = 6,
+    LED_WHITE = 7,
+    LED_OFF = 8 // Apaga o LED
+} led_color_t;
+
 void led_init(uint led_pin); // Inicializa o LED
 void led_init_all(); // Inicializa todos os LEDs
 void red(); // Acende o LED vermelho
@@ -20,5 +33,6 @@ void cyan(); //Combinação de verde e azul
 void magenta(); //Combinação de vermelho e azul
 void white(); //Combinação de vermelho, verde e azul
 void black(); // Apaga todos os LEDs
+void led_set(led_color_t color); // Acende uma cor (LED_KEEP não altera nada)
 
 #endif
\ No newline at end of file
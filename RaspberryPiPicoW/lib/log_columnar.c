@@ -0,0 +1,516 @@
+#include "log_columnar.h"
+#include "log_writer.h"
+#include "history.h"
+#include "metrics.h"
+#include "f_util.h"
+
+#if LOG_COLUMNAR
+
+// Bloco em montagem de um canal
+typedef struct {
+    uint8_t block[LOG_COL_BLOCK_SIZE] __attribute__((aligned(4)));
+    uint16_t len; // Bytes codificados
+    uint32_t first_ms; // Instante da primeira amostra (ms desde o boot)
+    uint32_t prev_ms; // Instante da amostra anterior (ms desde o boot)
+    int32_t prev_dt; // Intervalo anterior (ms)
+    int16_t prev; // Valor da amostra anterior
+    uint16_t phase_lo, phase_hi; // Fases do RTC (ms) compatíveis com todas as amostras do bloco
+} log_col_chan_t;
+
+static log_col_chan_t chans[SENSOR_CH_COUNT];
+static int col_day = -1; // Dia (tm_yday) das amostras nos blocos em montagem
+static FIL col_file; // Escrita dos blocos
+static FIL col_dir_file; // Escrita dos cabeçalhos
+static FIL query_file; // Leitura dos blocos na consulta (contexto do lwIP; aberto só durante um passo)
+static FIL query_dir; // Leitura dos cabeçalhos na consulta (idem: a gravação dos blocos abre os mesmos arquivos)
+static uint8_t query_block[LOG_COL_BLOCK_SIZE] __attribute__((aligned(4)));
+static log_col_header_t query_headers[LOG_SECTOR_SIZE / sizeof(log_col_header_t)];
+
+/**
+ * @brief Monta o caminho do arquivo colunar (ou do diretório de cabeçalhos) de um dia
+ * @param path Buffer de saída
+ * @param size Tamanho do buffer
+ * @param t Instante dentro do dia (s, RTC)
+ * @param ext LOG_COL_EXT ou LOG_COL_DIR_EXT
+ */
+static void log_col_path(char *path, size_t size, uint32_t t, const char *ext) {
+    time_t tt = t;
+    struct tm *tm = localtime(&tt);
+    snprintf(path, size, "%s/%04d%02d%02d%s", LOG_DIR, tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, ext);
+}
+
+/**
+ * @brief Grava um bloco no fim do arquivo do dia e seu cabeçalho no diretório. Antes, alinha os dois
+ * arquivos: corta um bloco incompleto (queda durante a gravação) e completa ou corta o diretório
+ * para que o cabeçalho i corresponda sempre ao bloco i
+ * @param block Bloco fechado
+ * @return true se o bloco e o cabeçalho foram gravados
+ */
+static bool log_col_store(const uint8_t *block) {
+    const log_col_header_t *header = (const log_col_header_t *)block;
+    char col_path[sizeof(LOG_DIR) + LOG_NAME_MAX];
+    char dir_path[sizeof(LOG_DIR) + LOG_NAME_MAX];
+    log_col_path(col_path, sizeof(col_path), header->t_first, LOG_COL_EXT);
+    log_col_path(dir_path, sizeof(dir_path), header->t_first, LOG_COL_DIR_EXT);
+
+    FRESULT fr = f_open(&col_file, col_path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("f_open(%s) error: %s (%d)\n", col_path, FRESULT_str(fr), fr);
+        return false;
+    }
+    fr = f_open(&col_dir_file, dir_path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK) {
+        printf("f_open(%s) error: %s (%d)\n", dir_path, FRESULT_str(fr), fr);
+        f_close(&col_file);
+        return false;
+    }
+
+    uint32_t blocks = f_size(&col_file) / LOG_COL_BLOCK_SIZE;
+    uint32_t entries = f_size(&col_dir_file) / sizeof(log_col_header_t);
+    if (f_size(&col_file) % LOG_COL_BLOCK_SIZE) {
+        f_lseek(&col_file, (FSIZE_t)blocks * LOG_COL_BLOCK_SIZE);
+        fr = f_truncate(&col_file);
+    }
+    if (fr == FR_OK && (entries > blocks || f_size(&col_dir_file) % sizeof(log_col_header_t))) {
+        if (entries > blocks)
+            entries = blocks;
+        f_lseek(&col_dir_file, (FSIZE_t)entries * sizeof(log_col_header_t));
+        fr = f_truncate(&col_dir_file);
+    }
+    UINT bw = 0, br = 0;
+    log_col_header_t missing;
+    while (fr == FR_OK && entries < blocks) {
+        fr = f_lseek(&col_file, (FSIZE_t)entries * LOG_COL_BLOCK_SIZE);
+        if (fr == FR_OK)
+            fr = f_read(&col_file, &missing, sizeof(missing), &br);
+        if (fr == FR_OK)
+            fr = f_lseek(&col_dir_file, (FSIZE_t)entries * sizeof(missing));
+        if (fr == FR_OK)
+            fr = f_write(&col_dir_file, &missing, sizeof(missing), &bw);
+        entries++;
+    }
+
+    // Bloco primeiro: um cabeçalho no diretório sempre aponta para um bloco gravado
+    if (fr == FR_OK)
+        fr = f_lseek(&col_file, (FSIZE_t)blocks * LOG_COL_BLOCK_SIZE);
+    if (fr == FR_OK)
+        fr = f_write(&col_file, block, LOG_COL_BLOCK_SIZE, &bw);
+    if (fr == FR_OK && bw == LOG_COL_BLOCK_SIZE)
+        fr = f_sync(&col_file);
+    if (fr == FR_OK)
+        fr = f_lseek(&col_dir_file, (FSIZE_t)blocks * sizeof(log_col_header_t));
+    if (fr == FR_OK)
+        fr = f_write(&col_dir_file, header, sizeof(*header), &bw);
+    FRESULT fr_close = f_close(&col_dir_file);
+    if (fr == FR_OK)
+        fr = fr_close;
+    fr_close = f_close(&col_file);
+    if (fr == FR_OK)
+        fr = fr_close;
+    if (fr != FR_OK) {
+        printf("f_write(%s) error: %s (%d)\n", col_path, FRESULT_str(fr), fr);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Fecha o bloco de um canal (CRCs e zeros no espaço livre) e o grava no arquivo do dia
+ * @param chan Canal
+ */
+static void log_col_write_block(log_col_chan_t *chan) {
+    log_col_header_t *header = (log_col_header_t *)chan->block;
+    uint8_t *payload = chan->block + sizeof(log_col_header_t);
+    if (header->count == 0)
+        return;
+
+    header->payload_len = chan->len;
+    header->t_phase_ms = chan->phase_lo;
+    memset(payload + chan->len, 0, LOG_COL_PAYLOAD_SIZE - chan->len);
+    header->payload_crc = log_crc32(payload, chan->len);
+    header->header_crc = log_crc32(header, offsetof(log_col_header_t, header_crc));
+
+    if (log_col_store(chan->block)) {
+        metrics_add(&metrics.log_col_blocks, 1);
+        metrics_add(&metrics.log_col_samples, header->count);
+        metrics_add(&metrics.log_col_payload_bytes, chan->len);
+    } else {
+        metrics_add(&metrics.log_write_errors, 1);
+    }
+    header->count = 0;
+    chan->len = 0;
+}
+
+/**
+ * @brief Codifica um inteiro sem sinal em varint (7 bits por byte, menos significativos primeiro)
+ * @return Bytes escritos
+ */
+static size_t log_col_put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * @brief Mapeia um inteiro com sinal em um sem sinal pequeno em módulo (0, -1, 1, -2...)
+ */
+static inline uint32_t log_col_zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+/**
+ * @brief Inverso de log_col_zigzag
+ */
+static inline int32_t log_col_unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * @brief Decodifica um varint
+ * @return Bytes lidos (0 se o varint passa do fim dos dados)
+ */
+static size_t log_col_get_varint(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+    uint32_t value = 0;
+    for (size_t n = 0; n < 5 && p + n < end; n++) {
+        value |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80)) {
+            *v = value;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Acrescenta uma amostra de cada canal aos blocos em montagem, gravando os blocos que encherem
+ * @param t Instante da amostra (s, RTC)
+ * @param t_ms Instante da amostra (ms desde o boot)
+ * @param value Valores escalados como no histórico
+ */
+void log_col_append(uint32_t t, uint32_t t_ms, const int16_t *value) {
+    // Blocos não atravessam a meia-noite: cada arquivo guarda só blocos do seu dia
+    time_t tt = t;
+    int day = localtime(&tt)->tm_yday;
+    if (day != col_day)
+        log_col_flush();
+    col_day = day;
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        log_col_chan_t *chan = &chans[ch];
+        log_col_header_t *header = (log_col_header_t *)chan->block;
+        uint8_t *payload = chan->block + sizeof(log_col_header_t);
+        int16_t v = value[ch];
+
+        if (header->count == 0) {
+            memset(header, 0, sizeof(*header));
+            header->magic = LOG_COL_MAGIC;
+            header->channel = ch;
+            header->version = LOG_COL_VERSION;
+            header->t_first = t;
+            header->min = v;
+            header->max = v;
+            chan->first_ms = t_ms;
+            chan->prev_ms = t_ms;
+            chan->prev_dt = 0;
+            chan->prev = 0;
+            chan->phase_lo = 0;
+            chan->phase_hi = 999;
+        }
+
+        // O RTC só dá segundos inteiros: cada amostra restringe a fração de segundo da primeira,
+        // para que a consulta atribua as amostras de borda ao segundo em que foram gravadas
+        int32_t lo = (int32_t)(t - header->t_first) * 1000 - (int32_t)(t_ms - chan->first_ms);
+        if (lo > chan->phase_lo && lo <= chan->phase_hi)
+            chan->phase_lo = lo;
+        if (lo + 999 < chan->phase_hi && lo + 999 >= chan->phase_lo)
+            chan->phase_hi = lo + 999;
+
+        // Com a amostragem periódica, a variação do intervalo e a do valor cabem quase sempre em um byte cada
+        int32_t dt = (int32_t)(t_ms - chan->prev_ms);
+        chan->len += log_col_put_varint(payload + chan->len, log_col_zigzag(dt - chan->prev_dt));
+        chan->len += log_col_put_varint(payload + chan->len, log_col_zigzag((int32_t)v - chan->prev));
+        chan->prev_ms = t_ms;
+        chan->prev_dt = dt;
+        chan->prev = v;
+
+        header->count++;
+        header->t_last = t;
+        header->sum += v;
+        if (v < header->min) header->min = v;
+        if (v > header->max) header->max = v;
+
+        if (chan->len + LOG_COL_SAMPLE_MAX > LOG_COL_PAYLOAD_SIZE || header->count == UINT16_MAX)
+            log_col_write_block(chan);
+    }
+}
+
+/**
+ * @brief Grava os blocos parciais de todos os canais (troca de dia)
+ */
+void log_col_flush(void) {
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        log_col_write_block(&chans[ch]);
+}
+
+/**
+ * @brief Verifica o CRC de um cabeçalho
+ */
+static bool log_col_header_valid(const log_col_header_t *header) {
+    return header->magic == LOG_COL_MAGIC && header->version >= 1 && header->version <= LOG_COL_VERSION &&
+           header->payload_len <= LOG_COL_PAYLOAD_SIZE &&
+           header->header_crc == log_crc32(header, offsetof(log_col_header_t, header_crc));
+}
+
+/**
+ * @brief Acumula amostras (uma ou o resumo de um bloco) no resultado da consulta
+ */
+static void log_col_query_add(log_col_query_t *query, int16_t min, int16_t max, uint32_t count, int64_t sum) {
+    if (query->count == 0 || min < query->min) query->min = min;
+    if (query->count == 0 || max > query->max) query->max = max;
+    query->count += count;
+    query->sum += sum;
+}
+
+/**
+ * @brief Decodifica um bloco que cruza a borda do intervalo e acumula as amostras dentro dele
+ * @param query Consulta
+ * @param col Arquivo colunar aberto
+ * @param index Posição do bloco no arquivo
+ */
+static void log_col_query_decode(log_col_query_t *query, FIL *col, uint32_t index) {
+    UINT br = 0;
+    if (f_lseek(col, (FSIZE_t)index * LOG_COL_BLOCK_SIZE) != FR_OK ||
+        f_read(col, query_block, LOG_COL_BLOCK_SIZE, &br) != FR_OK || br != LOG_COL_BLOCK_SIZE)
+        return;
+    const log_col_header_t *header = (const log_col_header_t *)query_block;
+    const uint8_t *p = query_block + sizeof(log_col_header_t);
+    if (!log_col_header_valid(header) || header->payload_crc != log_crc32(p, header->payload_len))
+        return;
+    query->blocks_decoded++;
+
+    const uint8_t *end = p + header->payload_len;
+    uint32_t elapsed_ms = header->t_phase_ms;
+    int32_t dt = 0;
+    int16_t v = 0;
+    for (uint16_t i = 0; i < header->count; i++) {
+        uint32_t zt, zz;
+        size_t n = log_col_get_varint(p, end, &zt);
+        size_t m = n ? log_col_get_varint(p + n, end, &zz) : 0;
+        if (!m)
+            break;
+        p += n + m;
+        dt = header->version == 1 ? (int32_t)zt : dt + log_col_unzigzag(zt);
+        elapsed_ms += dt;
+        v += (int16_t)log_col_unzigzag(zz);
+        uint32_t t = header->t_first + elapsed_ms / 1000;
+        if (t >= query->from && t <= query->to)
+            log_col_query_add(query, v, v, 1, v);
+    }
+}
+
+/**
+ * @brief Continua a varredura dos cabeçalhos do dia em exame, do cabeçalho query->index em diante
+ * @param query Consulta
+ * @param budget Setores que ainda podem ser lidos neste passo
+ * @return Setores lidos (cabeçalhos e blocos de borda)
+ */
+static uint32_t log_col_query_scan(log_col_query_t *query, uint32_t budget) {
+    char path[sizeof(LOG_DIR) + LOG_NAME_MAX + sizeof(LOG_COL_DIR_EXT)];
+    snprintf(path, sizeof(path), "%s/%s", LOG_DIR, query->name);
+    size_t base_len = strlen(path) - strlen(LOG_COL_EXT);
+    snprintf(path + base_len, sizeof(path) - base_len, "%s", LOG_COL_DIR_EXT);
+    if (f_open(&query_dir, path, FA_READ) != FR_OK ||
+        f_lseek(&query_dir, (FSIZE_t)query->index * sizeof(log_col_header_t)) != FR_OK) {
+        query->name[0] = 0;
+        return 1;
+    }
+    if (query->index == 0)
+        query->files++;
+
+    bool col_open = false;
+    DWORD col_cltbl[LOG_FASTSEEK_MAP];
+    uint32_t used = 0;
+    UINT br = 0;
+    // Os cabeçalhos são lidos em sequência, vários por setor; o .col só é aberto para blocos de borda
+    while (used < budget) {
+        if (f_read(&query_dir, query_headers, sizeof(query_headers), &br) != FR_OK || br < sizeof(log_col_header_t)) {
+            query->name[0] = 0; // Fim do dia
+            break;
+        }
+        used++;
+        // O setor lido é processado inteiro; os blocos de borda (no máximo um por extremo do intervalo
+        // e por dia) podem passar um pouco do orçamento
+        for (UINT i = 0; i < br / sizeof(log_col_header_t); i++, query->index++) {
+            const log_col_header_t *h = &query_headers[i];
+            if (!log_col_header_valid(h) || h->channel != query->channel || h->t_last < query->from ||
+                h->t_first > query->to) {
+                query->blocks_skipped++;
+            } else if (h->t_first >= query->from && h->t_last <= query->to) {
+                query->blocks_summary++;
+                log_col_query_add(query, h->min, h->max, h->count, h->sum);
+            } else {
+                if (!col_open) {
+                    snprintf(path + base_len, sizeof(path) - base_len, "%s", LOG_COL_EXT);
+                    col_open = f_open(&query_file, path, FA_READ) == FR_OK;
+                    if (col_open)
+                        log_fastseek(&query_file, col_cltbl, LOG_FASTSEEK_MAP);
+                }
+                if (col_open)
+                    log_col_query_decode(query, &query_file, query->index);
+                used += LOG_COL_BLOCK_SIZE / LOG_SECTOR_SIZE;
+            }
+        }
+    }
+    if (col_open)
+        f_close(&query_file);
+    f_close(&query_dir);
+    return used;
+}
+
+/**
+ * @brief Procura em LOG_DIR o próximo dia colunar que pode ter amostras no intervalo
+ * @param query Consulta
+ * @return false se não há mais dias a examinar
+ */
+static bool log_col_query_next_file(log_col_query_t *query) {
+    FILINFO fno;
+    size_t ext_len = strlen(LOG_COL_EXT);
+    while (query->files < LOG_COL_QUERY_FILES_MAX && f_readdir(&query->dir, &fno) == FR_OK && fno.fname[0] != 0) {
+        size_t name_len = strlen(fno.fname);
+        int y, m, d;
+        if ((fno.fattrib & AM_DIR) || name_len != 8 + ext_len || strcmp(fno.fname + 8, LOG_COL_EXT) != 0 ||
+            sscanf(fno.fname, "%4d%2d%2d", &y, &m, &d) != 3)
+            continue;
+        // Dias inteiros fora do intervalo são descartados pelo nome
+        struct tm tm = {.tm_year = y - 1900, .tm_mon = m - 1, .tm_mday = d, .tm_isdst = -1};
+        int64_t day_start = mktime(&tm);
+        if (day_start > query->to || day_start + 24 * 3600 <= query->from)
+            continue;
+        snprintf(query->name, sizeof(query->name), "%s", fno.fname);
+        query->index = 0;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Prepara uma consulta agregada (contagem, mínimo, máximo e média) de um canal; a varredura
+ * é feita aos poucos por log_col_query_step
+ * @param query Consulta
+ * @param channel Canal (sensor_channel_t)
+ * @param from Início do intervalo (s, RTC); negativo: relativo ao instante atual
+ * @param to Fim do intervalo (s, RTC); zero ou negativo: relativo ao instante atual
+ * @return false se o canal é inválido
+ */
+bool log_col_query_begin(log_col_query_t *query, int channel, int64_t from, int64_t to) {
+    if (channel < 0 || channel >= SENSOR_CH_COUNT)
+        return false;
+    int64_t now = time(NULL);
+    if (from < 0) from += now;
+    if (to <= 0) to += now;
+    if (from < 0) from = 0;
+    if (to < from) to = from;
+
+    memset(query, 0, sizeof(*query));
+    query->channel = channel;
+    query->from = (uint32_t)from;
+    query->to = (uint32_t)to;
+    query->dir_open = f_opendir(&query->dir, LOG_DIR) == FR_OK;
+    query->finished = !query->dir_open;
+    return true;
+}
+
+/**
+ * @brief Avança a varredura da consulta lendo no máximo LOG_COL_QUERY_STEP_SECTORS setores, para não
+ * segurar o contexto do lwIP (e a aquisição) durante uma consulta de vários dias
+ * @param query Consulta
+ * @return true quando a varredura terminou e o resultado está pronto
+ */
+bool log_col_query_step(log_col_query_t *query) {
+    if (query->finished)
+        return true;
+    uint64_t start = time_us_64();
+    uint32_t used = 0;
+    while (used < LOG_COL_QUERY_STEP_SECTORS) {
+        if (!query->name[0] && !log_col_query_next_file(query)) {
+            query->finished = true;
+            break;
+        }
+        used += log_col_query_scan(query, LOG_COL_QUERY_STEP_SECTORS - used);
+    }
+    query->steps++;
+    query->elapsed_us += (uint32_t)(time_us_64() - start);
+    if (query->finished) {
+        log_col_query_end(query);
+        metrics_observe(&metrics.log_query_latency, query->elapsed_us);
+        metrics_add(&metrics.log_col_blocks_skipped, query->blocks_skipped);
+        metrics_add(&metrics.log_col_blocks_summary, query->blocks_summary);
+        metrics_add(&metrics.log_col_blocks_decoded, query->blocks_decoded);
+    }
+    return query->finished;
+}
+
+/**
+ * @brief Libera a consulta (fecha o diretório se a varredura não terminou)
+ * @param query Consulta
+ */
+void log_col_query_end(log_col_query_t *query) {
+    if (query->dir_open)
+        f_closedir(&query->dir);
+    query->dir_open = false;
+}
+
+#else
+
+void log_col_append(uint32_t t, uint32_t t_ms, const int16_t *value) {}
+void log_col_flush(void) {}
+
+bool log_col_query_begin(log_col_query_t *query, int channel, int64_t from, int64_t to) {
+    return false;
+}
+
+bool log_col_query_step(log_col_query_t *query) {
+    return true;
+}
+
+void log_col_query_end(log_col_query_t *query) {}
+
+#endif
+
+/**
+ * @brief Gera o JSON com o resultado da consulta
+ * @param query Consulta executada
+ * @param buf Buffer de saída
+ * @param size Tamanho do buffer
+ * @param done Indica que o resultado foi todo gerado
+ * @return Quantidade de bytes escritos
+ */
+size_t log_col_query_read(log_col_query_t *query, char *buf, size_t size, bool *done) {
+    buf_writer_t w = {.buf = buf, .size = size};
+    // Um passo da varredura por chamada; o JSON só sai quando ela termina
+    *done = log_col_query_step(query);
+    if (!*done)
+        return 0;
+    if (query->sent)
+        return 0;
+    query->sent = true;
+
+    sensor_channel_t ch = (sensor_channel_t)query->channel;
+    buf_printf(&w, "{\"channel\":\"%s\",\"from\":%lu,\"to\":%lu,\"count\":%lu,", SENSOR_CHANNEL_NAMES[ch],
+               (unsigned long)query->from, (unsigned long)query->to, (unsigned long)query->count);
+    if (query->count)
+        buf_printf(&w, "\"min\":%.3f,\"max\":%.3f,\"avg\":%.3f,", history_to_float(ch, query->min),
+                   history_to_float(ch, query->max), history_to_float(ch, 1) * ((double)query->sum / query->count));
+    else
+        buf_printf(&w, "\"min\":null,\"max\":null,\"avg\":null,");
+    buf_printf(&w, "\"files\":%lu,\"blocks\":{\"skipped\":%lu,\"summary\":%lu,\"decoded\":%lu},\"steps\":%lu,"
+               "\"elapsed_us\":%lu}",
+               (unsigned long)query->files, (unsigned long)query->blocks_skipped,
+               (unsigned long)query->blocks_summary, (unsigned long)query->blocks_decoded,
+               (unsigned long)query->steps, (unsigned long)query->elapsed_us);
+    return w.len;
+}
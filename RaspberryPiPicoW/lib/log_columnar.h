@@ -0,0 +1,80 @@
+#ifndef LOG_COLUMNAR_H
+#define LOG_COLUMNAR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+
+#include "ff.h"
+#include "sensors.h"
+#include "log_store.h"
+#include "buf_writer.h"
+
+#ifndef LOG_COLUMNAR
+#define LOG_COLUMNAR 0 // 1: grava também o formato colunar (blocos por canal) usado nas consultas agregadas
+#endif
+
+#define LOG_COL_EXT ".col" // Blocos colunares do dia (AAAAMMDD.col)
+#define LOG_COL_DIR_EXT ".cdx" // Cópia dos cabeçalhos dos blocos, na mesma ordem (consulta sem ler os blocos)
+#define LOG_COL_BLOCK_SIZE 4096 // Tamanho de cada bloco, cabeçalho incluso
+#define LOG_COL_MAGIC 0x4B4C4243 // "CBLK"
+#define LOG_COL_VERSION 2 // 1: Δt em ms direto e fase zero (ainda lida nas consultas)
+#define LOG_COL_SAMPLE_MAX 8 // Maior amostra codificada: varint da variação de Δt (até 5 bytes) + varint de Δvalor (até 3)
+#define LOG_COL_QUERY_FILES_MAX 62 // Arquivos (dias) examinados por consulta
+#define LOG_COL_QUERY_STEP_SECTORS 8 // Setores lidos por passo da varredura (um passo por chamada no lwIP)
+
+// Cabeçalho de um bloco: basta ele para descartar o bloco ou usar seu resumo numa consulta
+typedef struct __attribute__((packed)) {
+    uint32_t magic; // LOG_COL_MAGIC
+    uint8_t channel; // Canal (sensor_channel_t)
+    uint8_t version; // LOG_COL_VERSION
+    uint16_t count; // Amostras no bloco
+    uint32_t t_first; // Instante da primeira amostra (s, RTC)
+    uint32_t t_last; // Instante da última amostra (s, RTC)
+    int32_t sum; // Soma dos valores (escalados como no histórico)
+    int16_t min; // Menor valor
+    int16_t max; // Maior valor
+    uint16_t payload_len; // Bytes codificados após o cabeçalho
+    uint16_t t_phase_ms; // Milissegundos do segundo do RTC na primeira amostra
+    uint32_t payload_crc; // CRC32 dos bytes codificados
+    uint32_t header_crc; // CRC32 dos campos anteriores
+} log_col_header_t;
+
+// Cada amostra: varint(zigzag(Δt - Δt anterior)), em ms, seguido de varint(zigzag(Δvalor)); a primeira é
+// relativa a (t_first, 0). A amostra fica no segundo t_first + (ms desde a primeira + t_phase_ms) / 1000
+#define LOG_COL_PAYLOAD_SIZE (LOG_COL_BLOCK_SIZE - sizeof(log_col_header_t))
+
+// Consulta agregada de um canal em um intervalo
+typedef struct {
+    uint8_t channel; // Canal consultado
+    uint32_t from; // Início do intervalo (s, RTC)
+    uint32_t to; // Fim do intervalo (s, RTC)
+    uint32_t count; // Amostras no intervalo
+    int16_t min; // Menor valor
+    int16_t max; // Maior valor
+    int64_t sum; // Soma dos valores
+    uint32_t files; // Dias examinados
+    uint32_t blocks_skipped; // Blocos descartados pelo cabeçalho (outro canal ou fora do intervalo)
+    uint32_t blocks_summary; // Blocos inteiros no intervalo: só o resumo do cabeçalho foi usado
+    uint32_t blocks_decoded; // Blocos na borda do intervalo, decodificados amostra a amostra
+    uint32_t steps; // Passos da varredura
+    uint32_t elapsed_us; // Duração da consulta (soma dos passos)
+    DIR dir; // LOG_DIR, aberto enquanto a varredura não termina
+    bool dir_open;
+    char name[FF_SFN_BUF + 1]; // Dia em exame (AAAAMMDD.col; vazio: procurar o próximo)
+    uint32_t index; // Próximo cabeçalho do dia em exame
+    bool finished; // Varredura concluída
+    bool sent; // Resultado já gerado
+} log_col_query_t;
+
+void log_col_append(uint32_t t, uint32_t t_ms, const int16_t *value); // Acrescenta uma amostra de cada canal
+void log_col_flush(void); // Grava os blocos parciais de todos os canais
+bool log_col_query_begin(log_col_query_t *query, int channel, int64_t from, int64_t to); // Prepara uma consulta agregada
+bool log_col_query_step(log_col_query_t *query); // Avança a varredura; true quando o resultado está pronto
+void log_col_query_end(log_col_query_t *query); // Libera a consulta
+size_t log_col_query_read(log_col_query_t *query, char *buf, size_t size, bool *done); // Gera o JSON do resultado
+
+#endif
@@ -0,0 +1,256 @@
+#include "log_store.h"
+#include "f_util.h"
+
+/**
+ * @brief Verifica se o nome pode ser usado dentro de LOG_DIR
+ * @param name Nome do log
+ * @return true se o nome não tem separadores nem referências ao diretório pai
+ */
+bool log_valid_name(const char *name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= LOG_NAME_MAX || name[0] == '.')
+        return false;
+    for (size_t i = 0; i < len; i++) {
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':' || name[i] < ' ')
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Ativa o fast seek: f_lseek e f_read passam a consultar o mapa de clusters em RAM
+ * @param file Arquivo aberto para leitura
+ * @param tbl Tabela para o mapa de clusters
+ * @param size Itens da tabela
+ * @return true se o mapa coube na tabela (senão o arquivo segue com a busca pela FAT)
+ */
+bool log_fastseek(FIL *file, DWORD *tbl, UINT size) {
+    tbl[0] = size;
+    file->cltbl = tbl;
+    if (f_lseek(file, CREATE_LINKMAP) != FR_OK) {
+        file->cltbl = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Inicia a listagem dos logs
+ * @param list Estado da listagem
+ */
+void log_list_begin(log_list_t *list) {
+    memset(list, 0, sizeof(*list));
+    list->first = true;
+    list->open = f_opendir(&list->dir, LOG_DIR) == FR_OK;
+}
+
+/**
+ * @brief Gera o próximo trecho do JSON com a lista de logs
+ * @param list Estado da listagem
+ * @param buf Buffer de saída
+ * @param size Tamanho do buffer
+ * @param done Indica que a listagem terminou
+ * @return Quantidade de bytes escritos
+ */
+size_t log_list_read(log_list_t *list, char *buf, size_t size, bool *done) {
+    buf_writer_t w = {.buf = buf, .size = size};
+    *done = false;
+
+    if (list->stage == 0) {
+        buf_printf(&w, "{\"dir\":\"%s\",\"files\":[", LOG_DIR);
+        list->stage = list->open ? 1 : 2;
+    }
+
+    while (list->stage == 1) {
+        // Item que não coube no trecho anterior é reaproveitado
+        if (!list->pending) {
+            if (f_readdir(&list->dir, &list->fno) != FR_OK || list->fno.fname[0] == 0) {
+                list->stage = 2;
+                break;
+            }
+            size_t name_len = strlen(list->fno.fname);
+            size_t ext_len = strlen(LOG_INDEX_EXT);
+            if ((list->fno.fattrib & AM_DIR) ||
+                (name_len > ext_len && strcmp(list->fno.fname + name_len - ext_len, LOG_INDEX_EXT) == 0))
+                continue;
+        }
+
+        size_t mark = buf_mark(&w);
+        buf_printf(&w, "%s{\"name\":\"%s\",\"size\":%llu}", list->first ? "" : ",", list->fno.fname,
+                   (unsigned long long)list->fno.fsize);
+        if (w.overflow) {
+            buf_rewind(&w, mark);
+            list->pending = true;
+            return w.len;
+        }
+        list->pending = false;
+        list->first = false;
+    }
+
+    if (list->stage == 2) {
+        size_t mark = buf_mark(&w);
+        buf_printf(&w, "]}");
+        if (w.overflow) {
+            buf_rewind(&w, mark);
+            return w.len;
+        }
+        log_list_end(list);
+        list->stage = 3;
+    }
+    *done = list->stage == 3;
+    return w.len;
+}
+
+/**
+ * @brief Libera a listagem
+ * @param list Estado da listagem
+ */
+void log_list_end(log_list_t *list) {
+    if (list->open)
+        f_closedir(&list->dir);
+    list->open = false;
+}
+
+/**
+ * @brief Busca no índice esparso a primeira entrada com instante acima do limite
+ * @param idx Arquivo de índice aberto
+ * @param count Quantidade de entradas
+ * @param t Instante de referência (s)
+ * @param inclusive true: primeira entrada com instante >= t; false: > t
+ * @return Posição da entrada encontrada (count se nenhuma)
+ */
+static uint32_t log_index_search(FIL *idx, uint32_t count, uint32_t t, bool inclusive) {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        log_index_entry_t e;
+        UINT br;
+        if (f_lseek(idx, (FSIZE_t)mid * sizeof(e)) != FR_OK || f_read(idx, &e, sizeof(e), &br) != FR_OK || br != sizeof(e))
+            return count;
+        if (inclusive ? e.t < t : e.t <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Lê a posição registrada em uma entrada do índice
+ */
+static bool log_index_offset(FIL *idx, uint32_t entry, uint32_t *offset) {
+    log_index_entry_t e;
+    UINT br;
+    if (f_lseek(idx, (FSIZE_t)entry * sizeof(e)) != FR_OK || f_read(idx, &e, sizeof(e), &br) != FR_OK || br != sizeof(e))
+        return false;
+    *offset = e.offset;
+    return true;
+}
+
+/**
+ * @brief Abre um log para download, limitado ao intervalo [from, to] se houver índice
+ * @param reader Estado do download
+ * @param name Nome do log dentro de LOG_DIR
+ * @param from Início do intervalo (s, RTC); negativo para o início do arquivo
+ * @param to Fim do intervalo (s, RTC); negativo para o fim do arquivo
+ * @return FR_OK se o arquivo foi aberto; FR_INVALID_NAME ou FR_INVALID_PARAMETER para
+ * nome ou intervalo inválidos; o erro do f_open (FR_NO_FILE se o log não existe)
+ */
+FRESULT log_reader_begin(log_reader_t *reader, const char *name, int64_t from, int64_t to) {
+    char path[sizeof(LOG_DIR) + LOG_NAME_MAX + sizeof(LOG_INDEX_EXT) + 1];
+    memset(reader, 0, sizeof(*reader));
+    if (!log_valid_name(name))
+        return FR_INVALID_NAME;
+    if (from >= 0 && to >= 0 && to < from)
+        return FR_INVALID_PARAMETER;
+
+    snprintf(path, sizeof(path), "%s/%s", LOG_DIR, name);
+    FRESULT fr = f_open(&reader->file, path, FA_READ);
+    if (fr != FR_OK) {
+        printf("f_open(%s) error: %s (%d)\n", path, FRESULT_str(fr), fr);
+        return fr;
+    }
+    reader->open = true;
+    reader->end = f_size(&reader->file);
+    log_fastseek(&reader->file, reader->cltbl, LOG_FASTSEEK_MAP);
+
+    // Log pré-alocado: envia só o cabeçalho e os registros já confirmados por checkpoint
+    log_prealloc_header_t header;
+    UINT br;
+    if (f_read(&reader->file, &header, sizeof(header), &br) == FR_OK && br == sizeof(header) &&
+        header.magic == LOG_PREALLOC_MAGIC && (FSIZE_t)header.header_size + header.used <= reader->end)
+        reader->end = header.header_size + header.used;
+    f_lseek(&reader->file, 0);
+
+    if (from < 0 && to < 0)
+        return FR_OK;
+
+    // O índice esparso evita percorrer o arquivo inteiro para achar o intervalo
+    FIL idx;
+    snprintf(path, sizeof(path), "%s/%s%s", LOG_DIR, name, LOG_INDEX_EXT);
+    if (f_open(&idx, path, FA_READ) != FR_OK)
+        return FR_OK;
+    DWORD idx_cltbl[LOG_FASTSEEK_MAP];
+    log_fastseek(&idx, idx_cltbl, LOG_FASTSEEK_MAP);
+    uint32_t count = f_size(&idx) / sizeof(log_index_entry_t);
+    uint32_t offset;
+    if (from >= 0) {
+        uint32_t first = log_index_search(&idx, count, (uint32_t)from, true);
+        if (first > 0 && log_index_offset(&idx, first - 1, &offset))
+            f_lseek(&reader->file, offset);
+        else if (first == count && count > 0)
+            f_lseek(&reader->file, reader->end);
+    }
+    if (to >= 0) {
+        uint32_t last = log_index_search(&idx, count, (uint32_t)to, false);
+        if (last < count && log_index_offset(&idx, last, &offset) && offset < reader->end)
+            reader->end = offset;
+    }
+    f_close(&idx);
+    return FR_OK;
+}
+
+/**
+ * @brief Lê o próximo trecho do log, em setores inteiros sempre que possível
+ * @param reader Estado do download
+ * @param buf Buffer de saída
+ * @param size Tamanho do buffer (pelo menos LOG_SECTOR_SIZE)
+ * @param done Indica que o trecho pedido foi todo lido
+ * @return Quantidade de bytes lidos
+ */
+size_t log_reader_read(log_reader_t *reader, char *buf, size_t size, bool *done) {
+    FSIZE_t pos = f_tell(&reader->file);
+    *done = false;
+    if (!reader->open || pos >= reader->end) {
+        *done = true;
+        log_reader_end(reader);
+        return 0;
+    }
+
+    // Mantém as leituras alinhadas a setor para o FatFs copiar direto do cartão para buf
+    size_t want = size - size % LOG_SECTOR_SIZE;
+    if (pos % LOG_SECTOR_SIZE)
+        want = LOG_SECTOR_SIZE - pos % LOG_SECTOR_SIZE;
+    if (want > reader->end - pos)
+        want = reader->end - pos;
+
+    UINT br = 0;
+    FRESULT fr = f_read(&reader->file, buf, want, &br);
+    if (fr != FR_OK || br == 0) {
+        if (fr != FR_OK)
+            printf("f_read error: %s (%d)\n", FRESULT_str(fr), fr);
+        *done = true;
+        log_reader_end(reader);
+    }
+    return br;
+}
+
+/**
+ * @brief Fecha o log
+ * @param reader Estado do download
+ */
+void log_reader_end(log_reader_t *reader) {
+    if (reader->open)
+        f_close(&reader->file);
+    reader->open = false;
+}
@@ -0,0 +1,68 @@
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "ff.h"
+#include "buf_writer.h"
+
+#define LOG_DIR "0:/logs" // Diretório dos arquivos de log no cartão
+#define LOG_INDEX_EXT ".idx" // Extensão do índice esparso de cada log
+#define LOG_NAME_MAX 64 // Tamanho máximo do nome de um log
+#define LOG_SECTOR_SIZE 512 // Leituras alinhadas a setor vão direto para o buffer do chamador
+
+#define LOG_FASTSEEK_MAP 32 // Itens da tabela de clusters do fast seek (pares de fragmento + 2)
+
+#define LOG_PREALLOC_MAGIC 0x474F4C44 // "DLOG": log pré-alocado com setor de cabeçalho
+#define LOG_HEADER_CLOSED 0x1 // Flag do cabeçalho: arquivo fechado normalmente (não precisa de recuperação)
+
+// Cabeçalho (primeiro setor) de um log pré-alocado: o tamanho do arquivo é o da extensão
+// reservada, então os bytes válidos são informados aqui e atualizados em cada checkpoint
+typedef struct __attribute__((packed)) {
+    uint32_t magic; // LOG_PREALLOC_MAGIC
+    uint16_t header_size; // Bytes antes do primeiro registro (LOG_SECTOR_SIZE)
+    uint16_t record_size; // Tamanho de cada registro
+    uint32_t used; // Bytes de registros válidos após o cabeçalho
+    uint32_t t_start; // Criação do arquivo (s, RTC)
+    uint32_t checkpoints; // Quantidade de checkpoints gravados
+    uint32_t flags; // LOG_HEADER_*
+} log_prealloc_header_t;
+
+// Entrada do índice esparso: instante (s, RTC) e posição do registro no log
+typedef struct {
+    uint32_t t;
+    uint32_t offset;
+} log_index_entry_t;
+
+// Estado da listagem dos logs (gerada aos pedaços)
+typedef struct {
+    DIR dir;
+    FILINFO fno; // Último item lido do diretório
+    bool pending; // fno ainda não foi escrito
+    bool open; // Diretório aberto
+    bool first; // Ainda não escreveu nenhum item
+    uint8_t stage; // 0: cabeçalho, 1: itens, 2: rodapé, 3: fim
+} log_list_t;
+
+// Estado do download de um log
+typedef struct {
+    FIL file;
+    DWORD cltbl[LOG_FASTSEEK_MAP]; // Mapa de clusters do arquivo (f_lseek sem percorrer a FAT)
+    bool open; // Arquivo aberto
+    FSIZE_t end; // Posição final (exclusiva) do trecho a enviar
+} log_reader_t;
+
+bool log_valid_name(const char *name); // Verifica se o nome pode ser usado dentro de LOG_DIR
+bool log_fastseek(FIL *file, DWORD *tbl, UINT size); // Ativa o fast seek em um arquivo aberto para leitura
+void log_list_begin(log_list_t *list); // Inicia a listagem dos logs
+size_t log_list_read(log_list_t *list, char *buf, size_t size, bool *done); // Gera o próximo trecho do JSON
+void log_list_end(log_list_t *list); // Libera a listagem
+FRESULT log_reader_begin(log_reader_t *reader, const char *name, int64_t from, int64_t to); // Abre um log para download
+size_t log_reader_read(log_reader_t *reader, char *buf, size_t size, bool *done); // Lê o próximo trecho do log
+void log_reader_end(log_reader_t *reader); // Fecha o log
+
+#endif
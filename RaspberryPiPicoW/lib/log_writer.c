@@ -0,0 +1,714 @@
+#include "log_writer.h"
+#include "f_util.h"
+#include "diskio.h"
+#include "hw_config.h"
+#include "metrics.h"
+#include "log_columnar.h"
+
+// Dois buffers: um recebe registros enquanto o outro aguarda (ou está em) gravação
+static uint8_t buffers[2][LOG_WRITER_BUF_SIZE] __attribute__((aligned(4)));
+static uint16_t fill_len = 0; // Bytes já escritos no buffer corrente
+static uint8_t fill_index = 0; // Buffer que recebe os registros
+static volatile bool full_pending = false; // O outro buffer está cheio e ainda não foi gravado
+
+static FIL file;
+static bool file_open = false;
+static int file_day = -1; // Dia do arquivo aberto (tm_yday), para a troca diária
+static uint32_t record_seq = 0;
+static uint32_t sync_records = 0; // Registros gravados desde a última sincronização
+static absolute_time_t next_sync; // Próxima sincronização por tempo
+static absolute_time_t reopen_at; // Próxima tentativa de abrir o log após uma falha do cartão
+static uint32_t reopen_ms = LOG_REOPEN_MIN_MS; // Espera antes da próxima tentativa (dobra a cada falha)
+static uint8_t scan_sector[LOG_SECTOR_SIZE] __attribute__((aligned(4))); // Setor lido na recuperação
+
+// Tabela do CRC32 (polinômio refletido 0xEDB88320) processado de 4 em 4 bits
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+// Índice esparso (LOG_INDEX_EXT): uma entrada por buffer gravado, acumuladas em RAM e gravadas em bloco
+static FIL index_file;
+static char index_path[sizeof(LOG_DIR) + LOG_NAME_MAX + sizeof(LOG_INDEX_EXT)];
+static log_index_entry_t index_buf[LOG_INDEX_BUF_ENTRIES];
+static uint16_t index_len = 0;
+static absolute_time_t index_deadline; // Próxima gravação do índice
+
+#if LOG_WRITER_PREALLOC
+static LBA_t extent_sector; // Primeiro setor da extensão reservada (cabeçalho)
+static uint32_t extent_sectors; // Setores reservados
+static uint32_t extent_next; // Próximo setor livre, relativo ao cabeçalho
+static uint8_t header_sector[LOG_SECTOR_SIZE] __attribute__((aligned(4)));
+static char part_path[sizeof(LOG_DIR) + LOG_NAME_MAX]; // Arquivo em uso, mantido após uma falha (vazio: nenhum)
+#else
+static bool file_held = false; // f_close falhou (cartão recusou a sincronização): o arquivo segue travado no FatFs
+#endif
+
+/**
+ * @brief Monta o caminho do log de um dia
+ * @param path Buffer de saída
+ * @param size Tamanho do buffer
+ * @param tm Data de referência
+ * @param part Número do arquivo no dia (negativo: sem sufixo)
+ */
+static void log_writer_path(char *path, size_t size, const struct tm *tm, int part) {
+    int n = snprintf(path, size, "%s/%04d%02d%02d", LOG_DIR, tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+    if (part >= 0)
+        n += snprintf(path + n, size - n, "_%02d", part);
+    snprintf(path + n, size - n, "%s", LOG_WRITER_EXT);
+}
+
+/**
+ * @brief Calcula o CRC32 IEEE de um bloco de bytes (mesmo resultado do zlib.crc32)
+ * @param data Dados
+ * @param len Quantidade de bytes
+ * @return CRC32
+ */
+uint32_t log_crc32(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Calcula o CRC32 de um registro (bytes antes do campo crc)
+ * @param record Registro
+ * @return CRC32
+ */
+uint32_t log_record_crc(const log_record_t *record) {
+    return log_crc32(record, offsetof(log_record_t, crc));
+}
+
+/**
+ * @brief Verifica se um setor contém só registros íntegros e em sequência
+ * @param sector Setor lido do arquivo
+ * @param seq Sequência do registro anterior; atualizada para a do último registro do setor
+ * @param check_seq false se não há registro anterior conhecido
+ * @param t_min Instante mínimo aceito (descarta dados antigos que sobraram nos clusters)
+ * @return true se o setor é válido
+ */
+static bool log_sector_valid(const uint8_t *sector, uint32_t *seq, bool check_seq, uint32_t t_min) {
+    const log_record_t *records = (const log_record_t *)sector;
+    for (size_t i = 0; i < LOG_SECTOR_SIZE / sizeof(log_record_t); i++) {
+        const log_record_t *r = &records[i];
+        if (r->len != sizeof(log_record_t) || r->t < t_min || r->crc != log_record_crc(r))
+            return false;
+        if ((check_seq || i > 0) && r->seq != *seq + 1)
+            return false;
+        *seq = r->seq;
+    }
+    return true;
+}
+
+/**
+ * @brief Lê um setor do arquivo de log aberto em file
+ * @param pos Posição (múltiplo de LOG_SECTOR_SIZE)
+ * @return true se o setor foi lido inteiro em scan_sector
+ */
+static bool log_read_sector(FSIZE_t pos) {
+    UINT br = 0;
+    return f_lseek(&file, pos) == FR_OK && f_read(&file, scan_sector, LOG_SECTOR_SIZE, &br) == FR_OK &&
+           br == LOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief Remove do índice de um log as entradas que apontam além do fim recuperado
+ * @param path Caminho do log
+ * @param end Novo tamanho do log
+ */
+static void log_index_trim(const char *path, FSIZE_t end) {
+    char idx_path[sizeof(LOG_DIR) + LOG_NAME_MAX + sizeof(LOG_INDEX_EXT)];
+    snprintf(idx_path, sizeof(idx_path), "%s%s", path, LOG_INDEX_EXT);
+    if (f_open(&index_file, idx_path, FA_READ | FA_WRITE) != FR_OK)
+        return;
+    uint32_t count = f_size(&index_file) / sizeof(log_index_entry_t);
+    while (count > 0) {
+        log_index_entry_t e;
+        UINT br = 0;
+        if (f_lseek(&index_file, (FSIZE_t)(count - 1) * sizeof(e)) != FR_OK ||
+            f_read(&index_file, &e, sizeof(e), &br) != FR_OK || br != sizeof(e) || e.offset < end)
+            break;
+        count--;
+    }
+    f_lseek(&index_file, (FSIZE_t)count * sizeof(log_index_entry_t));
+    f_truncate(&index_file);
+    f_close(&index_file);
+}
+
+/**
+ * @brief Indica se já é hora de sincronizar (LOG_SYNC_RECORDS registros ou LOG_SYNC_MS)
+ */
+static bool log_writer_sync_due(void) {
+    return sync_records >= LOG_SYNC_RECORDS || time_reached(next_sync);
+}
+
+/**
+ * @brief Reinicia a contagem até a próxima sincronização
+ */
+static void log_writer_synced(void) {
+    sync_records = 0;
+    next_sync = make_timeout_time_ms(LOG_SYNC_MS);
+}
+
+/**
+ * @brief Define o arquivo de índice do log aberto e descarta entradas pendentes de outro arquivo
+ * @param path Caminho do log
+ */
+static void log_writer_index_begin(const char *path) {
+    snprintf(index_path, sizeof(index_path), "%s%s", path, LOG_INDEX_EXT);
+    index_len = 0;
+    index_deadline = make_timeout_time_ms(LOG_INDEX_FLUSH_MS);
+}
+
+/**
+ * @brief Acrescenta ao final do índice as entradas acumuladas
+ * @return true se as entradas foram gravadas
+ */
+static bool log_writer_index_flush(void) {
+    index_deadline = make_timeout_time_ms(LOG_INDEX_FLUSH_MS);
+    if (index_len == 0)
+        return true;
+    UINT bw = 0;
+    UINT size = index_len * sizeof(log_index_entry_t);
+    FRESULT fr = f_open(&index_file, index_path, FA_WRITE | FA_OPEN_APPEND);
+    if (fr == FR_OK) {
+        fr = f_write(&index_file, index_buf, size, &bw);
+        FRESULT fr_close = f_close(&index_file);
+        if (fr == FR_OK)
+            fr = fr_close;
+    }
+    // Em caso de falha as entradas são perdidas: o índice fica mais esparso, mas continua ordenado
+    index_len = 0;
+    if (fr != FR_OK || bw != size) {
+        printf("f_write(%s) error: %s (%d)\n", index_path, FRESULT_str(fr), fr);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Registra no índice o primeiro registro de um buffer
+ * @param buf Buffer gravado
+ * @param offset Posição do buffer no arquivo
+ */
+static void log_writer_index_add(const uint8_t *buf, FSIZE_t offset) {
+    if (index_len == LOG_INDEX_BUF_ENTRIES)
+        log_writer_index_flush();
+    index_buf[index_len].t = ((const log_record_t *)buf)->t;
+    index_buf[index_len].offset = (uint32_t)offset;
+    index_len++;
+}
+
+#if LOG_WRITER_PREALLOC
+
+/**
+ * @brief Grava o cabeçalho com a quantidade de bytes válidos (única escrita fora da extensão de dados)
+ * @return true se o setor foi gravado
+ */
+static bool log_writer_checkpoint(void) {
+    log_prealloc_header_t *header = (log_prealloc_header_t *)header_sector;
+    header->used = (extent_next - 1) * LOG_SECTOR_SIZE;
+    header->checkpoints++;
+    log_writer_synced();
+    return disk_write(file.obj.fs->pdrv, header_sector, extent_sector, 1) == RES_OK;
+}
+
+/**
+ * @brief Procura após o último checkpoint de um log pré-alocado os setores íntegros gravados depois dele
+ * @param header Cabeçalho lido do arquivo (aberto em file)
+ * @param recovered Registros encontrados após o checkpoint
+ * @return Fim dos dados válidos (posição no arquivo)
+ */
+static FSIZE_t log_prealloc_end(const log_prealloc_header_t *header, uint32_t *recovered) {
+    FSIZE_t pos = (FSIZE_t)header->header_size + header->used;
+    uint32_t seq = 0;
+    bool check_seq = false;
+    // A continuidade parte do último registro confirmado pelo checkpoint
+    if (header->used >= LOG_SECTOR_SIZE && log_read_sector(pos - LOG_SECTOR_SIZE))
+        check_seq = log_sector_valid(scan_sector, &seq, false, header->t_start);
+
+    *recovered = 0;
+    while (pos + LOG_SECTOR_SIZE <= f_size(&file) && log_read_sector(pos) &&
+           log_sector_valid(scan_sector, &seq, check_seq, header->t_start)) {
+        check_seq = true;
+        pos += LOG_SECTOR_SIZE;
+        *recovered += LOG_SECTOR_SIZE / sizeof(log_record_t);
+    }
+    return pos;
+}
+
+/**
+ * @brief Recupera um log pré-alocado que não foi fechado: procura após o último checkpoint os setores
+ * gravados antes da queda, atualiza o cabeçalho e devolve o resto da extensão à FAT
+ * @param path Caminho do log (já aberto em file, para leitura e escrita)
+ * @param header Cabeçalho lido do arquivo
+ */
+static void log_recover_prealloc(const char *path, log_prealloc_header_t *header) {
+    uint32_t recovered = 0;
+    FSIZE_t pos = log_prealloc_end(header, &recovered);
+
+    header->used = pos - header->header_size;
+    header->flags |= LOG_HEADER_CLOSED;
+    UINT bw = 0;
+    FRESULT fr = f_lseek(&file, 0);
+    if (fr == FR_OK)
+        fr = f_write(&file, header, sizeof(*header), &bw);
+    if (fr == FR_OK)
+        fr = f_lseek(&file, pos);
+    if (fr == FR_OK)
+        fr = f_truncate(&file);
+    if (fr != FR_OK)
+        printf("Recuperação de %s error: %s (%d)\n", path, FRESULT_str(fr), fr);
+    log_index_trim(path, pos);
+    metrics_add(&metrics.log_recoveries, 1);
+    metrics_add(&metrics.log_recovered_records, recovered);
+    printf("%s recuperado: %lu registros após o checkpoint, %lu bytes\n", path, (unsigned long)recovered,
+           (unsigned long)pos);
+}
+
+/**
+ * @brief Procura em LOG_DIR logs pré-alocados sem a flag LOG_HEADER_CLOSED (queda de energia) e os recupera
+ */
+static void log_writer_recover(void) {
+    DIR dir;
+    FILINFO fno;
+    char path[sizeof(LOG_DIR) + LOG_NAME_MAX];
+    if (f_opendir(&dir, LOG_DIR) != FR_OK)
+        return;
+    size_t ext_len = strlen(LOG_WRITER_EXT);
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != 0) {
+        size_t name_len = strlen(fno.fname);
+        if ((fno.fattrib & AM_DIR) || name_len <= ext_len || strcmp(fno.fname + name_len - ext_len, LOG_WRITER_EXT) != 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", LOG_DIR, fno.fname);
+        if (f_open(&file, path, FA_READ | FA_WRITE) != FR_OK)
+            continue;
+        log_prealloc_header_t header;
+        UINT br = 0;
+        // Só recupera arquivos no formato atual: registros de outro tamanho seriam todos rejeitados
+        if (f_read(&file, &header, sizeof(header), &br) == FR_OK && br == sizeof(header) &&
+            header.magic == LOG_PREALLOC_MAGIC && header.record_size == sizeof(log_record_t) &&
+            header.header_size == LOG_SECTOR_SIZE && !(header.flags & LOG_HEADER_CLOSED))
+            log_recover_prealloc(path, &header);
+        f_close(&file);
+    }
+    f_closedir(&dir);
+}
+
+/**
+ * @brief Fecha o arquivo: grava o último checkpoint e devolve à FAT a parte não usada da extensão
+ */
+static void log_writer_close(void) {
+    log_writer_index_flush();
+    ((log_prealloc_header_t *)header_sector)->flags |= LOG_HEADER_CLOSED;
+    log_writer_checkpoint();
+    f_lseek(&file, (FSIZE_t)extent_next * LOG_SECTOR_SIZE);
+    f_truncate(&file);
+    f_close(&file);
+    file_open = false;
+    part_path[0] = 0;
+}
+
+/**
+ * @brief Solta o arquivo após uma falha de gravação sem fechar o log: o resto da extensão continua
+ * reservado e log_writer_open_day volta a ele no último checkpoint
+ */
+static void log_writer_suspend(void) {
+    f_close(&file);
+    file_open = false;
+}
+
+/**
+ * @brief Reabre o arquivo em uso após uma falha de gravação e continua do último checkpoint (e dos
+ * setores íntegros gravados depois dele), sem reservar outra extensão
+ * @return FR_OK se o arquivo foi reaberto; FR_NO_FILE se ele não pode ser continuado
+ */
+static FRESULT log_writer_reopen(void) {
+    FRESULT fr = f_open(&file, part_path, FA_READ | FA_WRITE);
+    if (fr != FR_OK)
+        return fr;
+    log_prealloc_header_t *header = (log_prealloc_header_t *)header_sector;
+    UINT br = 0;
+    fr = f_read(&file, header_sector, LOG_SECTOR_SIZE, &br);
+    if (fr == FR_OK && (br != LOG_SECTOR_SIZE || header->magic != LOG_PREALLOC_MAGIC ||
+                        header->record_size != sizeof(log_record_t) || (header->flags & LOG_HEADER_CLOSED)))
+        fr = FR_NO_FILE;
+    if (fr != FR_OK) {
+        f_close(&file);
+        return fr;
+    }
+
+    uint32_t recovered = 0;
+    FSIZE_t pos = log_prealloc_end(header, &recovered);
+    FATFS *fs = file.obj.fs;
+    extent_sector = fs->database + (LBA_t)(file.obj.sclust - 2) * fs->csize;
+    extent_sectors = f_size(&file) / LOG_SECTOR_SIZE;
+    extent_next = pos / LOG_SECTOR_SIZE;
+    file_open = true;
+    if (!log_writer_checkpoint()) {
+        f_close(&file);
+        file_open = false;
+        return FR_DISK_ERR;
+    }
+    // O buffer perdido deixa um salto na sequência e a recuperação exige continuidade após o último
+    // checkpoint: o próximo buffer gravado já é confirmado por outro
+    sync_records = LOG_SYNC_RECORDS;
+    printf("%s reaberto no setor %lu\n", part_path, (unsigned long)extent_next);
+    return FR_OK;
+}
+
+/**
+ * @brief Cria um novo arquivo do dia e reserva para ele uma extensão contígua; após uma falha de
+ * gravação, continua no arquivo em uso enquanto for o mesmo dia
+ * @param tm Data de referência
+ * @return true se o arquivo foi aberto
+ */
+static bool log_writer_open_day(const struct tm *tm) {
+    if (part_path[0]) {
+        FRESULT fr = log_writer_reopen();
+        if (fr == FR_OK && tm->tm_yday == file_day)
+            return true;
+        if (fr == FR_OK) {
+            log_writer_close(); // Virada do dia: fecha o arquivo antes de criar o do novo dia
+        } else if (fr != FR_NO_FILE && tm->tm_yday == file_day) {
+            printf("f_open(%s) error: %s (%d)\n", part_path, FRESULT_str(fr), fr);
+            return false; // Cartão ainda com falha: tenta de novo depois, sem criar outro arquivo
+        }
+        part_path[0] = 0;
+    }
+
+    char path[sizeof(LOG_DIR) + LOG_NAME_MAX];
+    FRESULT fr = FR_EXIST;
+    for (int part = 0; part < LOG_PREALLOC_PARTS_MAX && fr == FR_EXIST; part++) {
+        log_writer_path(path, sizeof(path), tm, part);
+        fr = f_open(&file, path, FA_WRITE | FA_CREATE_NEW);
+    }
+    if (fr != FR_OK) {
+        printf("f_open(%s) error: %s (%d)\n", path, FRESULT_str(fr), fr);
+        return false;
+    }
+
+    // A FAT e a entrada de diretório são gravadas aqui uma única vez, com o tamanho da extensão
+    fr = f_expand(&file, LOG_PREALLOC_SIZE, 1);
+    if (fr == FR_OK)
+        fr = f_sync(&file);
+    if (fr != FR_OK) {
+        printf("f_expand(%s) error: %s (%d)\n", path, FRESULT_str(fr), fr);
+        f_close(&file);
+        f_unlink(path);
+        return false;
+    }
+
+    // Arquivo novo: um índice antigo com o mesmo nome não vale mais
+    log_writer_index_begin(path);
+    f_unlink(index_path);
+    snprintf(part_path, sizeof(part_path), "%s", path);
+
+    FATFS *fs = file.obj.fs;
+    extent_sector = fs->database + (LBA_t)(file.obj.sclust - 2) * fs->csize;
+    extent_sectors = LOG_PREALLOC_SIZE / LOG_SECTOR_SIZE;
+    extent_next = 1;
+
+    memset(header_sector, 0, sizeof(header_sector));
+    log_prealloc_header_t *header = (log_prealloc_header_t *)header_sector;
+    header->magic = LOG_PREALLOC_MAGIC;
+    header->header_size = LOG_SECTOR_SIZE;
+    header->record_size = sizeof(log_record_t);
+    header->t_start = (uint32_t)time(NULL);
+
+    file_open = true;
+    file_day = tm->tm_yday;
+    return log_writer_checkpoint();
+}
+
+/**
+ * @brief Grava um buffer direto nos setores reservados, sem passar pela FAT nem reabrir a escrita multibloco
+ * @param buf Buffer cheio
+ * @param tm Data de referência (para abrir o próximo arquivo se a extensão acabar)
+ * @return true se o buffer foi gravado
+ */
+static bool log_writer_write(const uint8_t *buf, const struct tm *tm) {
+    uint32_t count = LOG_WRITER_BUF_SIZE / LOG_SECTOR_SIZE;
+    if (extent_next + count > extent_sectors) {
+        log_writer_close();
+        if (!log_writer_open_day(tm))
+            return false;
+    }
+    // Mantém o cartão em CMD25 entre os buffers; o checkpoint (ou qualquer outro acesso) encerra a sessão
+    sd_card_t *sd = sd_get_by_num(file.obj.fs->pdrv);
+    LBA_t sector = extent_sector + extent_next;
+    if (!sd->stream_open || sd->stream_next != sector) {
+        if (sd_stream_open(sd, sector, extent_sectors - extent_next) != SD_BLOCK_DEVICE_ERROR_NONE) {
+            printf("sd_stream_open error no setor %lu\n", (unsigned long)sector);
+            return false;
+        }
+    }
+    if (sd_stream_write(sd, buf, count) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        printf("sd_stream_write error no setor %lu\n", (unsigned long)sector);
+        return false;
+    }
+    log_writer_index_add(buf, (FSIZE_t)extent_next * LOG_SECTOR_SIZE);
+    extent_next += count;
+    sync_records += LOG_WRITER_BUF_SIZE / sizeof(log_record_t);
+    if (log_writer_sync_due())
+        return log_writer_checkpoint();
+    return true;
+}
+
+#else
+
+/**
+ * @brief Abre o arquivo do dia, continuando do fim se ele já existir
+ * @param tm Data de referência
+ * @return true se o arquivo foi aberto
+ */
+static bool log_writer_open_day(const struct tm *tm) {
+    if (file_held) {
+        FRESULT fr = f_close(&file);
+        if (fr != FR_OK) {
+            printf("f_close error: %s (%d)\n", FRESULT_str(fr), fr);
+            return false;
+        }
+        file_held = false;
+    }
+
+    char path[sizeof(LOG_DIR) + LOG_NAME_MAX];
+    log_writer_path(path, sizeof(path), tm, -1);
+    FRESULT fr = f_open(&file, path, FA_READ | FA_WRITE | FA_OPEN_APPEND);
+    if (fr != FR_OK) {
+        printf("f_open(%s) error: %s (%d)\n", path, FRESULT_str(fr), fr);
+        return false;
+    }
+
+    // Recuperação: os buffers só são gravados inteiros, então o fim válido é o último setor íntegro.
+    // Um setor rasgado (ou um tamanho além do que foi gravado) é cortado antes de continuar o arquivo
+    FSIZE_t size = f_size(&file);
+    FSIZE_t pos = size - size % LOG_SECTOR_SIZE;
+    uint32_t seq = 0;
+    bool found = false;
+    for (int i = 0; i < LOG_RECOVER_MAX_SECTORS && pos > 0 && !found; i++) {
+        found = log_read_sector(pos - LOG_SECTOR_SIZE) && log_sector_valid(scan_sector, &seq, false, 0);
+        if (!found)
+            pos -= LOG_SECTOR_SIZE;
+    }
+    if (!found && pos > 0) {
+        // Nada reconhecível perto do fim (outro formato?): não corta dados que não entende
+        printf("Aviso: fim de %s não reconhecido, arquivo mantido\n", path);
+        pos = size;
+    } else if (pos < size) {
+        printf("Aviso: %s cortado de %lu para %lu bytes\n", path, (unsigned long)size, (unsigned long)pos);
+        fr = f_lseek(&file, pos);
+        if (fr == FR_OK)
+            fr = f_truncate(&file);
+        if (fr == FR_OK)
+            fr = f_sync(&file);
+        if (fr != FR_OK) {
+            printf("f_truncate(%s) error: %s (%d)\n", path, FRESULT_str(fr), fr);
+            f_close(&file);
+            return false;
+        }
+        log_index_trim(path, pos);
+        metrics_add(&metrics.log_recoveries, 1);
+    }
+    // Na partida, a sequência continua a do último registro do arquivo; ao reabrir após uma falha,
+    // os registros já nos buffers seguem a numeração em curso
+    if (found && record_seq == 0)
+        record_seq = seq + 1;
+    f_lseek(&file, pos);
+
+    log_writer_index_begin(path);
+    file_open = true;
+    file_day = tm->tm_yday;
+    return true;
+}
+
+/**
+ * @brief Fecha o arquivo
+ */
+static void log_writer_close(void) {
+    log_writer_index_flush();
+    f_close(&file);
+    file_open = false;
+}
+
+/**
+ * @brief Solta o arquivo após uma falha de gravação; log_writer_open_day o reabre e corta o que
+ * não foi gravado inteiro. Se nem o f_close passa, ele é repetido antes de reabrir
+ */
+static void log_writer_suspend(void) {
+    log_writer_index_flush();
+    file_held = f_close(&file) != FR_OK;
+    file_open = false;
+}
+
+/**
+ * @brief Grava um buffer com um único f_write de setores inteiros
+ * @param buf Buffer cheio
+ * @param tm Data de referência (não usada neste modo)
+ * @return true se o buffer foi gravado
+ */
+static bool log_writer_write(const uint8_t *buf, const struct tm *tm) {
+    UINT bw = 0;
+    FSIZE_t offset = f_tell(&file);
+    FRESULT fr = f_write(&file, buf, LOG_WRITER_BUF_SIZE, &bw);
+    if (fr == FR_OK && bw == LOG_WRITER_BUF_SIZE) {
+        sync_records += LOG_WRITER_BUF_SIZE / sizeof(log_record_t);
+        // O tamanho na entrada de diretório só é atualizado no f_sync; entre eles a recuperação corta o excesso
+        if (log_writer_sync_due()) {
+            fr = f_sync(&file);
+            log_writer_synced();
+        }
+    }
+    if (fr != FR_OK || bw != LOG_WRITER_BUF_SIZE) {
+        printf("f_write error: %s (%d)\n", FRESULT_str(fr), fr);
+        return false;
+    }
+    log_writer_index_add(buf, offset);
+    return true;
+}
+
+#endif
+
+/**
+ * @brief Agenda a próxima tentativa de abrir o log, com espera exponencial
+ */
+static void log_writer_retry_later(void) {
+    reopen_at = make_timeout_time_ms(reopen_ms);
+    printf("Log: nova tentativa em %lu ms\n", (unsigned long)reopen_ms);
+    reopen_ms = MIN(2 * reopen_ms, LOG_REOPEN_MAX_MS);
+}
+
+/**
+ * @brief Abre o log binário do dia, criando LOG_DIR se preciso e recuperando logs interrompidos
+ * @return true se o arquivo foi aberto
+ */
+bool log_writer_open(void) {
+    FRESULT fr = f_mkdir(LOG_DIR);
+    if (fr != FR_OK && fr != FR_EXIST) {
+        printf("f_mkdir(%s) error: %s (%d)\n", LOG_DIR, FRESULT_str(fr), fr);
+        return false;
+    }
+#if LOG_WRITER_PREALLOC
+    log_writer_recover();
+#endif
+    log_writer_synced();
+    time_t now = time(NULL);
+    return log_writer_open_day(localtime(&now));
+}
+
+/**
+ * @brief Acrescenta um registro ao buffer corrente (não acessa o cartão)
+ * @param readings Leituras dos sensores
+ * @param t_ms Instante da leitura (ms desde o boot)
+ * @return false se os dois buffers estão cheios e o registro foi descartado
+ */
+bool log_writer_append(const SensorReadings *readings, uint32_t t_ms) {
+    if (fill_len + sizeof(log_record_t) > LOG_WRITER_BUF_SIZE) {
+        // Buffer corrente cheio: só troca se o outro já foi gravado
+        if (full_pending) {
+            metrics_add(&metrics.log_dropped, 1);
+            return false;
+        }
+        full_pending = true;
+        fill_index ^= 1;
+        fill_len = 0;
+    }
+
+    log_record_t *record = (log_record_t *)&buffers[fill_index][fill_len];
+    memset(record, 0, sizeof(*record));
+    record->len = sizeof(log_record_t);
+    record->channels = SENSOR_CH_COUNT;
+    record->seq = record_seq++;
+    record->t = (uint32_t)time(NULL);
+    record->t_ms = t_ms;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        record->value[ch] = history_from_float(ch, sensor_channel_value(readings, ch));
+    record->crc = log_record_crc(record);
+    fill_len += sizeof(log_record_t);
+    metrics_add(&metrics.log_records, 1);
+
+    // Troca assim que encher, para a gravação começar sem esperar o próximo registro
+    if (fill_len == LOG_WRITER_BUF_SIZE && !full_pending) {
+        full_pending = true;
+        fill_index ^= 1;
+        fill_len = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Indica se há um buffer cheio aguardando gravação
+ */
+bool log_writer_pending(void) {
+    return full_pending;
+}
+
+/**
+ * @brief Indica se o log do dia está aberto no cartão
+ */
+bool log_writer_is_open(void) {
+    return file_open;
+}
+
+/**
+ * @brief Grava o buffer cheio no cartão
+ */
+void log_writer_service(void) {
+    if (!full_pending)
+        return;
+
+    time_t now = time(NULL);
+    struct tm *tm = localtime(&now);
+    if (file_open && tm->tm_yday != file_day)
+        log_writer_close();
+    if (!file_open) {
+        // Sem cartão (ou aguardando a próxima tentativa): descarta o buffer para não travar a aquisição
+        bool due = time_reached(reopen_at);
+        if (!due || !log_writer_open_day(tm)) {
+            if (due)
+                log_writer_retry_later();
+            metrics_add(&metrics.log_dropped, LOG_WRITER_BUF_SIZE / sizeof(log_record_t));
+            full_pending = false;
+            return;
+        }
+    }
+
+    uint64_t start = time_us_64();
+    bool written = log_writer_write(buffers[fill_index ^ 1], tm);
+    if (written) {
+        metrics_add(&metrics.log_payload_sectors, LOG_WRITER_BUF_SIZE / LOG_SECTOR_SIZE);
+        reopen_ms = LOG_REOPEN_MIN_MS;
+        if (time_reached(index_deadline))
+            log_writer_index_flush();
+    } else {
+        // O arquivo é reaberto depois de uma espera, e não a cada buffer enquanto o cartão falhar
+        metrics_add(&metrics.log_write_errors, 1);
+        metrics_add(&metrics.log_dropped, LOG_WRITER_BUF_SIZE / sizeof(log_record_t));
+        if (file_open)
+            log_writer_suspend();
+        log_writer_retry_later();
+    }
+    uint32_t elapsed = (uint32_t)(time_us_64() - start);
+    metrics_observe(&metrics.log_write_latency, elapsed);
+    if (elapsed > metrics.log_write_max_us)
+        metrics.log_write_max_us = elapsed;
+
+#if LOG_COLUMNAR
+    // O formato colunar é montado a partir do buffer recém-gravado, já fora da aquisição; um buffer
+    // perdido fica fora dos dois formatos
+    if (written) {
+        const log_record_t *records = (const log_record_t *)buffers[fill_index ^ 1];
+        for (size_t i = 0; i < LOG_WRITER_BUF_SIZE / sizeof(log_record_t); i++) {
+            int16_t value[SENSOR_CH_COUNT];
+            memcpy(value, (const uint8_t *)&records[i] + offsetof(log_record_t, value), sizeof(value));
+            log_col_append(records[i].t, records[i].t_ms, value);
+        }
+    }
+#endif
+    full_pending = false;
+}
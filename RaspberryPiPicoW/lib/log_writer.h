@@ -0,0 +1,70 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+
+#include "ff.h"
+#include "sensors.h"
+#include "history.h"
+#include "log_store.h"
+
+#define LOG_WRITER_BUF_SIZE (2 * LOG_SECTOR_SIZE) // Tamanho de cada um dos dois buffers (múltiplo do setor)
+#define LOG_WRITER_EXT ".bin" // Extensão dos logs binários
+
+#ifndef LOG_WRITER_PREALLOC
+#define LOG_WRITER_PREALLOC 1 // 1: arquivos contíguos pré-alocados (f_expand) e gravados por setor; 0: f_write comum
+#endif
+
+#define LOG_PREALLOC_SIZE (2u * 1024 * 1024) // Extensão reservada para cada arquivo (cabeçalho incluso)
+#define LOG_PREALLOC_PARTS_MAX 100 // Arquivos por dia (AAAAMMDD_NN.bin)
+// Cadência de sincronização (f_sync ou checkpoint do cabeçalho): o que vencer primeiro
+#ifndef LOG_SYNC_RECORDS
+#define LOG_SYNC_RECORDS 120 // Registros gravados entre sincronizações
+#endif
+#ifndef LOG_SYNC_MS
+#define LOG_SYNC_MS 60000 // Intervalo máximo entre sincronizações
+#endif
+
+// Espera entre tentativas de reabrir o log após uma falha do cartão: dobra a cada falha, do mínimo ao máximo
+#define LOG_REOPEN_MIN_MS 1000
+#define LOG_REOPEN_MAX_MS 60000
+
+#define LOG_RECOVER_MAX_SECTORS (2 * LOG_WRITER_BUF_SIZE / LOG_SECTOR_SIZE) // Setores examinados do fim de um log comum
+
+#define LOG_INDEX_BUF_ENTRIES (LOG_SECTOR_SIZE / sizeof(log_index_entry_t)) // Entradas do índice acumuladas em RAM
+#define LOG_INDEX_FLUSH_MS LOG_SYNC_MS // Intervalo máximo entre gravações do índice
+
+#define LOG_RECORD_SIZE 64 // Tamanho de cada registro (divisor do setor)
+#define LOG_RECORD_PAD (LOG_RECORD_SIZE - 20 - 2 * SENSOR_CH_COUNT) // Bytes livres para canais futuros
+
+// Registro binário de tamanho fixo, com os canais no formato do histórico. O enquadramento
+// (tamanho + sequência + CRC32) permite achar, após uma queda de energia, o último registro íntegro
+typedef struct __attribute__((packed)) {
+    uint16_t len; // LOG_RECORD_SIZE
+    uint16_t channels; // SENSOR_CH_COUNT
+    uint32_t seq; // Sequência do registro (contínua dentro de um arquivo)
+    uint32_t t; // Instante da amostra (s, RTC)
+    uint32_t t_ms; // Instante da amostra (ms desde o boot)
+    int16_t value[SENSOR_CH_COUNT]; // Valores escalados como em history_from_float
+    uint8_t pad[LOG_RECORD_PAD]; // Zeros
+    uint32_t crc; // CRC32 (IEEE, como o zlib) dos bytes anteriores
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == LOG_RECORD_SIZE, "tamanho do registro");
+_Static_assert(LOG_SECTOR_SIZE % sizeof(log_record_t) == 0, "registros não podem cruzar setores");
+_Static_assert(LOG_WRITER_BUF_SIZE % LOG_SECTOR_SIZE == 0, "buffer deve ser múltiplo do setor");
+
+uint32_t log_crc32(const void *data, size_t len); // Calcula o CRC32 IEEE de um bloco de bytes
+uint32_t log_record_crc(const log_record_t *record); // Calcula o CRC32 de um registro
+bool log_writer_open(void); // Abre o log binário do dia
+bool log_writer_append(const SensorReadings *readings, uint32_t t_ms); // Acrescenta um registro ao buffer corrente
+bool log_writer_pending(void); // Indica se há um buffer cheio aguardando gravação
+bool log_writer_is_open(void); // Indica se o log do dia está aberto no cartão
+void log_writer_service(void); // Grava o buffer cheio no cartão
+
+#endif
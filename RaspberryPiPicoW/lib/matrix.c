@@ -1,20 +1,32 @@
 #include "matrix.h"
+#include <math.h>
+#include <string.h>
 
-//Cores 
-const RGB RED = {0.1, 0, 0};
-const RGB GREEN = {0, 0.1, 0};
-const RGB BLUE = {0, 0, 0.1};
-const RGB YELLOW = {0.1, 0.1, 0};
-const RGB CYAN = {0, 0.1, 0.1};
-const RGB MAGENTA = {0.1, 0, 0.1};
-const RGB WHITE = {0.1, 0.1, 0.1};
+//Cores (intensidade máxima: o brilho vem da tabela de gama)
+const RGB RED = {1, 0, 0};
+const RGB GREEN = {0, 1, 0};
+const RGB BLUE = {0, 0, 1};
+const RGB YELLOW = {1, 1, 0};
+const RGB CYAN = {0, 1, 1};
+const RGB MAGENTA = {1, 0, 1};
+const RGB WHITE = {1, 1, 1};
 const RGB BLACK = {0, 0, 0};
 
 PIO pio; //Variável para armazenar a configuração da PIO
 uint sm; //Variável para armazenar o estado da máquina
 
+static uint32_t frame[NUM_PIXELS]; // Quadro em desenho: palavras GRB na ordem da cadeia de LEDs
+static uint32_t tx_frame[NUM_PIXELS]; // Cópia lida pelo DMA durante o envio
+static uint8_t gamma_lut[256]; // Intensidade de 8 bits -> nível enviado (gama e brilho)
+static int dma_channel; // Canal DMA que alimenta a FIFO da máquina de estados
+static uint64_t last_show_us; // Início do último envio
+static matrix_mode_t mode = MATRIX_DEFAULT_MODE; // Modo ao vivo
+static sensor_channel_t heatmap_channel = SENSOR_CH_TEMPERATURE; // Canal do mapa de calor
+static uint32_t alert_mask = 0; // Canais em alerta
+
 /**
  * @brief Inicializa a matriz de LEDs RGB
+ * @return Máquina de estados usada
  */
 uint matrix_init(void) {
    //Configurações da PIO
@@ -22,37 +34,109 @@ uint matrix_init(void) {
    uint offset = pio_add_program(pio, &pio_matrix_program);
    sm = pio_claim_unused_sm(pio, true);
    pio_matrix_program_init(pio, sm, offset, WS2812_PIN);
+
+   // DMA: o quadro inteiro vai para a FIFO no ritmo que a máquina de estados consome
+   dma_channel = dma_claim_unused_channel(true);
+   dma_channel_config cfg = dma_channel_get_default_config(dma_channel);
+   channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+   channel_config_set_read_increment(&cfg, true);
+   channel_config_set_write_increment(&cfg, false);
+   channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, true));
+   dma_channel_configure(dma_channel, &cfg, &pio->txf[sm], tx_frame, NUM_PIXELS, false);
+
+   matrix_set_brightness(MATRIX_BRIGHTNESS);
+   last_show_us = time_us_64();
+   clear_matrix();
+   return sm;
 }
 
 /**
- * @brief Converte as intensidades de cor para um valor RGB
- * @param r Intensidade da cor vermelha
- * @param g Intensidade da cor verde
- * @param b Intensidade da cor azul
+ * @brief Recalcula a tabela de gama para um novo brilho máximo
+ * @param brightness Nível enviado para a intensidade 255
+ */
+void matrix_set_brightness(uint8_t brightness) {
+    for (int i = 0; i < 256; i++)
+        gamma_lut[i] = (uint8_t)(powf(i / 255.0f, MATRIX_GAMMA) * brightness + 0.5f);
+}
+
+/**
+ * @brief Converte uma cor de 8 bits para a palavra enviada à PIO (GRB nos 24 bits altos)
+ * @param r Vermelho (0-255, linear na percepção)
+ * @param g Verde
+ * @param b Azul
+ * @return Palavra GRB já com gama e brilho
+ */
+uint32_t matrix_grb(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)gamma_lut[g] << 24) | ((uint32_t)gamma_lut[r] << 16) | ((uint32_t)gamma_lut[b] << 8);
+}
+
+/**
+ * @brief Define um pixel do quadro pelas coordenadas (origem no canto superior esquerdo)
+ * @param x Coluna
+ * @param y Linha
+ * @param grb Palavra de cor (matrix_grb ou matrix_rgb)
+ */
+void matrix_set_pixel(int x, int y, uint32_t grb) {
+    if (x < 0 || x >= MATRIX_SIZE || y < 0 || y >= MATRIX_SIZE)
+        return;
+    frame[getIndex(x, y)] = grb;
+}
+
+/**
+ * @brief Indica se o quadro anterior ainda está sendo enviado
+ * @return true enquanto o DMA ou o pulso de reset dos LEDs não terminaram
+ */
+bool matrix_busy(void) {
+    return dma_channel_is_busy(dma_channel) || time_us_64() - last_show_us < MATRIX_FRAME_US;
+}
+
+/**
+ * @brief Envia o quadro por DMA, sem esperar; o próximo já pode ser desenhado em seguida
+ * @return false se o quadro anterior ainda está sendo enviado
+ */
+bool matrix_show(void) {
+    if (matrix_busy())
+        return false;
+    memcpy(tx_frame, frame, sizeof(frame));
+    last_show_us = time_us_64();
+    dma_channel_transfer_from_buffer_now(dma_channel, tx_frame, NUM_PIXELS);
+    return true;
+}
+
+/**
+ * @brief Converte uma intensidade de 0 a 1 para 8 bits
+ */
+static uint8_t matrix_level(double v) {
+    if (v <= 0)
+        return 0;
+    if (v >= 1)
+        return 255;
+    return (uint8_t)(v * 255 + 0.5);
+}
+
+/**
+ * @brief Converte as intensidades de cor para um valor RGB, pela mesma tabela de gama de matrix_grb
+ * @param r Intensidade da cor vermelha (0 a 1)
+ * @param g Intensidade da cor verde (0 a 1)
+ * @param b Intensidade da cor azul (0 a 1)
  * @return Valor RGB
  */
 uint32_t matrix_rgb(double r, double g, double b){
-  unsigned char R, G, B;
-  R = r * 100;
-  G = g * 100;
-  B = b * 100;
-  return (G << 24) | (R << 16) | (B << 8);
+    return matrix_grb(matrix_level(r), matrix_level(g), matrix_level(b));
 }
 
 /**
  * @brief Define as cores dos LEDs
- * @param pio Configuração da PIO
- * @param sm Estado da máquina
  * @param r Intensidade da cor vermelha
  * @param g Intensidade da cor verde
  * @param b Intensidade da cor azul
  */
-void set_leds(PIO pio, uint sm, double r, double g, double b) {
-    uint32_t valor_led;
-    for (int16_t i = 0; i < NUM_PIXELS; i++) {
-        valor_led = matrix_rgb(r, g, b);
-        pio_sm_put_blocking(pio, sm, valor_led);
-    }
+void set_leds(double r, double g, double b) {
+    uint32_t valor_led = matrix_grb(matrix_level(r), matrix_level(g), matrix_level(b)); // Uma conversão para todos os LEDs
+    for (int16_t i = 0; i < NUM_PIXELS; i++)
+        frame[i] = valor_led;
+    while (!matrix_show())
+        tight_loop_contents();
 }
 
 /**
@@ -94,27 +178,108 @@ uint coordenates_to_index(int x, int y) {
 
 /**
  * @brief Desenha a matriz de LEDs RGB
- * @param pixels Array com as cores dos LEDs
- * @param pio Configuração da PIO
- * @param sm Estado da máquina
+ * @param pixels Array com as cores dos LEDs (linha a linha, a partir do canto superior esquerdo)
  */
-void draw_matrix(RGB pixels[NUM_PIXELS], PIO pio, uint sm) {
+void draw_matrix(const RGB pixels[NUM_PIXELS]) {
     for (int i = 0; i < NUM_PIXELS; i++) {
         int x = i % 5;
         int y = i / 5;
-        int index = getIndex(x, y);
-        pio_sm_put_blocking(pio, sm, matrix_rgb(pixels[index].R, pixels[index].G, pixels[index].B));
+        const RGB *p = &pixels[getIndex(x, y)];
+        frame[i] = matrix_grb(matrix_level(p->R), matrix_level(p->G), matrix_level(p->B));
     }
+    while (!matrix_show())
+        tight_loop_contents();
 }
 
 /**
  * @brief Apaga a matriz de LEDs RGB
  */
 void clear_matrix(void){
-    RGB pixels[NUM_PIXELS];
-    for (int i = 0; i < NUM_PIXELS; i++) {
-        pixels[i] = BLACK;
+    memset(frame, 0, sizeof(frame));
+    while (!matrix_show())
+        tight_loop_contents();
+}
+
+/**
+ * @brief Escolhe o modo ao vivo e o canal do mapa de calor
+ * @param new_mode Modo
+ * @param channel Canal exibido no modo MATRIX_MODE_HEATMAP
+ */
+void matrix_set_mode(matrix_mode_t new_mode, sensor_channel_t channel) {
+    mode = new_mode;
+    heatmap_channel = channel;
+    if (mode == MATRIX_MODE_OFF)
+        clear_matrix();
+}
+
+/**
+ * @brief Define os canais em alerta, destacados em vermelho no modo ao vivo
+ * @param mask Um bit por sensor_channel_t
+ */
+void matrix_set_alerts(uint32_t mask) {
+    alert_mask = mask;
+}
+
+/**
+ * @brief Barras: uma coluna por canal agregado, altura pela posição entre mínimo e máximo desde o boot
+ */
+static void matrix_draw_bars(const history_sample_t *sample) {
+    for (int ch = 0; ch < MATRIX_SIZE && ch < HISTORY_AGG_CHANNELS; ch++) {
+        int16_t min, max;
+        int level = 1;
+        if (history_extremes(ch, &min, &max) && max > min)
+            level = 1 + ((int32_t)sample->value[ch] - min) * (MATRIX_SIZE - 1) / ((int32_t)max - min);
+        bool alert = alert_mask & (1u << ch);
+        for (int h = 0; h < MATRIX_SIZE; h++) {
+            uint32_t color = 0;
+            if (h < level) // Do verde na base ao amarelo no topo; vermelho se o canal estiver em alerta
+                color = alert ? matrix_grb(255, 0, 0) : matrix_grb(h * 255 / (MATRIX_SIZE - 1), 255, 0);
+            matrix_set_pixel(ch, MATRIX_SIZE - 1 - h, color);
+        }
     }
-    draw_matrix(pixels, pio0, 0);
+}
+
+/**
+ * @brief Mapa de calor das últimas NUM_PIXELS amostras de um canal (azul: menor, vermelho: maior)
+ */
+static void matrix_draw_heatmap(void) {
+    int16_t values[NUM_PIXELS];
+    uint32_t count = history_recent(heatmap_channel, values, NUM_PIXELS);
+    int16_t min = INT16_MAX, max = INT16_MIN;
+    for (uint32_t i = 0; i < count; i++) {
+        if (values[i] < min) min = values[i];
+        if (values[i] > max) max = values[i];
+    }
+    bool alert = alert_mask & (1u << heatmap_channel);
+    memset(frame, 0, sizeof(frame));
+    uint32_t first = NUM_PIXELS - count; // Com poucas amostras, a mais nova continua no último pixel
+    for (uint32_t i = 0; i < count; i++) {
+        int t = max > min ? ((int32_t)values[i] - min) * 255 / ((int32_t)max - min) : 128;
+        uint32_t color;
+        if (alert) { // Em alerta, só tons de vermelho
+            color = matrix_grb(64 + t * 191 / 255, 0, 0);
+        } else {
+            int r = t > 128 ? 2 * t - 255 : 0;
+            int b = t < 128 ? 255 - 2 * t : 0;
+            color = matrix_grb(r, 255 - r - b, b);
+        }
+        matrix_set_pixel((first + i) % MATRIX_SIZE, (first + i) / MATRIX_SIZE, color);
+    }
+}
+
+/**
+ * @brief Redesenha o modo ao vivo com as últimas leituras e inicia o envio
+ *
+ * Chamada a cada amostra; se o quadro anterior ainda estiver saindo, este é descartado.
+ */
+void matrix_update(void) {
+    history_sample_t sample;
+    if (mode == MATRIX_MODE_OFF || !history_latest(&sample))
+        return;
+    if (mode == MATRIX_MODE_BARS)
+        matrix_draw_bars(&sample);
+    else
+        matrix_draw_heatmap();
+    matrix_show();
 }
 
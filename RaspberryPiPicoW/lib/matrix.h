@@ -6,17 +6,24 @@
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
 #include "ws2812.pio.h"
+#include "history.h"
 
 #define WS2812_PIN 7 // Define o pino do LED RGB
 #define NUM_PIXELS 25 // Define o número de LEDs RGB
 #define FRAME_DELAY 200 // Define o atraso entre os frames
+#define MATRIX_SIZE 5 // Lado da matriz
+#define MATRIX_BRIGHTNESS 32 // Brilho máximo padrão (0-255) aplicado pela tabela de gama
+#define MATRIX_GAMMA 2.2f // Expoente da correção de gama
+#define MATRIX_FRAME_US (NUM_PIXELS * 24 * 5 / 4 + 300) // Envio de um quadro (1,25 µs por bit) + reset (> 280 µs em nível baixo)
+#define MATRIX_DEFAULT_MODE MATRIX_MODE_BARS // Modo ativo após matrix_init
 
 // Definição da estrutura RGB para representar as cores
 typedef struct {
-    double R; // Intensidade da cor vermelha
-    double G; // Intensidade da cor verde
-    double B; // Intensidade da cor azul
+    double R; // Intensidade da cor vermelha (0 a 1)
+    double G; // Intensidade da cor verde (0 a 1)
+    double B; // Intensidade da cor azul (0 a 1)
 } RGB;
 
 //Cores 
@@ -29,12 +36,27 @@ extern const RGB MAGENTA; // Magenta
 extern const RGB WHITE; // Branco
 extern const RGB BLACK; // Preto
 
+// Modos de exibição das leituras ao vivo
+typedef enum {
+    MATRIX_MODE_OFF = 0, // Apagada (ou controlada só por draw_matrix/set_leds)
+    MATRIX_MODE_BARS, // Uma coluna por canal agregado: altura = posição do valor entre o mínimo e o máximo desde o boot
+    MATRIX_MODE_HEATMAP, // Últimas 25 amostras de um canal, da mais antiga (canto superior esquerdo) à mais nova
+} matrix_mode_t;
+
 uint matrix_init(); // Inicializa a matriz de LEDs RGB
-uint32_t matrix_rgb(double r, double g, double b); // Função para converter as intensidades de cor para um valor RGB
-void set_leds(PIO pio, uint sm, double r, double g, double b); // Função para definir as cores dos LEDs
+uint32_t matrix_rgb(double r, double g, double b); // Converte intensidades de 0 a 1 para a palavra GRB com gama e brilho
+uint32_t matrix_grb(uint8_t r, uint8_t g, uint8_t b); // Converte uma cor de 8 bits para a palavra GRB com gama e brilho
+void matrix_set_brightness(uint8_t brightness); // Recalcula a tabela de gama para um novo brilho máximo
+void matrix_set_pixel(int x, int y, uint32_t grb); // Define um pixel do quadro pelas coordenadas
+bool matrix_show(void); // Envia o quadro por DMA, sem esperar
+bool matrix_busy(void); // Indica se o quadro anterior ainda está sendo enviado
+void matrix_set_mode(matrix_mode_t mode, sensor_channel_t channel); // Escolhe o modo ao vivo e o canal do mapa de calor
+void matrix_set_alerts(uint32_t mask); // Canais em alerta (bit = sensor_channel_t), destacados em vermelho
+void matrix_update(void); // Redesenha o modo ao vivo com as últimas leituras
+void set_leds(double r, double g, double b); // Função para definir as cores dos LEDs
 int getIndex(int x, int y); // Função para obter o índice do LED RGB
 void getCoordinates(int index, int *x, int *y); // Função para obter as coordenadas do LED RGB
-void draw_matrix(RGB pixels[NUM_PIXELS], PIO pio, uint sm); // Função para desenhar a matriz de LEDs RGB
+void draw_matrix(const RGB pixels[NUM_PIXELS]); // Função para desenhar a matriz de LEDs RGB
 uint coordenates_to_index(int x, int y); // Função para converter as coordenadas para o índice do LED RGB
 void clear_matrix(); // Função para apagar a matriz de LEDs RGB
 
@@ -0,0 +1,383 @@
+#include "metrics.h"
+#include <malloc.h>
+#include "pico/platform.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "hw_config.h"
+#include "button.h"
+#include "analog.h"
+#include "power.h"
+#include "rules.h"
+#include "anomaly.h"
+
+metrics_t metrics; // Contadores globais do firmware
+
+static const char *const I2C_DEVICE_NAMES[METRICS_I2C_COUNT] = {"aht20", "bmp280", "mpu6050", "ssd1306"};
+static const uint32_t LATENCY_BUCKET_LIMITS_US[METRICS_LATENCY_BUCKETS] = METRICS_LATENCY_BUCKET_LIMITS_US;
+
+extern char end; // Início do heap (definido pelo linker)
+extern char __StackLimit; // Limite superior do heap (definido pelo linker)
+
+// Etapas da geração do texto: cada uma escreve uma família completa
+enum {
+    RENDER_UPTIME = 0,
+    RENDER_BOOT,
+    RENDER_SAMPLES,
+    RENDER_I2C,
+    RENDER_PUBLISH,
+    RENDER_MQTT,
+    RENDER_HTTP,
+    RENDER_LOG,
+    RENDER_LOG_RECOVERY,
+    RENDER_LOG_WRITE,
+    RENDER_LOG_WRITE_LATENCY,
+    RENDER_LOG_COLUMNAR,
+    RENDER_LOG_QUERY,
+    RENDER_LOG_QUERY_LATENCY,
+    RENDER_DISPLAY,
+    RENDER_DISPLAY_LATENCY,
+    RENDER_INPUT,
+    RENDER_POWER,
+    RENDER_POWER_ENERGY,
+    RENDER_RULES,
+    RENDER_ANOMALY,
+    RENDER_LWIP_MEM,
+    RENDER_LWIP_MEMP_USED,
+    RENDER_LWIP_MEMP_MAX,
+    RENDER_LWIP_MEMP_AVAIL,
+    RENDER_HEAP,
+    RENDER_LOOP,
+    RENDER_DONE
+};
+
+/**
+ * @brief Lê o valor total de um contador
+ * @param counter Contador
+ * @return Soma dos slots de todos os núcleos
+ */
+uint32_t metrics_read(const metrics_counter_t *counter) {
+    uint32_t total = 0;
+    for (int i = 0; i < METRICS_NUM_CORES; i++)
+        total += counter->core[i];
+    return total;
+}
+
+/**
+ * @brief Contabiliza o resultado de uma transação I2C
+ * @param dev Dispositivo envolvido
+ * @param result Retorno da função i2c_*_timeout_us/blocking
+ * @return O próprio resultado, para uso em expressões
+ */
+int metrics_i2c(metrics_i2c_dev_t dev, int result) {
+    if (result == PICO_ERROR_TIMEOUT)
+        metrics_add(&metrics.i2c_timeouts[dev], 1);
+    else if (result < 0)
+        metrics_add(&metrics.i2c_errors[dev], 1);
+    return result;
+}
+
+/**
+ * @brief Registra o instante de uma etapa do boot (só a primeira ocorrência)
+ * @param mark Campo de metrics.boot_*_ms
+ */
+void metrics_boot_mark(volatile uint32_t *mark) {
+    if (*mark == 0)
+        *mark = to_ms_since_boot(get_absolute_time());
+}
+
+/**
+ * @brief Registra uma latência em um histograma
+ * @param hist Histograma
+ * @param us Duração em µs
+ */
+void metrics_observe(metrics_histogram_t *hist, uint32_t us) {
+    int bucket = 0;
+    while (bucket < METRICS_LATENCY_BUCKETS && us > LATENCY_BUCKET_LIMITS_US[bucket])
+        bucket++;
+    metrics_add(&hist->bucket[bucket], 1);
+    metrics_add(&hist->sum_us, us);
+}
+
+/**
+ * @brief Escreve o cabeçalho HELP/TYPE de uma família
+ */
+static void render_family(buf_writer_t *w, const char *name, const char *type, const char *help) {
+    buf_printf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Escreve uma família do tipo histograma
+ */
+static void render_histogram(buf_writer_t *w, const char *name, const char *help, const metrics_histogram_t *hist) {
+    render_family(w, name, "histogram", help);
+    uint32_t cumulative = 0;
+    for (int i = 0; i < METRICS_LATENCY_BUCKETS; i++) {
+        cumulative += metrics_read(&hist->bucket[i]);
+        buf_printf(w, "%s_bucket{le=\"%g\"} %lu\n", name, LATENCY_BUCKET_LIMITS_US[i] / 1e6, (unsigned long)cumulative);
+    }
+    cumulative += metrics_read(&hist->bucket[METRICS_LATENCY_BUCKETS]);
+    buf_printf(w, "%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)cumulative);
+    buf_printf(w, "%s_sum %.6f\n", name, metrics_read(&hist->sum_us) / 1e6);
+    buf_printf(w, "%s_count %lu\n", name, (unsigned long)cumulative);
+}
+
+/**
+ * @brief Escreve as métricas de uma etapa
+ * @param w Buffer de saída
+ * @param stage Etapa
+ */
+static void render_stage(buf_writer_t *w, uint8_t stage) {
+    switch (stage) {
+    case RENDER_UPTIME:
+        render_family(w, "datalogger_uptime_seconds", "gauge", "Time since boot.");
+        buf_printf(w, "datalogger_uptime_seconds %.3f\n", to_us_since_boot(get_absolute_time()) / 1e6);
+        break;
+
+    case RENDER_BOOT: {
+        static const struct { const volatile uint32_t *ms; const char *stage; } stages[] = {
+            {&metrics.boot_first_sample_ms, "first_sample"},
+            {&metrics.boot_wifi_up_ms, "wifi_up"},
+            {&metrics.boot_first_publish_ms, "first_publish"},
+        };
+        render_family(w, "datalogger_boot_seconds", "gauge", "Time from boot to each startup milestone.");
+        for (size_t i = 0; i < count_of(stages); i++) {
+            if (*stages[i].ms)
+                buf_printf(w, "datalogger_boot_seconds{stage=\"%s\"} %.3f\n", stages[i].stage, *stages[i].ms / 1e3);
+        }
+        break;
+    }
+
+    case RENDER_SAMPLES:
+        render_family(w, "datalogger_samples_total", "counter", "Sensor readings acquired.");
+        buf_printf(w, "datalogger_samples_total %lu\n", (unsigned long)metrics_read(&metrics.samples));
+        break;
+
+    case RENDER_I2C:
+        render_family(w, "datalogger_i2c_errors_total", "counter", "Failed I2C transactions per device.");
+        for (int i = 0; i < METRICS_I2C_COUNT; i++)
+            buf_printf(w, "datalogger_i2c_errors_total{device=\"%s\"} %lu\n", I2C_DEVICE_NAMES[i],
+                       (unsigned long)metrics_read(&metrics.i2c_errors[i]));
+        render_family(w, "datalogger_i2c_timeouts_total", "counter", "Timed out I2C transactions per device.");
+        for (int i = 0; i < METRICS_I2C_COUNT; i++)
+            buf_printf(w, "datalogger_i2c_timeouts_total{device=\"%s\"} %lu\n", I2C_DEVICE_NAMES[i],
+                       (unsigned long)metrics_read(&metrics.i2c_timeouts[i]));
+        break;
+
+    case RENDER_PUBLISH:
+        render_family(w, "datalogger_publish_total", "counter", "MQTT publish requests by outcome.");
+        buf_printf(w, "datalogger_publish_total{result=\"enqueued\"} %lu\n", (unsigned long)metrics_read(&metrics.publish_enqueued));
+        buf_printf(w, "datalogger_publish_total{result=\"acked\"} %lu\n", (unsigned long)metrics_read(&metrics.publish_acked));
+        buf_printf(w, "datalogger_publish_total{result=\"dropped\"} %lu\n", (unsigned long)metrics_read(&metrics.publish_dropped));
+        break;
+
+    case RENDER_MQTT:
+        render_family(w, "datalogger_mqtt_connects_total", "counter", "MQTT connections accepted by the broker.");
+        buf_printf(w, "datalogger_mqtt_connects_total %lu\n", (unsigned long)metrics_read(&metrics.mqtt_connects));
+        render_family(w, "datalogger_mqtt_reconnects_total", "counter", "MQTT connections accepted after the first one.");
+        buf_printf(w, "datalogger_mqtt_reconnects_total %lu\n", (unsigned long)metrics_read(&metrics.mqtt_reconnects));
+        break;
+
+    case RENDER_HTTP:
+        render_family(w, "datalogger_http_connections_total", "counter", "HTTP connections by admission outcome.");
+        buf_printf(w, "datalogger_http_connections_total{result=\"accepted\"} %lu\n", (unsigned long)metrics_read(&metrics.http_accepted));
+        buf_printf(w, "datalogger_http_connections_total{result=\"rejected\"} %lu\n", (unsigned long)metrics_read(&metrics.http_rejected));
+        buf_printf(w, "datalogger_http_connections_total{result=\"reset\"} %lu\n", (unsigned long)metrics_read(&metrics.http_reset));
+        buf_printf(w, "datalogger_http_connections_total{result=\"reaped\"} %lu\n", (unsigned long)metrics_read(&metrics.http_reaped));
+        buf_printf(w, "datalogger_http_connections_total{result=\"busy\"} %lu\n", (unsigned long)metrics_read(&metrics.http_busy));
+        break;
+
+    case RENDER_LOG:
+        render_family(w, "datalogger_log_records_total", "counter", "Binary log records by outcome.");
+        buf_printf(w, "datalogger_log_records_total{result=\"written\"} %lu\n", (unsigned long)metrics_read(&metrics.log_records));
+        buf_printf(w, "datalogger_log_records_total{result=\"dropped\"} %lu\n", (unsigned long)metrics_read(&metrics.log_dropped));
+        render_family(w, "datalogger_log_write_errors_total", "counter", "Failed SD card buffer writes.");
+        buf_printf(w, "datalogger_log_write_errors_total %lu\n", (unsigned long)metrics_read(&metrics.log_write_errors));
+        render_family(w, "datalogger_log_write_max_seconds", "gauge", "Worst time to write one log buffer to the card.");
+        buf_printf(w, "datalogger_log_write_max_seconds %.6f\n", metrics.log_write_max_us / 1e6);
+        break;
+
+    case RENDER_LOG_RECOVERY:
+        render_family(w, "datalogger_log_recoveries_total", "counter", "Interrupted log files repaired at mount.");
+        buf_printf(w, "datalogger_log_recoveries_total %lu\n", (unsigned long)metrics_read(&metrics.log_recoveries));
+        render_family(w, "datalogger_log_recovered_records_total", "counter", "Records found past the last checkpoint during recovery.");
+        buf_printf(w, "datalogger_log_recovered_records_total %lu\n", (unsigned long)metrics_read(&metrics.log_recovered_records));
+        break;
+
+    case RENDER_LOG_WRITE: {
+        // Amplificação de escrita: setores gravados no cartão / setores de registros
+        sd_card_t *sd = sd_get_by_num(0);
+        render_family(w, "datalogger_sd_sectors_written_total", "counter", "Sectors written to the SD card, by origin.");
+        buf_printf(w, "datalogger_sd_sectors_written_total{kind=\"payload\"} %lu\n", (unsigned long)metrics_read(&metrics.log_payload_sectors));
+        buf_printf(w, "datalogger_sd_sectors_written_total{kind=\"device\"} %lu\n", (unsigned long)(sd ? sd->sectors_written : 0));
+        render_family(w, "datalogger_sd_write_commands_total", "counter", "Write commands issued to the SD card.");
+        buf_printf(w, "datalogger_sd_write_commands_total %lu\n", (unsigned long)(sd ? sd->write_calls : 0));
+        render_family(w, "datalogger_sd_clock_hz", "gauge", "Negotiated SD card SPI clock.");
+        buf_printf(w, "datalogger_sd_clock_hz %lu\n", (unsigned long)(sd ? sd->baud_rate : 0));
+        render_family(w, "datalogger_sd_clock_fallbacks_total", "counter", "SD clock step-downs after CRC errors.");
+        buf_printf(w, "datalogger_sd_clock_fallbacks_total %lu\n", (unsigned long)(sd ? sd->clock_fallbacks : 0));
+        break;
+    }
+
+    case RENDER_LOG_WRITE_LATENCY:
+        render_histogram(w, "datalogger_log_write_seconds", "Time to write one log buffer to the card.", &metrics.log_write_latency);
+        break;
+
+    case RENDER_LOG_COLUMNAR:
+        // Taxa de compressão: bytes codificados / (amostras × 10 bytes de t, t_ms e valor em formato bruto)
+        render_family(w, "datalogger_log_col_blocks_total", "counter", "Columnar blocks written.");
+        buf_printf(w, "datalogger_log_col_blocks_total %lu\n", (unsigned long)metrics_read(&metrics.log_col_blocks));
+        render_family(w, "datalogger_log_col_samples_total", "counter", "Per-channel samples stored in columnar blocks.");
+        buf_printf(w, "datalogger_log_col_samples_total %lu\n", (unsigned long)metrics_read(&metrics.log_col_samples));
+        render_family(w, "datalogger_log_col_payload_bytes_total", "counter", "Delta/varint encoded bytes in columnar blocks.");
+        buf_printf(w, "datalogger_log_col_payload_bytes_total %lu\n", (unsigned long)metrics_read(&metrics.log_col_payload_bytes));
+        break;
+
+    case RENDER_LOG_QUERY:
+        render_family(w, "datalogger_log_col_query_blocks_total", "counter", "Columnar blocks visited by aggregate queries.");
+        buf_printf(w, "datalogger_log_col_query_blocks_total{mode=\"skipped\"} %lu\n", (unsigned long)metrics_read(&metrics.log_col_blocks_skipped));
+        buf_printf(w, "datalogger_log_col_query_blocks_total{mode=\"summary\"} %lu\n", (unsigned long)metrics_read(&metrics.log_col_blocks_summary));
+        buf_printf(w, "datalogger_log_col_query_blocks_total{mode=\"decoded\"} %lu\n", (unsigned long)metrics_read(&metrics.log_col_blocks_decoded));
+        break;
+
+    case RENDER_LOG_QUERY_LATENCY:
+        render_histogram(w, "datalogger_log_query_seconds", "Aggregate query time over columnar logs.", &metrics.log_query_latency);
+        break;
+
+    case RENDER_DISPLAY:
+        render_family(w, "datalogger_display_flushes_total", "counter", "Display updates that sent changed regions.");
+        buf_printf(w, "datalogger_display_flushes_total %lu\n", (unsigned long)metrics_read(&metrics.display_flushes));
+        render_family(w, "datalogger_display_bytes_total", "counter", "Bytes sent to the display over I2C, address bytes included.");
+        buf_printf(w, "datalogger_display_bytes_total %lu\n", (unsigned long)metrics_read(&metrics.display_bytes));
+        break;
+
+    case RENDER_DISPLAY_LATENCY:
+        render_histogram(w, "datalogger_display_render_seconds", "Time to draw one dashboard frame.", &metrics.display_render_latency);
+        break;
+
+    case RENDER_INPUT:
+        render_family(w, "datalogger_button_events_dropped_total", "counter", "GPIO events lost because the queue was full.");
+        buf_printf(w, "datalogger_button_events_dropped_total %lu\n", (unsigned long)button_events_dropped());
+        render_family(w, "datalogger_chip_temperature_celsius", "gauge", "RP2040 internal temperature sensor, averaged.");
+        buf_printf(w, "datalogger_chip_temperature_celsius %.1f\n", analog_temperature_c());
+        break;
+
+    case RENDER_POWER: {
+        static const char *const states[POWER_STATE_COUNT] = {"core_active", "core_sleep", "radio_off", "radio_burst", "radio_idle"};
+        render_family(w, "datalogger_power_policy", "gauge", "Active latency/energy policy.");
+        buf_printf(w, "datalogger_power_policy{policy=\"%s\"} 1\n", power_policy_name(power_get_policy()));
+        render_family(w, "datalogger_power_state_seconds_total", "counter", "Time spent in each state of the power model.");
+        for (int i = 0; i < POWER_STATE_COUNT; i++)
+            buf_printf(w, "datalogger_power_state_seconds_total{state=\"%s\"} %.3f\n", states[i], power_state_us(i) / 1e6);
+        break;
+    }
+
+    case RENDER_POWER_ENERGY:
+        render_family(w, "datalogger_energy_per_sample_mas", "gauge", "Estimated charge per sample from the duty-cycle model (mA*s).");
+        buf_printf(w, "datalogger_energy_per_sample_mas %.3f\n", power_energy_per_sample_mas());
+        render_family(w, "datalogger_sys_clock_hz", "gauge", "System clock.");
+        buf_printf(w, "datalogger_sys_clock_hz %lu\n", (unsigned long)clock_get_hz(clk_sys));
+        break;
+
+    case RENDER_RULES:
+        render_family(w, "datalogger_rule_alerts_total", "counter", "Rule state changes (firing or resolved).");
+        buf_printf(w, "datalogger_rule_alerts_total %lu\n", (unsigned long)metrics_read(&metrics.rule_alerts));
+        render_family(w, "datalogger_rule_alerting_channels", "gauge", "Channels with at least one firing rule.");
+        buf_printf(w, "datalogger_rule_alerting_channels %d\n", __builtin_popcount(rules_active_mask()));
+        break;
+
+    case RENDER_ANOMALY:
+        render_family(w, "datalogger_anomalies_total", "counter", "Statistical anomalies detected on the sensor channels.");
+        buf_printf(w, "datalogger_anomalies_total{kind=\"level\"} %lu\n", (unsigned long)metrics_read(&metrics.anomaly_level));
+        buf_printf(w, "datalogger_anomalies_total{kind=\"rate\"} %lu\n", (unsigned long)metrics_read(&metrics.anomaly_rate));
+        render_family(w, "datalogger_anomaly_spikes_filtered_total", "counter", "Outlier samples suppressed by the median spike filter.");
+        buf_printf(w, "datalogger_anomaly_spikes_filtered_total %lu\n", (unsigned long)metrics_read(&metrics.anomaly_spikes));
+        render_family(w, "datalogger_anomalous_channels", "gauge", "Channels with an anomaly in progress.");
+        buf_printf(w, "datalogger_anomalous_channels %d\n", __builtin_popcount(anomaly_active_mask()));
+        break;
+
+    case RENDER_LWIP_MEM:
+#if LWIP_STATS && MEM_STATS
+        render_family(w, "datalogger_lwip_mem_bytes", "gauge", "lwIP heap usage.");
+        buf_printf(w, "datalogger_lwip_mem_bytes{kind=\"avail\"} %lu\n", (unsigned long)lwip_stats.mem.avail);
+        buf_printf(w, "datalogger_lwip_mem_bytes{kind=\"used\"} %lu\n", (unsigned long)lwip_stats.mem.used);
+        buf_printf(w, "datalogger_lwip_mem_bytes{kind=\"max\"} %lu\n", (unsigned long)lwip_stats.mem.max);
+        render_family(w, "datalogger_lwip_mem_errors_total", "counter", "lwIP heap allocation failures.");
+        buf_printf(w, "datalogger_lwip_mem_errors_total %lu\n", (unsigned long)lwip_stats.mem.err);
+#endif
+        break;
+
+    case RENDER_LWIP_MEMP_USED:
+    case RENDER_LWIP_MEMP_MAX:
+    case RENDER_LWIP_MEMP_AVAIL: {
+#if LWIP_STATS && MEMP_STATS
+        // Uma família por etapa: as três juntas não cabem em um trecho
+        static const struct { int pool; const char *name; } pools[] = {
+            {MEMP_TCP_PCB, "tcp_pcb"},
+            {MEMP_TCP_PCB_LISTEN, "tcp_pcb_listen"},
+            {MEMP_TCP_SEG, "tcp_seg"},
+            {MEMP_PBUF, "pbuf"},
+            {MEMP_PBUF_POOL, "pbuf_pool"},
+            {MEMP_SYS_TIMEOUT, "sys_timeout"},
+        };
+        static const struct { const char *name; const char *help; } families[] = {
+            {"datalogger_lwip_memp_used", "lwIP pool elements in use."},
+            {"datalogger_lwip_memp_max", "lwIP pool high-watermark."},
+            {"datalogger_lwip_memp_avail", "lwIP pool capacity."},
+        };
+        int family = stage - RENDER_LWIP_MEMP_USED;
+        render_family(w, families[family].name, "gauge", families[family].help);
+        for (size_t i = 0; i < count_of(pools); i++) {
+            const struct stats_mem *s = lwip_stats.memp[pools[i].pool];
+            uint32_t value = family == 0 ? s->used : family == 1 ? s->max : s->avail;
+            buf_printf(w, "%s{pool=\"%s\"} %lu\n", families[family].name, pools[i].name, (unsigned long)value);
+        }
+#endif
+        break;
+    }
+
+    case RENDER_HEAP: {
+        struct mallinfo mi = mallinfo();
+        uint32_t total = &__StackLimit - &end;
+        render_family(w, "datalogger_heap_free_bytes", "gauge", "Free heap (unclaimed plus free chunks).");
+        buf_printf(w, "datalogger_heap_free_bytes %lu\n", (unsigned long)(total - mi.arena + mi.fordblks));
+        render_family(w, "datalogger_heap_high_watermark_bytes", "gauge", "Largest heap arena claimed so far.");
+        buf_printf(w, "datalogger_heap_high_watermark_bytes %lu\n", (unsigned long)mi.arena);
+        break;
+    }
+
+    case RENDER_LOOP:
+        render_histogram(w, "datalogger_loop_latency_seconds", "Main loop iteration time.", &metrics.loop_latency);
+        break;
+    }
+}
+
+/**
+ * @brief Inicia a geração do texto no formato Prometheus
+ * @param render Estado da geração
+ */
+void metrics_render_begin(metrics_render_t *render) {
+    render->stage = RENDER_UPTIME;
+}
+
+/**
+ * @brief Gera o próximo trecho do texto do /metrics
+ * @param render Estado da geração
+ * @param buf Buffer de saída
+ * @param size Tamanho do buffer
+ * @param done Indica que todas as métricas foram escritas
+ * @return Quantidade de bytes escritos
+ */
+size_t metrics_render_read(metrics_render_t *render, char *buf, size_t size, bool *done) {
+    buf_writer_t w = {.buf = buf, .size = size};
+    while (render->stage < RENDER_DONE) {
+        size_t mark = buf_mark(&w);
+        render_stage(&w, render->stage);
+        if (w.overflow) {
+            buf_rewind(&w, mark);
+            break;
+        }
+        render->stage++;
+    }
+    *done = render->stage == RENDER_DONE;
+    return w.len;
+}
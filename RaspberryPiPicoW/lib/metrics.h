@@ -0,0 +1,109 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "buf_writer.h"
+
+#define I2C_TIMEOUT_US 20000 // Tempo limite das transações I2C monitoradas
+#define METRICS_NUM_CORES 2 // Um contador por núcleo: cada núcleo só escreve no seu
+
+// Contador monotônico, um slot por núcleo; a leitura soma os núcleos
+typedef struct {
+    volatile uint32_t core[METRICS_NUM_CORES];
+} metrics_counter_t;
+
+// Dispositivos I2C monitorados
+typedef enum {
+    METRICS_I2C_AHT20 = 0,
+    METRICS_I2C_BMP280,
+    METRICS_I2C_MPU6050,
+    METRICS_I2C_SSD1306,
+    METRICS_I2C_COUNT
+} metrics_i2c_dev_t;
+
+// Limites (em µs) dos buckets dos histogramas de latência
+#define METRICS_LATENCY_BUCKETS 8
+#define METRICS_LATENCY_BUCKET_LIMITS_US {500, 1000, 5000, 10000, 50000, 100000, 250000, 1000000}
+
+// Histograma de latência (último bucket: +Inf)
+typedef struct {
+    metrics_counter_t bucket[METRICS_LATENCY_BUCKETS + 1];
+    metrics_counter_t sum_us; // Soma das latências (µs, módulo 2^32)
+} metrics_histogram_t;
+
+// Contadores do firmware
+typedef struct {
+    metrics_counter_t samples; // Leituras completas dos sensores
+    metrics_counter_t i2c_errors[METRICS_I2C_COUNT]; // Falhas de transação (NACK, etc.)
+    metrics_counter_t i2c_timeouts[METRICS_I2C_COUNT]; // Transações que estouraram o tempo limite
+    metrics_counter_t publish_enqueued; // Mensagens aceitas pelo cliente MQTT
+    metrics_counter_t publish_acked; // Mensagens confirmadas pelo broker
+    metrics_counter_t publish_dropped; // Mensagens recusadas ou com erro na confirmação
+    metrics_counter_t mqtt_connects; // Conexões aceitas pelo broker
+    metrics_counter_t mqtt_reconnects; // Conexões aceitas após a primeira
+    metrics_counter_t http_accepted; // Conexões HTTP que receberam um contexto do pool
+    metrics_counter_t http_rejected; // Conexões recusadas com 503 (pool cheio)
+    metrics_counter_t http_reset; // Conexões recusadas com RST (pool cheio e sem memória)
+    metrics_counter_t http_reaped; // Conexões descartadas por ociosidade
+    metrics_counter_t http_busy; // Requisições recusadas com 503 (respostas em streaming ocupadas)
+    metrics_counter_t log_records; // Registros aceitos pelo log binário
+    metrics_counter_t log_dropped; // Registros descartados (buffers cheios ou cartão ausente)
+    metrics_counter_t log_write_errors; // Falhas de gravação no cartão
+    volatile uint32_t log_write_max_us; // Pior tempo de gravação de um buffer
+    metrics_counter_t log_payload_sectors; // Setores de registros gravados pelo log
+    metrics_counter_t log_recoveries; // Logs interrompidos (queda de energia) corrigidos na montagem
+    metrics_counter_t log_recovered_records; // Registros achados após o último checkpoint na recuperação
+    metrics_counter_t log_col_blocks; // Blocos colunares gravados
+    metrics_counter_t log_col_samples; // Amostras (por canal) nos blocos colunares gravados
+    metrics_counter_t log_col_payload_bytes; // Bytes codificados nos blocos colunares gravados
+    metrics_counter_t log_col_blocks_skipped; // Blocos descartados pelo cabeçalho nas consultas
+    metrics_counter_t log_col_blocks_summary; // Blocos resolvidos só pelo resumo do cabeçalho
+    metrics_counter_t log_col_blocks_decoded; // Blocos decodificados nas consultas
+    metrics_counter_t display_flushes; // Envios ao display com alguma região alterada
+    metrics_counter_t rule_alerts; // Disparos e normalizações de regras de alerta
+    metrics_counter_t anomaly_level; // Anomalias de nível (z-score) detectadas
+    metrics_counter_t anomaly_rate; // Anomalias de taxa de variação detectadas
+    metrics_counter_t anomaly_spikes; // Amostras substituídas pelo filtro de mediana
+    metrics_counter_t display_bytes; // Bytes enviados ao display no barramento I2C (endereço incluso)
+    metrics_histogram_t display_render_latency; // Tempo de desenho de cada quadro do painel
+    metrics_histogram_t log_write_latency; // Tempo de gravação de cada buffer do log
+    metrics_histogram_t log_query_latency; // Tempo de cada consulta agregada
+    metrics_histogram_t loop_latency; // Tempo de cada iteração do laço principal
+    volatile uint32_t boot_first_sample_ms; // Boot até a primeira leitura (0: ainda não ocorreu)
+    volatile uint32_t boot_wifi_up_ms; // Boot até o enlace Wi-Fi subir
+    volatile uint32_t boot_first_publish_ms; // Boot até a primeira publicação confirmada
+} metrics_t;
+
+// Estado da geração do texto do /metrics
+typedef struct {
+    uint8_t stage;
+} metrics_render_t;
+
+extern metrics_t metrics;
+
+/**
+ * @brief Incrementa um contador no slot do núcleo atual
+ *
+ * O laço principal e as interrupções do mesmo núcleo escrevem no mesmo slot:
+ * o ler-somar-gravar roda com as interrupções desligadas para não perder incrementos.
+ * @param counter Contador
+ * @param value Incremento
+ */
+static inline void metrics_add(metrics_counter_t *counter, uint32_t value) {
+    uint32_t irq = save_and_disable_interrupts();
+    counter->core[get_core_num()] += value;
+    restore_interrupts(irq);
+}
+
+uint32_t metrics_read(const metrics_counter_t *counter); // Lê o valor total de um contador
+int metrics_i2c(metrics_i2c_dev_t dev, int result); // Contabiliza o resultado de uma transação I2C
+void metrics_boot_mark(volatile uint32_t *mark); // Registra o instante de uma etapa do boot (só a primeira vez)
+void metrics_observe(metrics_histogram_t *hist, uint32_t us); // Registra uma latência em um histograma
+void metrics_render_begin(metrics_render_t *render); // Inicia a geração do texto no formato Prometheus
+size_t metrics_render_read(metrics_render_t *render, char *buf, size_t size, bool *done); // Gera o próximo trecho
+
+#endif
@@ -23,24 +23,27 @@ void mpu6050_read_raw(int16_t accel[3], int16_t gyro[3], int16_t *temp) {
     uint8_t buffer[6];
 
     uint8_t val = 0x3B;
-    i2c_write_blocking(I2C_PORT, addr, &val, 1, true);
-    i2c_read_blocking(I2C_PORT, addr, buffer, 6, false);
+    if (metrics_i2c(METRICS_I2C_MPU6050, i2c_write_timeout_us(I2C_PORT, addr, &val, 1, true, I2C_TIMEOUT_US)) < 0 ||
+        metrics_i2c(METRICS_I2C_MPU6050, i2c_read_timeout_us(I2C_PORT, addr, buffer, 6, false, I2C_TIMEOUT_US)) < 0)
+        memset(buffer, 0, sizeof(buffer));
 
     for (int i = 0; i < 3; i++) {
         accel[i] = (buffer[i * 2] << 8) | buffer[(i * 2) + 1];
     }
 
     val = 0x43;
-    i2c_write_blocking(I2C_PORT, addr, &val, 1, true);
-    i2c_read_blocking(I2C_PORT, addr, buffer, 6, false);
+    if (metrics_i2c(METRICS_I2C_MPU6050, i2c_write_timeout_us(I2C_PORT, addr, &val, 1, true, I2C_TIMEOUT_US)) < 0 ||
+        metrics_i2c(METRICS_I2C_MPU6050, i2c_read_timeout_us(I2C_PORT, addr, buffer, 6, false, I2C_TIMEOUT_US)) < 0)
+        memset(buffer, 0, sizeof(buffer));
 
     for (int i = 0; i < 3; i++) {
         gyro[i] = (buffer[i * 2] << 8) | buffer[(i * 2) + 1];
     }
 
     val = 0x41;
-    i2c_write_blocking(I2C_PORT, addr, &val, 1, true);
-    i2c_read_blocking(I2C_PORT, addr, buffer, 2, false);
+    if (metrics_i2c(METRICS_I2C_MPU6050, i2c_write_timeout_us(I2C_PORT, addr, &val, 1, true, I2C_TIMEOUT_US)) < 0 ||
+        metrics_i2c(METRICS_I2C_MPU6050, i2c_read_timeout_us(I2C_PORT, addr, buffer, 2, false, I2C_TIMEOUT_US)) < 0)
+        memset(buffer, 0, sizeof(buffer));
 
     *temp = (buffer[0] << 8) | buffer[1];
 }
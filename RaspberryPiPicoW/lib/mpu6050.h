@@ -7,6 +7,7 @@
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
+#include "metrics.h"
 
 // Definição dos pinos I2C para o MPU6050
 #define I2C_PORT i2c0                 // I2C0 usa pinos 0 e 1
@@ -1,4 +1,6 @@
 #include "mqtt_client.h"
+#include "rules.h"
+#include "power.h"
 
 /* References for this implementation:
  * raspberry-pi-pico-c-sdk.pdf, Section '4.1.1. hardware_adc'
@@ -11,10 +13,31 @@
  */
 void pub_request_cb(__unused void *arg, err_t err) {
     if (err != 0) {
+        metrics_add(&metrics.publish_dropped, 1);
         ERROR_printf("pub_request_cb failed %d", err);
+    } else {
+        metrics_add(&metrics.publish_acked, 1);
+        metrics_boot_mark(&metrics.boot_first_publish_ms);
     }
 }
 
+/**
+ * @brief Publica uma mensagem e contabiliza o resultado
+ * @param state Pointer to MQTT client data
+ * @param topic Topic
+ * @param message Payload (string)
+ * @param retain Retain flag
+ * @return Result of mqtt_publish
+ */
+err_t publish_message(MQTT_CLIENT_DATA_T *state, const char *topic, const char *message, bool retain) {
+    err_t err = mqtt_publish(state->mqtt_client_inst, topic, message, strlen(message), MQTT_PUBLISH_QOS, retain, pub_request_cb, state);
+    if (err == ERR_OK)
+        metrics_add(&metrics.publish_enqueued, 1);
+    else
+        metrics_add(&metrics.publish_dropped, 1);
+    return err;
+}
+
 /*
  * @brief Generate full topic name
  * @param state Pointer to MQTT client data
@@ -44,7 +67,7 @@ void control_led(MQTT_CLIENT_DATA_T *state, bool on) {
     else
         cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
 
-    mqtt_publish(state->mqtt_client_inst, full_topic(state, "/led/state"), message, strlen(message), MQTT_PUBLISH_QOS, MQTT_PUBLISH_RETAIN, pub_request_cb, state);
+    publish_message(state, full_topic(state, "/led/state"), message, MQTT_PUBLISH_RETAIN);
 }
 
 /*
@@ -90,6 +113,8 @@ void sub_unsub_topics(MQTT_CLIENT_DATA_T* state, bool sub) {
     mqtt_sub_unsub(state->mqtt_client_inst, full_topic(state, "/print"), MQTT_SUBSCRIBE_QOS, cb, state, sub);
     mqtt_sub_unsub(state->mqtt_client_inst, full_topic(state, "/ping"), MQTT_SUBSCRIBE_QOS, cb, state, sub);
     mqtt_sub_unsub(state->mqtt_client_inst, full_topic(state, "/exit"), MQTT_SUBSCRIBE_QOS, cb, state, sub);
+    mqtt_sub_unsub(state->mqtt_client_inst, full_topic(state, RULES_TOPIC), MQTT_SUBSCRIBE_QOS, cb, state, sub);
+    mqtt_sub_unsub(state->mqtt_client_inst, full_topic(state, POWER_TOPIC), MQTT_SUBSCRIBE_QOS, cb, state, sub);
 }
 
 /*
@@ -122,10 +147,17 @@ void mqtt_incoming_data_cb(void *arg, const u8_t *data, u16_t len, u8_t flags) {
     } else if (strcmp(basic_topic, "/ping") == 0) {
         char buf[11];
         snprintf(buf, sizeof(buf), "%u", to_ms_since_boot(get_absolute_time()) / 1000);
-        mqtt_publish(state->mqtt_client_inst, full_topic(state, "/uptime"), buf, strlen(buf), MQTT_PUBLISH_QOS, MQTT_PUBLISH_RETAIN, pub_request_cb, state);
+        publish_message(state, full_topic(state, "/uptime"), buf, MQTT_PUBLISH_RETAIN);
     } else if (strcmp(basic_topic, "/exit") == 0) {
         state->stop_client = true; // stop the client when ALL subscriptions are stopped
         sub_unsub_topics(state, false); // unsubscribe
+    } else if (strcmp(basic_topic, RULES_TOPIC) == 0) {
+        rules_configure(state, state->data); // Tabela de regras de alerta
+    } else if (strcmp(basic_topic, POWER_TOPIC) == 0) {
+        // Política de energia pelo nome; um nome desconhecido mantém a atual, que é publicada de volta
+        power_set_policy(power_policy_from_name(state->data));
+        publish_message(state, full_topic(state, POWER_TOPIC "/state"), power_policy_name(power_get_policy()),
+                        MQTT_PUBLISH_RETAIN);
     } 
 }
 
@@ -153,7 +185,9 @@ void start_client(MQTT_CLIENT_DATA_T *state) {
     INFO_printf("Warning: Not using TLS\n");
 #endif
 
-    state->mqtt_client_inst = mqtt_client_new();
+    // A instância é reaproveitada nas reconexões
+    if (!state->mqtt_client_inst)
+        state->mqtt_client_inst = mqtt_client_new();
     if (!state->mqtt_client_inst) {
         panic("MQTT client instance creation error");
     }
@@ -162,7 +196,10 @@ void start_client(MQTT_CLIENT_DATA_T *state) {
 
     cyw43_arch_lwip_begin();
     if (mqtt_client_connect(state->mqtt_client_inst, &state->mqtt_server_address, port, mqtt_connection_cb, state, &state->mqtt_client_info) != ERR_OK) {
-        panic("MQTT broker connection error");
+        ERROR_printf("MQTT broker connection error\n");
+        mqtt_retry_later(state);
+        cyw43_arch_lwip_end();
+        return;
     }
 #if LWIP_ALTCP && LWIP_ALTCP_TLS
     // This is important for MBEDTLS_SSL_SERVER_NAME_INDICATION
@@ -184,7 +221,8 @@ void dns_found(const char *hostname, const ip_addr_t *ipaddr, void *arg) {
         state->mqtt_server_address = *ipaddr;
         start_client(state);
     } else {
-        panic("dns request failed");
+        ERROR_printf("dns request failed\n");
+        mqtt_retry_later(state);
     }
 }
 
@@ -261,18 +299,43 @@ void resolve_and_connect_mqtt(MQTT_CLIENT_DATA_T *state) {
     if (err == ERR_OK) {
         start_client(state);
     } else if (err != ERR_INPROGRESS) {
-        panic("DNS request failed");
+        ERROR_printf("DNS request failed %d\n", err);
+        mqtt_retry_later(state);
     }
 }
 
 /*
- * @brief Verify MQTT connection
+ * @brief Agenda a próxima tentativa de conexão, dobrando a espera até MQTT_RECONNECT_MAX_MS
  * @param state Pointer to MQTT client data
- * @return True if connected, false otherwise
  */
-bool verify_mqtt(MQTT_CLIENT_DATA_T *state) {
-    if (!state->connect_done || mqtt_client_is_connected(state->mqtt_client_inst)) {
-        cyw43_arch_poll();
-        cyw43_arch_wait_for_work_until(make_timeout_time_ms(10000));
+void mqtt_retry_later(MQTT_CLIENT_DATA_T *state) {
+    if (state->reconnect_ms < MQTT_RECONNECT_MIN_MS)
+        state->reconnect_ms = MQTT_RECONNECT_MIN_MS;
+    state->reconnect_at = make_timeout_time_ms(state->reconnect_ms);
+    INFO_printf("MQTT: nova tentativa em %lu ms\n", (unsigned long)state->reconnect_ms);
+    state->reconnect_ms = MIN(2 * state->reconnect_ms, MQTT_RECONNECT_MAX_MS);
+    state->connecting = false;
+}
+
+/*
+ * @brief Mantém a conexão MQTT: conecta quando o enlace sobe e reconecta após quedas, sem bloquear
+ * a aquisição (o progresso segue pelos callbacks do lwIP)
+ * @param state Pointer to MQTT client data
+ * @param link_up Enlace Wi-Fi ativo e com IP
+ * @return Instante em que precisa ser chamada de novo (at_the_end_of_time se só depende dos callbacks)
+ */
+absolute_time_t mqtt_service(MQTT_CLIENT_DATA_T *state, bool link_up) {
+    absolute_time_t wake = at_the_end_of_time;
+    cyw43_arch_lwip_begin();
+    if (link_up && !state->stop_client && !state->connecting &&
+        !(state->mqtt_client_inst && mqtt_client_is_connected(state->mqtt_client_inst))) {
+        if (time_reached(state->reconnect_at)) {
+            state->connecting = true;
+            resolve_and_connect_mqtt(state);
+        }
+        if (!state->connecting)
+            wake = state->reconnect_at;
     }
+    cyw43_arch_lwip_end();
+    return wake;
 }
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include "lwip/dns.h"               // Biblioteca que fornece funções e recursos suporte DNS:
 #include "lwip/altcp_tls.h"         // Biblioteca que fornece funções e recursos para conexões seguras usando TLS:
 
+#include "metrics.h"
+
 #ifndef MQTT_SERVER
 #error Need to define MQTT_SERVER
 #endif
@@ -36,6 +38,9 @@ typedef struct {
     bool connect_done;
     int subscribe_count;
     bool stop_client;
+    bool connecting; // DNS ou conexão com o broker em andamento
+    absolute_time_t reconnect_at; // Próxima tentativa de conexão
+    uint32_t reconnect_ms; // Espera antes da próxima tentativa (dobra a cada falha)
 } MQTT_CLIENT_DATA_T;
 
 #ifndef DEBUG_printf
@@ -54,9 +59,6 @@ typedef struct {
 #define ERROR_printf printf
 #endif
 
-// Temporização da coleta de temperatura - how often to measure our temperature
-#define TEMP_WORKER_TIME_S 10
-
 // Temporização da coleta de carga da bateria - how often to measure our battery charge
 #define CHARGE_WORKER_TIME_S 10
 
@@ -66,6 +68,10 @@ typedef struct {
 // Manter o programa ativo - keep alive in seconds
 #define MQTT_KEEP_ALIVE_S 60
 
+// Espera entre tentativas de reconexão com o broker: dobra a cada falha, do mínimo ao máximo
+#define MQTT_RECONNECT_MIN_MS 1000
+#define MQTT_RECONNECT_MAX_MS 60000
+
 // QoS - mqtt_subscribe
 // At most once (QoS 0)
 // At least once (QoS 1)
@@ -95,6 +101,9 @@ typedef struct {
 // Requisição para publicar
 void pub_request_cb(__unused void *arg, err_t err);
 
+// Publica uma mensagem e contabiliza o resultado
+err_t publish_message(MQTT_CLIENT_DATA_T *state, const char *topic, const char *message, bool retain);
+
 // Topico MQTT
 const char *full_topic(MQTT_CLIENT_DATA_T *state, const char *name);
 
@@ -102,7 +111,7 @@ const char *full_topic(MQTT_CLIENT_DATA_T *state, const char *name);
 void control_led(MQTT_CLIENT_DATA_T *state, bool on);
 
 // Publicar temperatura
-void publish_temperature(MQTT_CLIENT_DATA_T *state);
+void publish_temperature(MQTT_CLIENT_DATA_T *state, float temperature);
 
 // Requisição de Assinatura - subscribe
 void sub_request_cb(void *arg, err_t err);
@@ -138,10 +147,13 @@ void configure_mqtt_client(MQTT_CLIENT_DATA_T *state, const char *client_id_buf)
 // Callback function for mqtt connection status
 void resolve_and_connect_mqtt(MQTT_CLIENT_DATA_T *state);
 
-// Verifica se o cliente MQTT está ativo 
-bool verify_mqtt(MQTT_CLIENT_DATA_T *state);
+// Agenda a próxima tentativa de conexão com espera exponencial
+void mqtt_retry_later(MQTT_CLIENT_DATA_T *state);
+
+// Mantém a conexão MQTT em segundo plano; retorna quando precisa rodar de novo
+absolute_time_t mqtt_service(MQTT_CLIENT_DATA_T *state, bool link_up);
 
-// Tarefa para publicar a temperatura
-void temperature_worker_fn(async_context_t *context, async_at_time_worker_t *worker);
+// Tarefa que publica todos os canais em uma rajada
+void uplink_worker_fn(async_context_t *context, async_at_time_worker_t *worker);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "power.h"
+
+// Parâmetros de cada política
+static const struct {
+    const char *name;
+    uint32_t pm; // Modo de economia do CYW43 entre rajadas
+    uint32_t radio_ua; // Consumo estimado do rádio nesse modo
+    uint32_t uplink_ms; // Intervalo entre rajadas de publicações
+    uint32_t sys_khz; // clk_sys aplicado no boot (0: padrão do SDK)
+} POLICIES[POWER_POLICY_COUNT] = {
+    [POWER_POLICY_PERFORMANCE] = {"performance", CYW43_NONE_PM, POWER_RADIO_BURST_UA, 10000, 0},
+    [POWER_POLICY_BALANCED] = {"balanced", CYW43_DEFAULT_PM, POWER_RADIO_DEFAULT_UA, 30000, 0},
+    // PM1: dorme entre beacons e acorda só a cada três DTIM para ver o tráfego pendente
+    [POWER_POLICY_LOW_POWER] = {"low_power", cyw43_pm_value(CYW43_PM1_POWERSAVE_MODE, 10, 1, 3, 10), POWER_RADIO_LOW_UA, 60000, 48000},
+};
+
+static power_policy_t policy = POWER_DEFAULT_POLICY;
+static uint32_t sys_mhz; // clk_sys em uso, para o modelo do núcleo
+static power_state_t radio_state = POWER_RADIO_OFF;
+static uint64_t radio_since_us; // Início do estado atual do rádio
+static uint64_t state_us[POWER_STATE_COUNT]; // Tempo acumulado (núcleo ativo: calculado)
+static uint64_t radio_charge; // Carga do rádio (µA·µs), somada a cada troca de estado
+static uint32_t samples; // Amostras contabilizadas
+
+static void radio_idle_fn(async_context_t *context, async_at_time_worker_t *worker);
+static async_at_time_worker_t radio_idle_worker = { .do_work = radio_idle_fn };
+
+/**
+ * @brief Consumo estimado do rádio em um estado
+ */
+static uint32_t radio_ua(power_state_t state) {
+    if (state == POWER_RADIO_BURST)
+        return POWER_RADIO_BURST_UA;
+    if (state == POWER_RADIO_IDLE)
+        return POLICIES[policy].radio_ua;
+    return POWER_RADIO_OFF_UA;
+}
+
+/**
+ * @brief Fecha o intervalo do estado atual do rádio e passa para outro (com interrupções desligadas)
+ */
+static void radio_account(power_state_t next, uint64_t now) {
+    uint64_t elapsed = now - radio_since_us;
+    state_us[radio_state] += elapsed;
+    radio_charge += elapsed * radio_ua(radio_state);
+    radio_state = next;
+    radio_since_us = now;
+}
+
+/**
+ * @brief Troca o modo do rádio e registra o novo estado
+ */
+static void radio_set(power_state_t next, uint32_t pm) {
+    cyw43_arch_lwip_begin();
+    cyw43_wifi_pm(&cyw43_state, pm);
+    cyw43_arch_lwip_end();
+    uint32_t irq = save_and_disable_interrupts();
+    radio_account(next, time_us_64());
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Fim da rajada: volta o rádio ao modo de economia da política
+ */
+static void radio_idle_fn(async_context_t *context, async_at_time_worker_t *worker) {
+    if (radio_state == POWER_RADIO_BURST)
+        radio_set(POWER_RADIO_IDLE, POLICIES[policy].pm);
+}
+
+/**
+ * @brief Aplica o clk_sys da política; deve rodar antes da inicialização dos periféricos,
+ * que calculam seus divisores (I2C, SPI, UART, PIO) a partir dele
+ */
+void power_init(void) {
+    uint32_t khz = POLICIES[policy].sys_khz;
+    if (khz == 48000)
+        set_sys_clock_48mhz(); // clk_sys do PLL USB; o PLL do sistema fica desligado
+    else if (khz)
+        set_sys_clock_khz(khz, true);
+    sys_mhz = clock_get_hz(clk_sys) / 1000000;
+    radio_since_us = time_us_64();
+}
+
+/**
+ * @brief Troca a política; o modo do rádio e o intervalo de publicação mudam na hora,
+ * o clk_sys só no próximo boot (com POWER_DEFAULT_POLICY)
+ * @param new_policy Política
+ */
+void power_set_policy(power_policy_t new_policy) {
+    if (new_policy >= POWER_POLICY_COUNT)
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    radio_account(radio_state, time_us_64()); // O consumo até aqui é o da política anterior
+    policy = new_policy;
+    restore_interrupts(irq);
+    if (radio_state == POWER_RADIO_IDLE)
+        radio_set(POWER_RADIO_IDLE, POLICIES[policy].pm);
+}
+
+/**
+ * @brief Política ativa
+ */
+power_policy_t power_get_policy(void) {
+    return policy;
+}
+
+/**
+ * @brief Nome da política (usado no /metrics)
+ */
+const char *power_policy_name(power_policy_t p) {
+    return p < POWER_POLICY_COUNT ? POLICIES[p].name : "unknown";
+}
+
+/**
+ * @brief Procura uma política pelo nome (o mesmo do /metrics)
+ * @param name Nome
+ * @return Política, ou POWER_POLICY_COUNT se o nome é desconhecido
+ */
+power_policy_t power_policy_from_name(const char *name) {
+    for (int p = 0; p < POWER_POLICY_COUNT; p++)
+        if (strcmp(name, POLICIES[p].name) == 0)
+            return (power_policy_t)p;
+    return POWER_POLICY_COUNT;
+}
+
+/**
+ * @brief Intervalo entre rajadas de publicações da política ativa
+ * @return Intervalo em ms
+ */
+uint32_t power_uplink_interval_ms(void) {
+    return POLICIES[policy].uplink_ms;
+}
+
+/**
+ * @brief Informa o estado do enlace; com o enlace ativo, o rádio vai para o modo de economia da política
+ * @param up true se o enlace está ativo
+ */
+void power_link_up(bool up) {
+    if (up && radio_state == POWER_RADIO_OFF)
+        radio_set(POWER_RADIO_IDLE, POLICIES[policy].pm);
+    else if (!up && radio_state != POWER_RADIO_OFF) {
+        uint32_t irq = save_and_disable_interrupts();
+        radio_account(POWER_RADIO_OFF, time_us_64());
+        restore_interrupts(irq);
+    }
+}
+
+/**
+ * @brief Acorda o rádio para uma rajada de publicações; volta à economia POWER_RADIO_BURST_MS
+ * após a última rajada (a tempo de receber as confirmações sem esperar o próximo DTIM)
+ */
+void power_radio_burst(void) {
+    if (radio_state == POWER_RADIO_OFF || POLICIES[policy].pm == CYW43_NONE_PM)
+        return;
+    if (radio_state != POWER_RADIO_BURST)
+        radio_set(POWER_RADIO_BURST, CYW43_PERFORMANCE_PM);
+    async_context_t *context = cyw43_arch_async_context();
+    cyw43_arch_lwip_begin();
+    async_context_remove_at_time_worker(context, &radio_idle_worker);
+    async_context_add_at_time_worker_in_ms(context, &radio_idle_worker, POWER_RADIO_BURST_MS);
+    cyw43_arch_lwip_end();
+}
+
+/**
+ * @brief Dorme o núcleo (WFE) até o prazo ou até haver trabalho do lwIP/CYW43, contabilizando o tempo
+ * @param until Prazo
+ */
+void power_wait_until(absolute_time_t until) {
+    uint64_t start = time_us_64();
+    cyw43_arch_wait_for_work_until(until);
+    uint64_t slept = time_us_64() - start;
+    uint32_t irq = save_and_disable_interrupts();
+    state_us[POWER_CORE_SLEEP] += slept;
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Conta uma amostra (denominador da carga por amostra)
+ */
+void power_sample_done(void) {
+    samples++;
+}
+
+/**
+ * @brief Tempo acumulado em um estado desde o boot
+ * @param state Estado
+ * @return Tempo em µs
+ */
+uint64_t power_state_us(power_state_t state) {
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t now = time_us_64();
+    uint64_t us = state_us[state];
+    if (state == POWER_CORE_ACTIVE)
+        us = now - state_us[POWER_CORE_SLEEP];
+    else if (state == radio_state)
+        us += now - radio_since_us; // Intervalo em andamento
+    restore_interrupts(irq);
+    return us;
+}
+
+/**
+ * @brief Carga estimada por amostra pelo modelo de ciclo de trabalho: tempo em cada
+ * estado × consumo do estado, somado desde o boot e dividido pelas amostras
+ * @return Carga em mA·s (0 antes da primeira amostra)
+ */
+float power_energy_per_sample_mas(void) {
+    if (!samples)
+        return 0;
+    uint32_t irq = save_and_disable_interrupts();
+    uint64_t now = time_us_64();
+    uint64_t charge = radio_charge + (now - radio_since_us) * radio_ua(radio_state);
+    uint64_t sleep_us = state_us[POWER_CORE_SLEEP];
+    restore_interrupts(irq);
+    uint64_t active_us = now - sleep_us;
+    double total = (double)charge + (double)active_us * POWER_CORE_ACTIVE_UA(sys_mhz)
+                 + (double)sleep_us * POWER_CORE_SLEEP_UA(sys_mhz);
+    return (float)(total / 1e9 / samples); // µA·µs -> mA·s
+}
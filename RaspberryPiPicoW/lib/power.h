@@ -0,0 +1,58 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+#ifndef POWER_DEFAULT_POLICY
+#define POWER_DEFAULT_POLICY POWER_POLICY_BALANCED // Política ativa no boot
+#endif
+#define POWER_RADIO_BURST_MS 300 // Rádio fica em modo de desempenho após cada rajada de publicações
+#define POWER_TOPIC "/power" // Tópico de configuração da política (assinado); a política ativa sai em POWER_TOPIC "/state"
+
+// Modelo de consumo (estimativas em µA, para calibrar com medições da placa)
+#define POWER_CORE_ACTIVE_UA(mhz) (2000 + 150 * (mhz)) // Núcleo executando
+#define POWER_CORE_SLEEP_UA(mhz) (1000 + 60 * (mhz)) // Núcleo em WFE, clocks ligados
+#define POWER_RADIO_BURST_UA 18000 // CYW43 em modo de desempenho
+#define POWER_RADIO_DEFAULT_UA 8000 // CYW43 em CYW43_DEFAULT_PM (PM2)
+#define POWER_RADIO_LOW_UA 2500 // CYW43 em PM1, ouvindo um a cada três DTIM
+#define POWER_RADIO_OFF_UA 0 // Rádio sem enlace (associando ou desligado)
+
+// Compromisso entre latência e energia
+typedef enum {
+    POWER_POLICY_PERFORMANCE = 0, // Rádio sempre acordado, publicação a cada 10 s
+    POWER_POLICY_BALANCED, // Economia padrão do CYW43, publicações agrupadas a cada 30 s
+    POWER_POLICY_LOW_POWER, // PM1, publicações a cada 60 s e clk_sys de 48 MHz
+    POWER_POLICY_COUNT
+} power_policy_t;
+
+// Estados contabilizados pelo modelo de consumo
+typedef enum {
+    POWER_CORE_ACTIVE = 0,
+    POWER_CORE_SLEEP,
+    POWER_RADIO_OFF,
+    POWER_RADIO_BURST,
+    POWER_RADIO_IDLE, // Modo de economia da política
+    POWER_STATE_COUNT
+} power_state_t;
+
+void power_init(void); // Aplica o clock da política (antes de iniciar os periféricos)
+void power_set_policy(power_policy_t policy); // Troca a política (o clock só muda no próximo boot)
+power_policy_t power_get_policy(void); // Política ativa
+power_policy_t power_policy_from_name(const char *name); // Política pelo nome (POWER_POLICY_COUNT se desconhecido)
+const char *power_policy_name(power_policy_t policy); // Nome da política
+uint32_t power_uplink_interval_ms(void); // Intervalo entre rajadas de publicações
+void power_link_up(bool up); // Informa o estado do enlace Wi-Fi
+void power_radio_burst(void); // Acorda o rádio para uma rajada de publicações
+void power_wait_until(absolute_time_t until); // Dorme até o prazo ou até haver trabalho
+void power_sample_done(void); // Conta uma amostra no modelo de consumo
+uint64_t power_state_us(power_state_t state); // Tempo acumulado em um estado
+float power_energy_per_sample_mas(void); // Carga estimada por amostra (mA·s)
+
+#endif
@@ -0,0 +1,247 @@
+#include "rules.h"
+#include <string.h>
+
+static const char *const RULE_ACTION_NAMES[] = {"none", "warning", "critical"};
+
+// Regra e seu estado de avaliação
+typedef struct {
+    rule_t rule;
+    bool used;
+    bool pending; // Condição verdadeira, aguardando min_ms
+    bool active; // Disparada, aguardando normalizar
+    uint32_t since_ms; // Início da condição verdadeira
+} rule_slot_t;
+
+static rule_slot_t slots[RULES_MAX];
+static bool critical_sounding = false; // Alarme crítico tocando
+
+/**
+ * @brief Indica se o cliente MQTT pode publicar
+ */
+static bool rules_can_publish(MQTT_CLIENT_DATA_T *mqtt) {
+    return mqtt && mqtt->mqtt_client_inst && mqtt_client_is_connected(mqtt->mqtt_client_inst);
+}
+
+/**
+ * @brief Canais com alguma regra disparada
+ * @return Um bit por sensor_channel_t
+ */
+uint32_t rules_active_mask(void) {
+    uint32_t mask = 0;
+    for (int i = 0; i < RULES_MAX; i++)
+        if (slots[i].used && slots[i].active)
+            mask |= 1u << slots[i].rule.channel;
+    return mask;
+}
+
+/**
+ * @brief Atualiza a matriz e o alarme crítico a partir das regras disparadas
+ */
+static void rules_update_outputs(void) {
+    bool critical = false;
+    for (int i = 0; i < RULES_MAX; i++)
+        if (slots[i].used && slots[i].active && slots[i].rule.action == RULE_ACTION_CRITICAL)
+            critical = true;
+    if (critical && !critical_sounding)
+        play_critical_sound();
+    else if (!critical && critical_sounding)
+        buzzer_cancel(BUZZER_PRIO_CRITICAL);
+    critical_sounding = critical;
+    matrix_set_alerts(rules_active_mask());
+}
+
+/**
+ * @brief Publica o disparo ou a normalização de uma regra, sem esperar a próxima rajada de telemetria
+ */
+static void rules_publish_alert(MQTT_CLIENT_DATA_T *mqtt, int index, int16_t value, uint32_t t_ms) {
+    metrics_add(&metrics.rule_alerts, 1);
+    if (!rules_can_publish(mqtt))
+        return;
+    const rule_t *rule = &slots[index].rule;
+    char payload[192];
+    snprintf(payload, sizeof(payload),
+             "{\"rule\":%d,\"channel\":\"%s\",\"state\":\"%s\",\"value\":%g,\"threshold\":%g,\"action\":\"%s\",\"t_ms\":%lu}",
+             index, SENSOR_CHANNEL_NAMES[rule->channel], slots[index].active ? "firing" : "resolved",
+             history_to_float(rule->channel, value), history_to_float(rule->channel, rule->threshold),
+             RULE_ACTION_NAMES[rule->action], (unsigned long)t_ms);
+    power_radio_burst(); // O alerta sai agora, fora do intervalo da telemetria
+    publish_message(mqtt, full_topic(mqtt, RULES_ALERT_TOPIC), payload, MQTT_PUBLISH_RETAIN);
+}
+
+/**
+ * @brief Avalia todas as regras na amostra; chamada a cada amostra, com o lwIP bloqueado
+ *
+ * Uma regra dispara quando a condição se mantém por min_ms e só normaliza
+ * quando o valor volta além do limite pela folga (histerese), o que evita
+ * alertas repetidos com o valor oscilando em torno do limite.
+ * @param sample Amostra (formato do histórico)
+ * @param mqtt Cliente MQTT para os alertas
+ */
+void rules_evaluate(const history_sample_t *sample, MQTT_CLIENT_DATA_T *mqtt) {
+    bool changed = false;
+    for (int i = 0; i < RULES_MAX; i++) {
+        rule_slot_t *slot = &slots[i];
+        if (!slot->used)
+            continue;
+        const rule_t *rule = &slot->rule;
+        int32_t v = sample->value[rule->channel];
+        if (!slot->active) {
+            bool over = rule->op == RULE_ABOVE ? v > rule->threshold : v < rule->threshold;
+            if (!over) {
+                slot->pending = false;
+                continue;
+            }
+            if (!slot->pending) {
+                slot->pending = true;
+                slot->since_ms = sample->t_ms;
+            }
+            if (sample->t_ms - slot->since_ms < rule->min_ms)
+                continue;
+            slot->active = true;
+            slot->pending = false;
+            if (rule->action == RULE_ACTION_WARNING)
+                play_warning_sound();
+        } else {
+            bool clear = rule->op == RULE_ABOVE ? v < (int32_t)rule->threshold - rule->hysteresis
+                                                : v > (int32_t)rule->threshold + rule->hysteresis;
+            if (!clear)
+                continue;
+            slot->active = false;
+        }
+        rules_publish_alert(mqtt, i, (int16_t)v, sample->t_ms);
+        changed = true;
+    }
+    if (changed)
+        rules_update_outputs();
+}
+
+/**
+ * @brief Define ou remove uma regra; o estado de avaliação dela recomeça
+ * @param index Posição na tabela
+ * @param rule Regra (NULL: remove)
+ * @return false se a posição ou a regra forem inválidas
+ */
+bool rules_set(uint8_t index, const rule_t *rule) {
+    if (index >= RULES_MAX)
+        return false;
+    if (rule && (rule->channel >= SENSOR_CH_COUNT || rule->op > RULE_BELOW ||
+                 rule->action > RULE_ACTION_CRITICAL || rule->hysteresis < 0))
+        return false;
+    memset(&slots[index], 0, sizeof(slots[index]));
+    if (rule) {
+        slots[index].rule = *rule;
+        slots[index].used = true;
+    }
+    rules_update_outputs();
+    return true;
+}
+
+/**
+ * @brief Escreve uma regra no formato de texto aceito por rules_configure
+ */
+static void rules_format(char *buf, size_t size, const rule_t *rule) {
+    snprintf(buf, size, "%s %c %g %g %lu %s", SENSOR_CHANNEL_NAMES[rule->channel], rule->op == RULE_ABOVE ? '>' : '<',
+             history_to_float(rule->channel, rule->threshold), history_to_float(rule->channel, rule->hysteresis),
+             (unsigned long)rule->min_ms, RULE_ACTION_NAMES[rule->action]);
+}
+
+/**
+ * @brief Publica (com retain) uma posição da tabela em RULES_CURRENT_TOPIC/<posição>; vazia se removida
+ */
+static void rules_publish_slot(MQTT_CLIENT_DATA_T *mqtt, int index) {
+    if (!rules_can_publish(mqtt))
+        return;
+    char topic[32], line[RULES_LINE_LEN] = "";
+    snprintf(topic, sizeof(topic), RULES_CURRENT_TOPIC "/%d", index);
+    if (slots[index].used)
+        rules_format(line, sizeof(line), &slots[index].rule);
+    publish_message(mqtt, full_topic(mqtt, topic), line, true);
+}
+
+/**
+ * @brief Interpreta um comando de configuração
+ * @return Máscara das posições alteradas ou -1 se inválido
+ */
+static int rules_command(const char *line) {
+    unsigned index;
+    char channel[16], op[4], action[12] = "warning";
+    float threshold, hysteresis = 0;
+    unsigned long min_ms = 0;
+
+    if (strcmp(line, "clear") == 0) {
+        int changed = 0;
+        for (int i = 0; i < RULES_MAX; i++) {
+            if (slots[i].used)
+                changed |= 1 << i;
+            rules_set(i, NULL);
+        }
+        return changed;
+    }
+    int n = sscanf(line, "%u %15s %3s %f %f %lu %11s", &index, channel, op, &threshold, &hysteresis, &min_ms, action);
+    if (n < 2 || index >= RULES_MAX)
+        return -1;
+    if (n == 2 && strcmp(channel, "off") == 0)
+        return rules_set(index, NULL) ? 1 << index : -1;
+    if (n < 4)
+        return -1;
+
+    rule_t rule = {.channel = SENSOR_CH_COUNT, .min_ms = min_ms};
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        if (strcmp(channel, SENSOR_CHANNEL_NAMES[ch]) == 0)
+            rule.channel = ch;
+    if (strcmp(op, ">") == 0)
+        rule.op = RULE_ABOVE;
+    else if (strcmp(op, "<") == 0)
+        rule.op = RULE_BELOW;
+    else
+        return -1;
+    rule.action = RULE_ACTION_CRITICAL + 1;
+    for (int a = 0; a <= RULE_ACTION_CRITICAL; a++)
+        if (strcmp(action, RULE_ACTION_NAMES[a]) == 0)
+            rule.action = a;
+    if (rule.channel >= SENSOR_CH_COUNT || hysteresis < 0)
+        return -1;
+    rule.threshold = history_from_float(rule.channel, threshold);
+    rule.hysteresis = history_from_float(rule.channel, hysteresis);
+    return rules_set(index, &rule) ? 1 << index : -1;
+}
+
+/**
+ * @brief Aplica comandos de configuração recebidos pelo tópico RULES_TOPIC
+ *
+ * Um comando por linha (ou separados por ';'):
+ *   <posição> <canal> <'>'|'<'> <limite> [histerese] [min_ms] [none|warning|critical]
+ *   <posição> off
+ *   clear
+ * Ex.: "0 temperature > 30 0.5 5000 critical; 1 humidity < 20"
+ * @param mqtt Cliente MQTT (para publicar a tabela em vigor)
+ * @param text Comandos
+ * @return Quantidade de comandos inválidos (ignorados)
+ */
+int rules_configure(MQTT_CLIENT_DATA_T *mqtt, const char *text) {
+    int errors = 0;
+    while (*text) {
+        size_t len = strcspn(text, ";\n");
+        char line[RULES_LINE_LEN];
+        size_t start = strspn(text, " \t\r");
+        if (start < len) {
+            size_t n = MIN(len - start, sizeof(line) - 1);
+            memcpy(line, text + start, n);
+            while (n && (line[n - 1] == ' ' || line[n - 1] == '\t' || line[n - 1] == '\r'))
+                n--;
+            line[n] = '\0';
+            int changed = rules_command(line);
+            if (changed < 0) {
+                errors++;
+                printf("Regra inválida: %s\n", line);
+            }
+            for (int i = 0; changed > 0 && i < RULES_MAX; i++)
+                if (changed & (1 << i))
+                    rules_publish_slot(mqtt, i);
+        }
+        text += len;
+        if (*text)
+            text++;
+    }
+    return errors;
+}
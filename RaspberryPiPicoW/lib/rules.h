@@ -0,0 +1,49 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "history.h"
+#include "mqtt_client.h"
+#include "buzzer.h"
+#include "matrix.h"
+#include "power.h"
+#include "metrics.h"
+
+#define RULES_MAX 8 // Regras na tabela
+#define RULES_TOPIC "/rules" // Tópico de configuração (assinado)
+#define RULES_CURRENT_TOPIC "/rules/current" // Tabela em vigor (publicada com retain após cada mudança)
+#define RULES_ALERT_TOPIC "/alert" // Alertas (disparo e normalização)
+#define RULES_LINE_LEN 64 // Maior linha de uma regra no formato de texto
+
+// Comparação que dispara a regra
+typedef enum {
+    RULE_ABOVE = 0, // valor > limite
+    RULE_BELOW // valor < limite
+} rule_op_t;
+
+// Ação local ao disparar (o alerta MQTT é sempre publicado)
+typedef enum {
+    RULE_ACTION_NONE = 0, // Só o alerta MQTT e a matriz
+    RULE_ACTION_WARNING, // Som de alerta e LED amarelo
+    RULE_ACTION_CRITICAL // Alarme contínuo até a regra normalizar
+} rule_action_t;
+
+// Regra de limite, com os valores no formato do histórico (ponto fixo por canal)
+typedef struct {
+    uint8_t channel; // sensor_channel_t
+    uint8_t op; // rule_op_t
+    uint8_t action; // rule_action_t
+    int16_t threshold; // Limite
+    int16_t hysteresis; // Folga para normalizar (>= 0)
+    uint32_t min_ms; // Tempo mínimo acima/abaixo do limite antes de disparar
+} rule_t;
+
+void rules_evaluate(const history_sample_t *sample, MQTT_CLIENT_DATA_T *mqtt); // Avalia as regras na amostra (O(regras))
+int rules_configure(MQTT_CLIENT_DATA_T *mqtt, const char *text); // Aplica comandos de configuração em texto
+bool rules_set(uint8_t index, const rule_t *rule); // Define ou remove (rule NULL) uma regra
+uint32_t rules_active_mask(void); // Canais com alguma regra disparada (um bit por sensor_channel_t)
+
+#endif
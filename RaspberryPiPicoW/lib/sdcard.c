@@ -1,4 +1,4 @@
-#include "drivers/sdcard.h"
+#include "sdcard.h"
 
 /**
  * @brief Obtém o cartão SD pelo nome
@@ -26,6 +26,23 @@ FATFS *sd_get_fs_by_name(const char *name){
     return NULL;
 }
 
+/**
+ * @brief Monta o cartão SD padrão (sem passar pelo interpretador de comandos)
+ * @return true se o cartão foi montado
+ */
+bool sdcard_mount(void){
+    sd_card_t *pSD = sd_get_by_num(0);
+    FRESULT fr = f_mount(&pSD->fatfs, pSD->pcName, 1);
+    if (FR_OK != fr)
+    {
+        printf("f_mount error: %s (%d)\n", FRESULT_str(fr), fr);
+        return false;
+    }
+    pSD->mounted = true;
+    printf("Processo de montagem do SD ( %s ) concluído\n", pSD->pcName);
+    return true;
+}
+
 /**
  * @brief Configura a data e hora do RTC
  */
@@ -28,6 +28,7 @@ typedef struct
 
 sd_card_t *sd_get_by_name(const char *const name); // Obtém o cartão SD pelo nome
 FATFS *sd_get_fs_by_name(const char *name); // Obtém o sistema de arquivos pelo nome
+bool sdcard_mount(void); // Monta o cartão SD padrão
 void run_setrtc(void); // Configura a data e hora do RTC
 void run_format(void); // Formata o cartão SD
 void run_mount(void); // Monta o cartão SD
@@ -2,6 +2,12 @@
 
 static struct bmp280_calib_param bmp_params;
 
+const char *const SENSOR_CHANNEL_NAMES[SENSOR_CH_COUNT] = {
+    "temperature", "humidity", "altitude", "gyroscope", "acceleration",
+    "gyroscope_x", "gyroscope_y", "gyroscope_z",
+    "acceleration_x", "acceleration_y", "acceleration_z"
+};
+
 /**
  * @brief Inicializa a comunicação I2C com os sensores
  */
@@ -105,3 +111,26 @@ SensorReadings get_sensor_readings(void) {
 
     return data;
 }
+
+/**
+ * @brief Obtém o valor de um canal a partir de uma leitura
+ * @param readings Leitura dos sensores
+ * @param channel Canal desejado
+ * @return Valor do canal
+ */
+float sensor_channel_value(const SensorReadings *readings, sensor_channel_t channel) {
+    switch (channel) {
+        case SENSOR_CH_TEMPERATURE:    return readings->temperature;
+        case SENSOR_CH_HUMIDITY:       return readings->humidity;
+        case SENSOR_CH_ALTITUDE:       return readings->altitude;
+        case SENSOR_CH_GYROSCOPE:      return readings->gyroscope;
+        case SENSOR_CH_ACCELERATION:   return readings->acceleration;
+        case SENSOR_CH_GYROSCOPE_X:    return readings->gyroscope_x;
+        case SENSOR_CH_GYROSCOPE_Y:    return readings->gyroscope_y;
+        case SENSOR_CH_GYROSCOPE_Z:    return readings->gyroscope_z;
+        case SENSOR_CH_ACCELERATION_X: return readings->acceleration_x;
+        case SENSOR_CH_ACCELERATION_Y: return readings->acceleration_y;
+        case SENSOR_CH_ACCELERATION_Z: return readings->acceleration_z;
+        default:                       return 0.0f;
+    }
+}
@@ -9,6 +9,7 @@
 #define I2C_SDA 0
 #define I2C_SCL 1
 #define SEA_LEVEL_PRESSURE 101925.0
+#define SENSOR_SAMPLE_PERIOD_MS 500 // Período de amostragem dos sensores
 
 typedef struct {
     float temperature;
@@ -25,10 +26,29 @@ typedef struct {
     char timestamp[20];
 } SensorReadings;
 
+// Canais de medição, na mesma ordem dos campos de SensorReadings
+typedef enum {
+    SENSOR_CH_TEMPERATURE = 0,
+    SENSOR_CH_HUMIDITY,
+    SENSOR_CH_ALTITUDE,
+    SENSOR_CH_GYROSCOPE,
+    SENSOR_CH_ACCELERATION,
+    SENSOR_CH_GYROSCOPE_X,
+    SENSOR_CH_GYROSCOPE_Y,
+    SENSOR_CH_GYROSCOPE_Z,
+    SENSOR_CH_ACCELERATION_X,
+    SENSOR_CH_ACCELERATION_Y,
+    SENSOR_CH_ACCELERATION_Z,
+    SENSOR_CH_COUNT
+} sensor_channel_t;
+
+extern const char *const SENSOR_CHANNEL_NAMES[SENSOR_CH_COUNT]; // Nomes dos canais (iguais aos tópicos MQTT)
+
 void init_i2c_sensor(void);
 void init_bmp280();
 void init_aht20();
 SensorReadings get_sensor_readings();
 double calculate_altitude(double pressure);
+float sensor_channel_value(const SensorReadings *readings, sensor_channel_t channel); // Obtém o valor de um canal
 
 #endif
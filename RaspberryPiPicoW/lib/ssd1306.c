@@ -1,6 +1,59 @@
 #include "ssd1306.h"
 #include "font.h"
 
+/**
+ * @brief Junta as colunas x0..x1 à região alterada de uma página
+ * @param ssd Ponteiro para a estrutura do display
+ * @param page Página
+ * @param x0 Primeira coluna
+ * @param x1 Última coluna
+ */
+static inline void ssd1306_dirty_add(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1) {
+  if (ssd->dirty_x0[page] > ssd->dirty_x1[page]) { // Página limpa
+    ssd->dirty_x0[page] = x0;
+    ssd->dirty_x1[page] = x1;
+    return;
+  }
+  if (x0 < ssd->dirty_x0[page])
+    ssd->dirty_x0[page] = x0;
+  if (x1 > ssd->dirty_x1[page])
+    ssd->dirty_x1[page] = x1;
+}
+
+/**
+ * @brief Marca todas as páginas como limpas
+ * @param ssd Ponteiro para a estrutura do display
+ */
+static void ssd1306_dirty_clear(ssd1306_t *ssd) {
+  memset(ssd->dirty_x0, 0xFF, sizeof(ssd->dirty_x0));
+  memset(ssd->dirty_x1, 0, sizeof(ssd->dirty_x1));
+}
+
+/**
+ * @brief Recorta a região alterada de uma página às colunas que diferem do que o display mostra
+ *
+ * Apagar e redesenhar o mesmo conteúdo marca a região sem mudar o quadro.
+ * @param ssd Ponteiro para a estrutura do display
+ * @param page Página
+ */
+static void ssd1306_dirty_trim(ssd1306_t *ssd, uint8_t page) {
+  const uint8_t *ram = ssd->ram_buffer + 1 + page;
+  const uint8_t *shown = ssd->shown + page;
+  uint16_t x0 = ssd->dirty_x0[page];
+  uint16_t x1 = ssd->dirty_x1[page];
+  while (x0 <= x1 && ram[x0 * ssd->pages] == shown[x0 * ssd->pages])
+    x0++;
+  while (x1 > x0 && ram[x1 * ssd->pages] == shown[x1 * ssd->pages])
+    x1--;
+  if (x0 > x1) { // Nada mudou de fato
+    ssd->dirty_x0[page] = 0xFF;
+    ssd->dirty_x1[page] = 0;
+    return;
+  }
+  ssd->dirty_x0[page] = x0;
+  ssd->dirty_x1[page] = x1;
+}
+
 /**
  * @brief Inicializa o display OLED SSD1306
  * @param ssd Ponteiro para a estrutura do display
@@ -18,8 +71,24 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->i2c_port = i2c;
   ssd->bufsize = ssd->pages * ssd->width + 1;
   ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
-  ssd->ram_buffer[0] = 0x40;
+  ssd->ram_buffer[0] = SSD1306_CTRL_DATA;
   ssd->port_buffer[0] = 0x80;
+  ssd1306_dirty_clear(ssd);
+  ssd->shown = calloc(ssd->bufsize - 1, sizeof(uint8_t));
+  ssd->tx_words = calloc(SSD1306_TX_WORDS, sizeof(uint16_t));
+  ssd->flushing = false;
+  ssd->flush_start = get_absolute_time();
+
+  // DMA: palavras de 16 bits (byte + bit de STOP) direto na FIFO de transmissão do I2C
+  ssd->dma_channel = dma_claim_unused_channel(true);
+  dma_channel_config cfg = dma_channel_get_default_config(ssd->dma_channel);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, i2c_get_dreq(i2c, true));
+  dma_channel_configure(ssd->dma_channel, &cfg, &i2c_get_hw(i2c)->data_cmd, NULL, 0, false);
+
+  ssd1306_mark_dirty(ssd, 0, ssd->width - 1, 0, ssd->pages - 1); // A RAM do display começa com lixo
 }
 
 /**
@@ -27,31 +96,102 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
  * @param ssd Ponteiro para a estrutura do display
  */
 void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
+  static const uint8_t config[] = {
+    SET_DISP | 0x00,
+    SET_MEM_ADDR, 0x01, // Endereçamento vertical: a RAM é percorrida coluna a coluna, como o buffer
+    SET_DISP_START_LINE | 0x00,
+    SET_SEG_REMAP | 0x01,
+    SET_MUX_RATIO, HEIGHT - 1,
+    SET_COM_OUT_DIR | 0x08,
+    SET_DISP_OFFSET, 0x00,
+    SET_COM_PIN_CFG, 0x12,
+    SET_DISP_CLK_DIV, 0x80,
+    SET_PRECHARGE, 0xF1,
+    SET_VCOM_DESEL, 0x30,
+    SET_CONTRAST, 0xFF,
+    SET_ENTIRE_ON,
+    SET_NORM_INV,
+    SET_CHARGE_PUMP, 0x14,
+    SET_DISP | 0x01,
+  };
+  ssd1306_commands(ssd, config, sizeof(config));
+}
+
+/**
+ * @brief Aplica bits a uma faixa de colunas de uma página (base de todas as primitivas)
+ *
+ * Cada byte do buffer guarda 8 linhas de uma coluna; só os bits de mask mudam.
+ * @param ssd Ponteiro para a estrutura do display
+ * @param x0 Primeira coluna
+ * @param x1 Última coluna (já recortada à largura)
+ * @param page Página
+ * @param mask Bits (linhas) afetados
+ * @param bits Novo valor desses bits
+ */
+static void ssd1306_span(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page, uint8_t mask, uint8_t bits) {
+  uint8_t *byte = ssd->ram_buffer + 1 + (size_t)x0 * ssd->pages + page;
+  int16_t first = -1, last = -1;
+  bits &= mask;
+  for (uint16_t x = x0; x <= x1; ++x, byte += ssd->pages) {
+    uint8_t value = (*byte & ~mask) | bits;
+    if (value != *byte) {
+      *byte = value;
+      if (first < 0)
+        first = x;
+      last = x;
+    }
+  }
+  if (first >= 0)
+    ssd1306_dirty_add(ssd, page, first, last);
+}
+
+/**
+ * @brief Preenche (ou apaga) a região x0..x1 x y0..y1, limites inclusos e recortados ao display
+ * @param ssd Ponteiro para a estrutura do display
+ * @param x0 Primeira coluna
+ * @param x1 Última coluna
+ * @param y0 Primeira linha
+ * @param y1 Última linha
+ * @param value Valor dos pixels
+ */
+static void ssd1306_fill_area(ssd1306_t *ssd, int x0, int x1, int y0, int y1, bool value) {
+  if (x0 < 0)
+    x0 = 0;
+  if (y0 < 0)
+    y0 = 0;
+  if (x1 >= ssd->width)
+    x1 = ssd->width - 1;
+  if (y1 >= ssd->height)
+    y1 = ssd->height - 1;
+  if (x0 > x1 || y0 > y1)
+    return;
+  uint8_t bits = value ? 0xFF : 0x00;
+  for (int page = y0 >> 3; page <= y1 >> 3; ++page) {
+    uint8_t mask = 0xFF;
+    if (page == y0 >> 3)
+      mask &= 0xFF << (y0 & 7);
+    if (page == y1 >> 3)
+      mask &= 0xFF >> (7 - (y1 & 7));
+    ssd1306_span(ssd, x0, x1, page, mask, bits);
+  }
+}
+
+/**
+ * @brief Envia um buffer já montado (byte de controle incluso) ao display
+ * @param ssd Ponteiro para a estrutura do display
+ * @param buf Bytes a enviar
+ * @param len Quantidade de bytes
+ */
+static void ssd1306_write(ssd1306_t *ssd, const uint8_t *buf, size_t len) {
+  ssd1306_wait(ssd); // O barramento é do DMA até o fim do envio
+  metrics_add(&metrics.display_bytes, len + 1); // + endereço
+  metrics_i2c(METRICS_I2C_SSD1306, i2c_write_blocking(
+    ssd->i2c_port,
+    ssd->address,
+    buf,
+    len,
+    false
+  ));
 }
 
 /**
@@ -61,33 +201,210 @@ void ssd1306_config(ssd1306_t *ssd) {
  */
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   ssd->port_buffer[1] = command;
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->port_buffer,
-    2,
-    false
-  );
+  ssd1306_write(ssd, ssd->port_buffer, 2);
+}
+
+/**
+ * @brief Envia vários comandos em uma única transação I2C
+ * @param ssd Ponteiro para a estrutura do display
+ * @param commands Comandos e seus argumentos, em ordem
+ * @param count Quantidade de bytes (no máximo 31)
+ */
+void ssd1306_commands(ssd1306_t *ssd, const uint8_t *commands, size_t count) {
+  uint8_t buf[32];
+  if (count >= sizeof(buf))
+    count = sizeof(buf) - 1;
+  buf[0] = SSD1306_CTRL_CMD; // Co = 0: todos os bytes seguintes são comandos
+  memcpy(buf + 1, commands, count);
+  ssd1306_write(ssd, buf, count + 1);
+}
+
+/**
+ * @brief Marca uma região para ser enviada no próximo ssd1306_send_data
+ * @param ssd Ponteiro para a estrutura do display
+ * @param x0 Primeira coluna
+ * @param x1 Última coluna
+ * @param page0 Primeira página
+ * @param page1 Última página
+ */
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  for (uint8_t page = page0; page <= page1 && page < SSD1306_PAGES; ++page) {
+    ssd1306_dirty_add(ssd, page, x0, x1);
+    ssd->shown_stale |= 1u << page; // Envia mesmo que o buffer pareça igual ao display
+  }
 }
 
 /**
- * @brief Envia dados para o display OLED SSD1306
+ * @brief Acrescenta uma transação I2C (byte de controle + bytes) à fila do DMA
+ *
+ * O último byte leva o bit de STOP; o controlador abre a transação seguinte
+ * sozinho, com o mesmo endereço, ao encontrar mais palavras na FIFO.
+ * @param ssd Ponteiro para a estrutura do display
+ * @param words Posição atual na fila (avança)
+ * @param control Byte de controle (SSD1306_CTRL_CMD ou SSD1306_CTRL_DATA)
+ * @param data Bytes da transação
+ * @param len Quantidade de bytes
+ */
+static void ssd1306_queue(ssd1306_t *ssd, size_t *words, uint8_t control, const uint8_t *data, size_t len) {
+  uint16_t *out = ssd->tx_words + *words;
+  *out++ = control;
+  for (size_t i = 0; i < len; ++i)
+    *out++ = data[i];
+  out[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  *words += len + 1;
+  metrics_add(&metrics.display_bytes, len + 2); // + endereço e byte de controle
+}
+
+/**
+ * @brief Copia para a fila do DMA uma janela de colunas x páginas do buffer
+ * @param ssd Ponteiro para a estrutura do display
+ * @param words Posição atual na fila (avança)
+ * @param x0 Primeira coluna
+ * @param x1 Última coluna
+ * @param page0 Primeira página
+ * @param page1 Última página
+ */
+static void ssd1306_queue_window(ssd1306_t *ssd, size_t *words, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  const uint8_t window[] = {SET_COL_ADDR, x0, x1, SET_PAGE_ADDR, page0, page1};
+  ssd1306_queue(ssd, words, SSD1306_CTRL_CMD, window, sizeof(window));
+
+  // Endereçamento vertical: o display recebe coluna a coluna, page0..page1 em cada uma
+  uint8_t height = page1 - page0 + 1;
+  if (height == ssd->pages) {
+    ssd1306_queue(ssd, words, SSD1306_CTRL_DATA, ssd->ram_buffer + 1 + (size_t)x0 * ssd->pages,
+                  (size_t)(x1 - x0 + 1) * ssd->pages);
+    return;
+  }
+  uint16_t *out = ssd->tx_words + *words;
+  *out++ = SSD1306_CTRL_DATA;
+  for (uint16_t x = x0; x <= x1; ++x) {
+    const uint8_t *column = ssd->ram_buffer + 1 + (size_t)x * ssd->pages + page0;
+    for (uint8_t page = 0; page < height; ++page)
+      *out++ = column[page];
+  }
+  out[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  size_t len = (size_t)(x1 - x0 + 1) * height;
+  *words += len + 1;
+  metrics_add(&metrics.display_bytes, len + 2);
+}
+
+/**
+ * @brief Inicia por DMA o envio das regiões alteradas desde o último envio, sem esperar
+ *
+ * Cada região é antes recortada às colunas que diferem do último envio.
+ * Páginas alteradas vizinhas são enviadas numa mesma janela (união das colunas)
+ * quando isso custa menos bytes no barramento do que abrir uma janela nova.
+ * As regiões são copiadas para a fila do DMA (buffer de frente), então o
+ * próximo quadro já pode ser desenhado em ram_buffer durante a transferência.
+ * @param ssd Ponteiro para a estrutura do display
+ * @return false se o envio anterior ainda não terminou (as regiões continuam marcadas)
+ */
+bool ssd1306_flush(ssd1306_t *ssd) {
+  if (ssd1306_busy(ssd))
+    return false;
+
+  for (uint8_t page = 0; page < ssd->pages; ++page)
+    if (ssd->dirty_x0[page] <= ssd->dirty_x1[page] && !(ssd->shown_stale & (1u << page)))
+      ssd1306_dirty_trim(ssd, page);
+
+  size_t words = 0;
+  uint8_t page = 0;
+  while (page < ssd->pages) {
+    if (ssd->dirty_x0[page] > ssd->dirty_x1[page]) {
+      page++;
+      continue;
+    }
+    uint8_t page0 = page;
+    uint8_t x0 = ssd->dirty_x0[page];
+    uint8_t x1 = ssd->dirty_x1[page];
+    while (page + 1 < ssd->pages && ssd->dirty_x0[page + 1] <= ssd->dirty_x1[page + 1]) {
+      uint8_t nx0 = MIN(x0, ssd->dirty_x0[page + 1]);
+      uint8_t nx1 = MAX(x1, ssd->dirty_x1[page + 1]);
+      uint32_t merged = (nx1 - nx0 + 1) * (page + 2 - page0);
+      uint32_t separate = (x1 - x0 + 1) * (page + 1 - page0) +
+                          (ssd->dirty_x1[page + 1] - ssd->dirty_x0[page + 1] + 1) + SSD1306_WINDOW_OVERHEAD;
+      if (merged > separate)
+        break;
+      x0 = nx0;
+      x1 = nx1;
+      page++;
+    }
+    ssd1306_queue_window(ssd, &words, x0, x1, page0, page);
+    page++;
+  }
+  ssd1306_dirty_clear(ssd);
+  memcpy(ssd->shown, ssd->ram_buffer + 1, ssd->bufsize - 1); // Fora das regiões o display já era igual
+  ssd->shown_stale = 0;
+  if (!words)
+    return true;
+
+  metrics_add(&metrics.display_flushes, 1);
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->enable = 0; // O endereço do escravo só muda com o controlador desligado
+  hw->tar = ssd->address;
+  hw->enable = 1;
+  ssd->flushing = true;
+  ssd->flush_start = get_absolute_time();
+  dma_channel_transfer_from_buffer_now(ssd->dma_channel, ssd->tx_words, words);
+  return true;
+}
+
+/**
+ * @brief Indica se o envio por DMA ainda está em andamento
+ *
+ * Ao detectar o fim, contabiliza abortos (NACK) e envios que estouraram o tempo limite.
+ * @param ssd Ponteiro para a estrutura do display
+ * @return true enquanto o DMA ou o controlador I2C ainda estiverem transmitindo
+ */
+bool ssd1306_busy(ssd1306_t *ssd) {
+  if (!ssd->flushing)
+    return false;
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  bool busy = dma_channel_is_busy(ssd->dma_channel) || !(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+              (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+  if (busy) {
+    if (absolute_time_diff_us(ssd->flush_start, get_absolute_time()) < SSD1306_FLUSH_TIMEOUT_MS * 1000)
+      return true;
+    dma_channel_abort(ssd->dma_channel);
+    hw->enable = 0; // Descarta o que restou na FIFO
+    hw->enable = 1;
+    metrics_i2c(METRICS_I2C_SSD1306, PICO_ERROR_TIMEOUT);
+  } else if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    (void)hw->clr_tx_abrt; // A leitura limpa o aborto e libera a FIFO
+    metrics_i2c(METRICS_I2C_SSD1306, PICO_ERROR_GENERIC);
+  }
+  ssd->flushing = false;
+  return false;
+}
+
+/**
+ * @brief Espera o fim do envio em andamento
+ * @param ssd Ponteiro para a estrutura do display
+ */
+void ssd1306_wait(ssd1306_t *ssd) {
+  while (ssd1306_busy(ssd))
+    tight_loop_contents();
+}
+
+/**
+ * @brief Indica se já é hora de gerar e enviar o próximo quadro
+ * @param ssd Ponteiro para a estrutura do display
+ * @return true se o envio anterior terminou e SSD1306_FRAME_MS já se passou desde seu início
+ */
+bool ssd1306_frame_due(ssd1306_t *ssd) {
+  if (ssd1306_busy(ssd))
+    return false;
+  return absolute_time_diff_us(ssd->flush_start, get_absolute_time()) >= SSD1306_FRAME_MS * 1000;
+}
+
+/**
+ * @brief Envia ao display só as regiões alteradas e espera o fim da transferência
  * @param ssd Ponteiro para a estrutura do display
  */
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  ssd1306_wait(ssd);
+  ssd1306_flush(ssd);
+  ssd1306_wait(ssd);
 }
 
 /**
@@ -98,12 +415,19 @@ void ssd1306_send_data(ssd1306_t *ssd) {
  * @param value Valor do pixel
  */
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
   uint16_t index = (y >> 3) + (x << 3) + 1;
   uint8_t pixel = (y & 0b111);
+  uint8_t byte = ssd->ram_buffer[index];
   if (value)
-    ssd->ram_buffer[index] |= (1 << pixel);
+    byte |= (1 << pixel);
   else
-    ssd->ram_buffer[index] &= ~(1 << pixel);
+    byte &= ~(1 << pixel);
+  if (byte == ssd->ram_buffer[index])
+    return; // Sem mudança: a região continua limpa
+  ssd->ram_buffer[index] = byte;
+  ssd1306_dirty_add(ssd, y >> 3, x, x);
 }
 
 /**
@@ -112,12 +436,7 @@ void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
  * @param value Valor do pixel
  */
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  ssd1306_fill_area(ssd, 0, ssd->width - 1, 0, ssd->height - 1, value);
 }
 
 /**
@@ -131,22 +450,16 @@ void ssd1306_fill(ssd1306_t *ssd, bool value) {
  * @param fill Preenche o retângulo
  */
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
-
-  if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
-  }
+  if (!width || !height)
+    return;
+  int right = left + width - 1;
+  int bottom = top + height - 1;
+  ssd1306_fill_area(ssd, left, right, top, top, value); // Bordas
+  ssd1306_fill_area(ssd, left, right, bottom, bottom, value);
+  ssd1306_fill_area(ssd, left, left, top, bottom, value);
+  ssd1306_fill_area(ssd, right, right, top, bottom, value);
+  if (fill)
+    ssd1306_fill_area(ssd, left + 1, right - 1, top + 1, bottom - 1, value);
 }
 
 /**
@@ -195,8 +508,7 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
  * @param value Valor do pixel
  */
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  ssd1306_fill_area(ssd, x0, x1, y, y, value);
 }
 
 /**
@@ -208,8 +520,7 @@ void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value
  * @param value Valor do pixel
  */
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  ssd1306_fill_area(ssd, x, x, y0, y1, value);
 }
 
 /**
@@ -220,16 +531,18 @@ void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value
  * @param y Posição y do caractere
  */
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y){
-  uint16_t index = (c - ' ') * 8;
-  char ver=c;
-  
-  for (uint8_t i = 0; i < 8; ++i)
-  {
-    uint8_t line = font[index + i];
-    for (uint8_t j = 0; j < 8; ++j)
-    {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j));
-    }
+  if (c < ' ' || (size_t)(c - ' ') * 8 >= sizeof(font))
+    c = ' '; // Fora da fonte
+  const uint8_t *glyph = &font[(c - ' ') * 8];
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+
+  // Cada coluna do glifo é um byte: desloca e grava na página de y e, se desalinhado, na seguinte
+  for (uint8_t i = 0; i < 8 && x + i < ssd->width; ++i) {
+    if (page < ssd->pages)
+      ssd1306_span(ssd, x + i, x + i, page, 0xFF << shift, glyph[i] << shift);
+    if (shift && page + 1 < ssd->pages)
+      ssd1306_span(ssd, x + i, x + i, page + 1, 0xFF >> (8 - shift), glyph[i] >> (8 - shift));
   }
 }
 
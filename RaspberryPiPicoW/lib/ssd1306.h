@@ -5,7 +5,10 @@
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "hardware/timer.h"
+#include "hardware/dma.h"
+#include "metrics.h"
 #include <stdio.h>
+#include <string.h>
 
 // Definição dos parâmetros do display OLED
 #define SSD1306_WIDTH 128 // Largura do display
@@ -16,6 +19,13 @@
 #define HEIGHT 64 // Altura
 #define I2C_SDA_DISP 14 // Pino SDA
 #define I2C_SCL_DISP 15 // Pino SCL
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8) // Páginas de 8 linhas (o buffer é organizado por coluna, 8 bytes cada)
+#define SSD1306_WINDOW_OVERHEAD 10 // Bytes extras no barramento para abrir uma janela (comandos + cabeçalho dos dados)
+#define SSD1306_TX_WORDS (SSD1306_PAGES * (SSD1306_WIDTH + 8)) // Fila do DMA: quadro inteiro + comandos de até uma janela por página
+#define SSD1306_FRAME_MS 50 // Intervalo mínimo entre quadros (20 fps) sugerido por ssd1306_frame_due
+#define SSD1306_FLUSH_TIMEOUT_MS 100 // Envio por DMA que não termina nesse tempo é abortado
+#define SSD1306_CTRL_CMD 0x00 // Byte de controle: sequência de comandos
+#define SSD1306_CTRL_DATA 0x40 // Byte de controle: sequência de dados
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -45,12 +55,26 @@ typedef struct {
   uint8_t *ram_buffer; // Buffer de memória
   size_t bufsize; // Tamanho do buffer
   uint8_t port_buffer[2]; // Buffer de porta
+  uint8_t dirty_x0[SSD1306_PAGES]; // Primeira coluna alterada em cada página (maior que dirty_x1: página limpa)
+  uint8_t dirty_x1[SSD1306_PAGES]; // Última coluna alterada em cada página
+  uint8_t *shown; // O que a RAM do display contém: cópia do buffer (sem o byte de controle) no último envio
+  uint8_t shown_stale; // Páginas (bits) em que a cópia não vale e a região marcada vai inteira
+  uint16_t *tx_words; // Buffer de frente: palavras DATA_CMD do envio em andamento (o DMA lê daqui)
+  int dma_channel; // Canal DMA que alimenta a FIFO de transmissão do I2C
+  bool flushing; // Envio por DMA em andamento
+  absolute_time_t flush_start; // Início do último envio
 } ssd1306_t; 
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c); // Inicializa o display OLED SSD1306
 void ssd1306_config(ssd1306_t *ssd);  // Configura o display OLED SSD1306
 void ssd1306_command(ssd1306_t *ssd, uint8_t command); // Envia um comando para o display OLED SSD1306
-void ssd1306_send_data(ssd1306_t *ssd); // Envia dados para o display OLED SSD1306
+void ssd1306_commands(ssd1306_t *ssd, const uint8_t *commands, size_t count); // Envia vários comandos em uma transação
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1); // Marca uma região para o próximo envio
+void ssd1306_send_data(ssd1306_t *ssd); // Envia ao display só as regiões alteradas e espera o fim
+bool ssd1306_flush(ssd1306_t *ssd); // Inicia por DMA o envio das regiões alteradas, sem esperar
+bool ssd1306_busy(ssd1306_t *ssd); // Indica se o envio por DMA ainda está em andamento
+void ssd1306_wait(ssd1306_t *ssd); // Espera o fim do envio em andamento
+bool ssd1306_frame_due(ssd1306_t *ssd); // Indica se já é hora de gerar e enviar o próximo quadro
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value); // Desenha um pixel no display OLED SSD1306
 void ssd1306_fill(ssd1306_t *ssd, bool value); // Preenche o display OLED SSD1306
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill); // Desenha um retângulo no display OLED SSD1306
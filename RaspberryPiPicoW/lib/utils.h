@@ -9,10 +9,24 @@
 #include "web_server.h"
 #include "mqtt_client.h"
 #include "sensors.h"
+#include "sdcard.h"
+#include "log_writer.h"
+#include "dashboard.h"
+#include "analog.h"
+#include "power.h"
+#include "rules.h"
+#include "anomaly.h"
+#include "pico/stdio_usb.h"
+
+#ifndef BOOT_USB_WAIT_MS
+#define BOOT_USB_WAIT_MS 0 // Espera máxima pelo terminal USB no boot (0: não espera)
+#endif
+
 extern ssd1306_t ssd;
-extern volatile uint32_t last_button_press_time;
 extern MQTT_CLIENT_DATA_T state;
 extern char client_id_buf[sizeof(MQTT_DEVICE_NAME) + 4];
 void init_hardware(void);
+void button_events_attach(void); // Faz os eventos dos botões acordarem o laço principal
+void handle_button_events(void); // Trata os eventos dos botões no laço principal
 
 #endif
@@ -20,20 +20,503 @@ const char HTML[] =
     "</body>"
 "</html>";
 
+/**
+ * @brief Contextos das conexões HTTP (nenhuma conexão é aceita sem um contexto livre)
+ */
+static http_conn_t http_conns[HTTP_CONN_MAX];
+
+/**
+ * @brief Respostas em streaming (Transfer-Encoding: chunked)
+ */
+static http_stream_t http_streams[HTTP_STREAM_MAX];
+
+#if MEMP_NUM_TCP_PCB < HTTP_CONN_MAX + HTTP_PCB_RESERVE
+#error "MEMP_NUM_TCP_PCB insuficiente para HTTP_CONN_MAX e a reserva do MQTT"
+#endif
+
+/**
+ * @brief Lê um parâmetro numérico da query string da requisição
+ * @param request Requisição HTTP
+ * @param request_size Tamanho da requisição
+ * @param name Nome do parâmetro
+ * @param value Ponteiro para armazenar o valor lido
+ * @return true se o parâmetro foi encontrado
+ */
+static bool http_query_param(const char *request, size_t request_size, const char *name, long long *value) {
+    const char *end = memchr(request, ' ', request_size);
+    if (!end)
+        return false;
+    end = memchr(end + 1, ' ', request_size - (end + 1 - request));
+    if (!end)
+        end = request + request_size;
+    const char *p = memchr(request, '?', end - request);
+    size_t name_len = strlen(name);
+    while (p && p < end) {
+        p++;
+        if ((size_t)(end - p) > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            // O payload do pbuf não termina em NUL: o valor é copiado (limitado) antes do strtoll
+            const char *v = p + name_len + 1;
+            char digits[24];
+            size_t n = 0;
+            while (v + n < end && n < sizeof(digits) - 1 && v[n] != '&')
+                n++;
+            memcpy(digits, v, n);
+            digits[n] = '\0';
+            *value = strtoll(digits, NULL, 10);
+            return true;
+        }
+        p = memchr(p, '&', end - p);
+    }
+    return false;
+}
+
+/**
+ * @brief Verifica se o HTTP ainda pode ocupar segmentos TCP sem invadir a reserva do MQTT
+ * @return true se há segmentos livres além da reserva
+ */
+static bool http_mem_available(void) {
+#if LWIP_STATS && MEMP_STATS
+    const struct stats_mem *seg = lwip_stats.memp[MEMP_TCP_SEG];
+    return seg->avail - seg->used > HTTP_SEG_RESERVE;
+#else
+    return true;
+#endif
+}
+
+/**
+ * @brief Reserva um contexto de conexão
+ * @param tpcb Ponteiro para o PCB TCP
+ * @return Contexto ou NULL se o pool estiver cheio
+ */
+static http_conn_t *http_conn_alloc(struct tcp_pcb *tpcb) {
+    for (int i = 0; i < HTTP_CONN_MAX; i++) {
+        http_conn_t *conn = &http_conns[i];
+        if (!conn->in_use) {
+            memset(conn, 0, sizeof(*conn));
+            conn->in_use = true;
+            conn->pcb = tpcb;
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Libera o contexto da conexão e a resposta em streaming associada, sem mexer no PCB
+ * @param conn Contexto da conexão
+ */
+static void http_conn_release(http_conn_t *conn) {
+    http_stream_t *stream = conn->stream;
+    if (stream) {
+        if (stream->close)
+            stream->close(stream);
+        async_context_remove_at_time_worker(cyw43_arch_async_context(), &stream->resume);
+        stream->close = NULL;
+        stream->yield = false;
+        stream->conn = NULL;
+        stream->in_use = false;
+    }
+    if (conn->pcb) {
+        tcp_arg(conn->pcb, NULL);
+        tcp_recv(conn->pcb, NULL);
+        tcp_sent(conn->pcb, NULL);
+        tcp_err(conn->pcb, NULL);
+        tcp_poll(conn->pcb, NULL, 0);
+    }
+    conn->stream = NULL;
+    conn->pcb = NULL;
+    conn->in_use = false;
+}
+
+/**
+ * @brief Fecha a conexão e libera seu contexto
+ * @param conn Contexto da conexão
+ * @return ERR_OK, ou ERR_ABRT se foi preciso abortar o PCB
+ */
+static err_t http_conn_close(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    http_conn_release(conn);
+    if (tpcb && tcp_close(tpcb) != ERR_OK) {
+        tcp_abort(tpcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+/**
+ * @brief Aborta a conexão (RST) e libera seu contexto
+ * @param conn Contexto da conexão
+ * @return ERR_ABRT
+ */
+static err_t http_conn_abort(http_conn_t *conn) {
+    struct tcp_pcb *tpcb = conn->pcb;
+    http_conn_release(conn);
+    if (tpcb)
+        tcp_abort(tpcb);
+    return ERR_ABRT;
+}
+
+/**
+ * @brief Envia trechos da resposta enquanto houver espaço no buffer de envio do TCP
+ *
+ * Um trecho já gerado fica em stream->chunk (pending bytes) até o tcp_write
+ * aceitá-lo: o gerador já avançou e não pode produzir o mesmo trecho de novo.
+ * Com falta de memória (o TCP_WRITE_FLAG_COPY aloca do heap do lwIP), o envio
+ * é retomado no próximo http_sent ou http_poll.
+ * @param stream Resposta em streaming
+ * @return ERR_OK, ou ERR_ABRT se a conexão foi abortada
+ */
+static err_t http_stream_pump(http_stream_t *stream) {
+    struct tcp_pcb *tpcb = stream->conn->pcb;
+    while (!stream->finished && http_mem_available()) {
+        if (stream->pending) {
+            if (tcp_write(tpcb, stream->chunk, stream->pending, TCP_WRITE_FLAG_COPY) != ERR_OK)
+                break;
+            stream->pending = 0;
+            continue;
+        }
+        if (stream->done) {
+            // Trecho final; só encerra a resposta quando ele entrar na fila de envio
+            if (tcp_write(tpcb, "0\r\n\r\n", 5, 0) != ERR_OK)
+                break;
+            stream->finished = true;
+            break;
+        }
+
+        u16_t space = tcp_sndbuf(tpcb);
+        if (space < HTTP_CHUNK_MIN + HTTP_CHUNK_OVERHEAD || tcp_sndqueuelen(tpcb) + 2 > TCP_SND_QUEUELEN)
+            break;
+        size_t max = space - HTTP_CHUNK_OVERHEAD;
+        if (max > HTTP_CHUNK_SIZE)
+            max = HTTP_CHUNK_SIZE;
+
+        // Dados gerados após o cabeçalho do trecho ("XXXX\r\n"), seguidos de "\r\n"
+        size_t n = stream->fill(stream, stream->chunk + 6, max, &stream->done);
+        if (n > 0) {
+            char head[7];
+            snprintf(head, sizeof(head), "%04x\r\n", (unsigned)n);
+            memcpy(stream->chunk, head, 6);
+            memcpy(stream->chunk + 6 + n, "\r\n", 2);
+            stream->pending = n + HTTP_CHUNK_OVERHEAD;
+        } else if (!stream->done) {
+            // Gerador em trabalho longo (varredura no cartão): um passo por vez, liberando o contexto do lwIP
+            if (stream->yield) {
+                stream->resume.user_data = stream;
+                async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &stream->resume, HTTP_YIELD_MS);
+            }
+            break;
+        }
+    }
+    tcp_output(tpcb);
+    if (stream->finished)
+        return http_conn_close(stream->conn);
+    return ERR_OK;
+}
+
+/**
+ * @brief Retoma um gerador que cedeu a vez (roda no contexto assíncrono, com o lwIP travado)
+ * @param context Contexto assíncrono
+ * @param worker Tarefa da resposta
+ */
+static void http_stream_resume(async_context_t *context, async_at_time_worker_t *worker) {
+    http_stream_t *stream = (http_stream_t *)worker->user_data;
+    if (!stream->in_use || !stream->conn || !stream->conn->pcb)
+        return;
+    stream->conn->idle = 0; // Consulta em andamento não é conexão ociosa
+    http_stream_pump(stream);
+}
+
+/**
+ * @brief Callback chamado quando o cliente confirma dados enviados
+ * @param arg Contexto da conexão
+ * @param tpcb Ponteiro para o PCB TCP
+ * @param len Quantidade de bytes confirmados
+ */
+static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    if (!conn)
+        return ERR_OK;
+    conn->idle = 0;
+    if (conn->stream)
+        return http_stream_pump(conn->stream);
+    return ERR_OK;
+}
+
+/**
+ * @brief Callback de erro da conexão (o PCB já foi liberado pelo lwIP)
+ * @param arg Contexto da conexão
+ * @param err Código de erro
+ */
+static void http_err(void *arg, err_t err) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    if (conn) {
+        conn->pcb = NULL;
+        http_conn_release(conn);
+    }
+}
+
+/**
+ * @brief Callback periódica: descarta conexões ociosas e retoma respostas paradas por falta de memória
+ * @param arg Contexto da conexão
+ * @param tpcb Ponteiro para o PCB TCP
+ */
+static err_t http_poll(void *arg, struct tcp_pcb *tpcb) {
+    http_conn_t *conn = (http_conn_t *)arg;
+    if (!conn)
+        return ERR_OK;
+    if (++conn->idle >= HTTP_IDLE_POLLS) {
+        metrics_add(&metrics.http_reaped, 1);
+        return http_conn_abort(conn);
+    }
+    if (conn->stream)
+        return http_stream_pump(conn->stream);
+    return ERR_OK;
+}
+
+/**
+ * @brief Gera o próximo trecho da consulta ao histórico
+ */
+static size_t http_fill_history(http_stream_t *stream, char *buf, size_t size, bool *done) {
+    return history_query_read(&stream->gen.history, buf, size, done);
+}
+
+/**
+ * @brief Gera o próximo trecho do /metrics
+ */
+static size_t http_fill_metrics(http_stream_t *stream, char *buf, size_t size, bool *done) {
+    return metrics_render_read(&stream->gen.metrics, buf, size, done);
+}
+
+/**
+ * @brief Verifica se a requisição é um GET para o caminho informado
+ * @param request Requisição HTTP
+ * @param request_size Tamanho da requisição
+ * @param path Caminho esperado (sem query string)
+ * @return true se o caminho corresponde
+ */
+static bool http_match(const char *request, size_t request_size, const char *path) {
+    size_t len = strlen(path);
+    if (request_size < 4 + len + 1 || strncmp(request, "GET ", 4) != 0 || strncmp(request + 4, path, len) != 0)
+        return false;
+    return request[4 + len] == ' ' || request[4 + len] == '?';
+}
+
+/**
+ * @brief Gera o próximo trecho da listagem de logs
+ */
+static size_t http_fill_log_list(http_stream_t *stream, char *buf, size_t size, bool *done) {
+    return log_list_read(&stream->gen.log_list, buf, size, done);
+}
+
+/**
+ * @brief Libera a listagem de logs
+ */
+static void http_close_log_list(http_stream_t *stream) {
+    log_list_end(&stream->gen.log_list);
+}
+
+/**
+ * @brief Gera o próximo trecho do download de um log
+ */
+static size_t http_fill_log(http_stream_t *stream, char *buf, size_t size, bool *done) {
+    return log_reader_read(&stream->gen.log, buf, size, done);
+}
+
+/**
+ * @brief Fecha o log em download
+ */
+static void http_close_log(http_stream_t *stream) {
+    log_reader_end(&stream->gen.log);
+}
+
+/**
+ * @brief Gera o resultado de uma consulta agregada
+ */
+static size_t http_fill_log_col(http_stream_t *stream, char *buf, size_t size, bool *done) {
+    size_t n = log_col_query_read(&stream->gen.log_col, buf, size, done);
+    stream->yield = !*done; // Varredura em andamento: um passo por chamada
+    return n;
+}
+
+/**
+ * @brief Libera a consulta agregada
+ */
+static void http_close_log_col(http_stream_t *stream) {
+    log_col_query_end(&stream->gen.log_col);
+}
+
+/**
+ * @brief Responde com um status de erro e fecha a conexão
+ * @param conn Contexto da conexão
+ * @param status Linha de status (ex.: "400 Bad Request")
+ * @param headers Cabeçalhos adicionais, cada um terminado em "\r\n" ("" se nenhum)
+ * @param message Corpo da resposta (texto)
+ * @return ERR_OK, ou ERR_ABRT se foi preciso abortar o PCB
+ */
+static err_t http_respond_error(http_conn_t *conn, const char *status, const char *headers, const char *message) {
+    char response[192];
+    int n = snprintf(response, sizeof(response),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: text/plain\r\n"
+        "%s"
+        "Connection: close\r\n"
+        "\r\n"
+        "%s", status, headers, message);
+    tcp_write(conn->pcb, response, n, TCP_WRITE_FLAG_COPY);
+    return http_conn_close(conn);
+}
+
+/**
+ * @brief Reserva uma resposta em streaming para a conexão
+ * @param conn Contexto da conexão
+ * @return Resposta em streaming ou NULL se não houver slot livre
+ */
+static http_stream_t *http_stream_alloc(http_conn_t *conn) {
+    for (int i = 0; i < HTTP_STREAM_MAX; i++) {
+        http_stream_t *stream = &http_streams[i];
+        if (!stream->in_use) {
+            memset(stream, 0, offsetof(http_stream_t, gen));
+            stream->in_use = true;
+            stream->conn = conn;
+            stream->resume.do_work = http_stream_resume;
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Envia o cabeçalho e começa a enviar o conteúdo da resposta em streaming
+ * @param stream Resposta em streaming já com gerador configurado
+ * @param content_type Tipo do conteúdo
+ * @return ERR_OK, ou ERR_ABRT se a conexão foi abortada
+ */
+static err_t http_stream_start(http_stream_t *stream, const char *content_type) {
+    stream->conn->stream = stream;
+
+    // O cabeçalho sai pelo mesmo caminho dos trechos, com nova tentativa se faltar memória
+    stream->pending = snprintf(stream->chunk, sizeof(stream->chunk),
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: %s\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Connection: close\r\n"
+        "\r\n", content_type);
+    return http_stream_pump(stream);
+}
+
+/**
+ * @brief Trata as rotas com resposta em streaming
+ * @param conn Contexto da conexão
+ * @param request Requisição HTTP
+ * @param request_size Tamanho da requisição
+ * @param err Resultado do envio (ERR_ABRT se a conexão foi abortada)
+ * @return true se a requisição foi tratada
+ */
+static bool http_route_stream(http_conn_t *conn, const char *request, size_t request_size, err_t *err) {
+    const char *log_prefix = "GET /api/v1/logs/";
+    size_t log_prefix_len = strlen(log_prefix);
+    bool is_history = http_match(request, request_size, "/api/v1/history");
+    bool is_metrics = http_match(request, request_size, "/metrics");
+    bool is_log_list = http_match(request, request_size, "/api/v1/logs");
+    bool is_log = request_size > log_prefix_len && strncmp(request, log_prefix, log_prefix_len) == 0;
+    bool is_agg = LOG_COLUMNAR && http_match(request, request_size, "/api/v1/agg");
+    if (!is_history && !is_metrics && !is_log_list && !is_log && !is_agg)
+        return false;
+
+    http_stream_t *stream = http_stream_alloc(conn);
+    if (!stream) {
+        // Todas as respostas em streaming ocupadas: o cliente tenta de novo, como no pool cheio
+        metrics_add(&metrics.http_busy, 1);
+        *err = http_respond_error(conn, "503 Service Unavailable", "Retry-After: 1\r\n", "Servidor ocupado.");
+        return true;
+    }
+
+    if (is_history) {
+        long long from = -60000, to = 0, points = HISTORY_DEFAULT_POINTS;
+        http_query_param(request, request_size, "from", &from);
+        http_query_param(request, request_size, "to", &to);
+        http_query_param(request, request_size, "points", &points);
+        history_query_begin(&stream->gen.history, from, to, points > 0 ? (uint32_t)points : 0);
+        stream->fill = http_fill_history;
+        *err = http_stream_start(stream, "application/json");
+    } else if (is_metrics) {
+        metrics_render_begin(&stream->gen.metrics);
+        stream->fill = http_fill_metrics;
+        *err = http_stream_start(stream, "text/plain; version=0.0.4");
+    } else if (is_agg) {
+        // Consulta agregada nos blocos colunares: ch = índice do canal, from/to em s (RTC; negativos: relativos a agora)
+        long long ch = -1, from = -3600, to = 0;
+        http_query_param(request, request_size, "ch", &ch);
+        http_query_param(request, request_size, "from", &from);
+        http_query_param(request, request_size, "to", &to);
+        if (!log_col_query_begin(&stream->gen.log_col, (int)ch, from, to)) {
+            stream->in_use = false;
+            *err = http_respond_error(conn, "400 Bad Request", "", "Canal inválido.");
+            return true;
+        }
+        stream->fill = http_fill_log_col;
+        stream->close = http_close_log_col;
+        *err = http_stream_start(stream, "application/json");
+    } else if (is_log_list) {
+        log_list_begin(&stream->gen.log_list);
+        stream->fill = http_fill_log_list;
+        stream->close = http_close_log_list;
+        *err = http_stream_start(stream, "application/json");
+    } else {
+        // Nome do log: do fim do prefixo até '?' ou ' '
+        char name[LOG_NAME_MAX];
+        size_t len = 0;
+        const char *p = request + log_prefix_len;
+        while (p + len < request + request_size && p[len] != ' ' && p[len] != '?' && len < sizeof(name) - 1) {
+            name[len] = p[len];
+            len++;
+        }
+        name[len] = '\0';
+        long long from = -1, to = -1;
+        http_query_param(request, request_size, "from", &from);
+        http_query_param(request, request_size, "to", &to);
+        FRESULT fr = log_reader_begin(&stream->gen.log, name, from, to);
+        if (fr != FR_OK) {
+            stream->in_use = false;
+            if (fr == FR_INVALID_NAME || fr == FR_INVALID_PARAMETER)
+                *err = http_respond_error(conn, "400 Bad Request", "", "Nome ou intervalo inválido.");
+            else if (fr == FR_NO_FILE || fr == FR_NO_PATH)
+                *err = http_respond_error(conn, "404 Not Found", "", "Log não encontrado.");
+            else
+                *err = http_respond_error(conn, "503 Service Unavailable", "", "Cartão SD indisponível.");
+            return true;
+        }
+        stream->fill = http_fill_log;
+        stream->close = http_close_log;
+        size_t name_len = strlen(name);
+        bool is_csv = name_len > 4 && strcmp(name + name_len - 4, ".csv") == 0;
+        *err = http_stream_start(stream, is_csv ? "text/csv" : "application/octet-stream");
+    }
+    return true;
+}
+
 /**
  * @brief Função de callback para receber dados TCP
- * @param arg Ponteiro para os dados do cliente
+ * @param arg Contexto da conexão
  * @param tpcb Ponteiro para o PCB TCP
  * @param p Ponteiro para o buffer de dados
  * @param err Código de erro
  */
 static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
 {
+    http_conn_t *conn = (http_conn_t *)arg;
     if (!p)
+        return conn ? http_conn_close(conn) : tcp_close(tpcb);
+    tcp_recved(tpcb, p->tot_len);
+
+    // Resposta em streaming em andamento: ignora dados adicionais do cliente
+    if (!conn || conn->stream)
     {
-        tcp_close(tpcb);
+        pbuf_free(p);
         return ERR_OK;
     }
+    conn->idle = 0;
 
     char *req = (char *)p->payload;
 
@@ -52,7 +535,11 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
 
     char json[64];
 
-    if (p->len >= 6 && strncmp(req, "GET / ", 6) == 0){
+    err_t result = ERR_OK;
+    if (http_route_stream(conn, req, p->len, &result)) {
+        pbuf_free(p);
+        return result;
+    } else if (p->len >= 6 && strncmp(req, "GET / ", 6) == 0){
         tcp_write(tpcb, header_html, strlen(header_html), TCP_WRITE_FLAG_COPY);
         tcp_write(tpcb, HTML, strlen(HTML), TCP_WRITE_FLAG_COPY);
     }else if(handle_http_request(req, p->len, json, sizeof(json))) {
@@ -67,10 +554,8 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
             "Recurso não encontrado.";
         tcp_write(tpcb, not_found, strlen(not_found), TCP_WRITE_FLAG_COPY);
     }
-    tcp_recved(tpcb, p->tot_len);
     pbuf_free(p);
-    tcp_close(tpcb); // Fecha a conexão após envio da resposta
-    return ERR_OK;
+    return http_conn_close(conn); // Fecha a conexão após envio da resposta
 }
 
 /**
@@ -80,12 +565,97 @@ static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t er
  * @param err Código de erro
  */
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err){
+    if (err != ERR_OK || !newpcb)
+        return ERR_VAL;
+
+    http_conn_t *conn = http_conn_alloc(newpcb);
+    if (!conn) {
+        // Pool cheio: responde 503 se ainda houver folga de memória, senão envia RST
+        if (http_mem_available()) {
+            const char *unavailable =
+                "HTTP/1.1 503 Service Unavailable\r\n"
+                "Retry-After: 1\r\n"
+                "Content-Length: 0\r\n"
+                "Connection: close\r\n"
+                "\r\n";
+            metrics_add(&metrics.http_rejected, 1);
+            tcp_write(newpcb, unavailable, strlen(unavailable), 0);
+            if (tcp_close(newpcb) == ERR_OK)
+                return ERR_OK;
+        }
+        metrics_add(&metrics.http_reset, 1);
+        tcp_abort(newpcb);
+        return ERR_ABRT;
+    }
+
+    metrics_add(&metrics.http_accepted, 1);
+    tcp_arg(newpcb, conn);
     tcp_recv(newpcb, http_recv);
+    tcp_sent(newpcb, http_sent);
+    tcp_err(newpcb, http_err);
+    tcp_poll(newpcb, http_poll, HTTP_POLL_INTERVAL);
     return ERR_OK;
 }
 
 /**
- * @brief Inicializa o servidor TCP
+ * @brief Estado da associação Wi-Fi
+ */
+static bool wifi_up;
+static bool wifi_retry_pending;
+static absolute_time_t wifi_retry_at;
+
+/**
+ * @brief Dispara a associação Wi-Fi sem bloquear; o progresso é acompanhado por wifi_poll
+ */
+static void wifi_connect_start(void) {
+    wifi_retry_pending = false;
+    if (cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK)) {
+        printf("Falha ao iniciar a conexão Wi-Fi\n");
+        wifi_retry_pending = true;
+        wifi_retry_at = make_timeout_time_ms(WIFI_RETRY_MS);
+    }
+}
+
+/**
+ * @brief Acompanha a associação Wi-Fi e tenta de novo após falhas
+ * @return true se o enlace está ativo e com IP
+ */
+bool wifi_poll(void) {
+    char ip[IPADDR_STRLEN_MAX] = "";
+    cyw43_arch_lwip_begin();
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    if (status == CYW43_LINK_UP && !wifi_up && netif_default)
+        ipaddr_ntoa_r(&netif_default->ip_addr, ip, sizeof(ip));
+    cyw43_arch_lwip_end();
+    if (status == CYW43_LINK_UP) {
+        if (!wifi_up) {
+            wifi_up = true;
+            power_link_up(true); // Rádio no modo de economia da política
+            metrics_boot_mark(&metrics.boot_wifi_up_ms);
+            // Caso seja a interface de rede padrão - imprimir o IP do dispositivo.
+            if (ip[0])
+                printf("IP do dispositivo: %s\n", ip);
+        }
+        return true;
+    }
+    if (wifi_up)
+        power_link_up(false); // Enlace caiu: o rádio deixa o modo da política enquanto reassocia
+    wifi_up = false;
+
+    if (status == CYW43_LINK_FAIL || status == CYW43_LINK_NONET || status == CYW43_LINK_BADAUTH) {
+        if (!wifi_retry_pending) {
+            printf("Falha na conexão Wi-Fi (%d), nova tentativa em %d ms\n", status, WIFI_RETRY_MS);
+            wifi_retry_pending = true;
+            wifi_retry_at = make_timeout_time_ms(WIFI_RETRY_MS);
+        }
+    }
+    if (wifi_retry_pending && time_reached(wifi_retry_at))
+        wifi_connect_start();
+    return false;
+}
+
+/**
+ * @brief Inicia o Wi-Fi em segundo plano e o servidor TCP (não espera a associação)
  */
 void server_init(void) {
     //Inicializa a arquitetura do cyw43
@@ -99,15 +669,8 @@ void server_init(void) {
     // Ativa o Wi-Fi no modo Station, de modo a que possam ser feitas ligações a outros pontos de acesso Wi-Fi.
     cyw43_arch_enable_sta_mode();
 
-    // Conectar à rede WiFI 
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 30000)) {
-        panic("Failed to connect to WiFi");
-    }
-
-    // Caso seja a interface de rede padrão - imprimir o IP do dispositivo.
-    if (netif_default){
-        printf("IP do dispositivo: %s\n", ipaddr_ntoa(&netif_default->ip_addr));
-    }
+    // Conectar à rede WiFI (assíncrono: o laço principal acompanha com wifi_poll)
+    wifi_connect_start();
 
     // Configura o servidor TCP - cria novos PCBs TCP. É o primeiro passo para estabelecer uma conexão TCP.
     struct tcp_pcb *server = tcp_new();
@@ -120,6 +683,9 @@ void server_init(void) {
         panic("Failed to bind TCP PCB\n");
     }
 
+    // Conexões HTTP herdam a prioridade mínima: se faltar PCB, o lwIP descarta elas antes da do MQTT
+    tcp_setprio(server, TCP_PRIO_MIN);
+
     // Coloca um PCB (Protocol Control Block) TCP em modo de escuta, permitindo que ele aceite conexões de entrada.
     server = tcp_listen(server);
 
@@ -4,19 +4,86 @@
 #include "user_data.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h" 
       
 #include "lwip/pbuf.h"           
 #include "lwip/tcp.h"            
 #include "lwip/netif.h" 
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+
+#include "history.h"
+#include "metrics.h"
+#include "log_store.h"
+#include "log_columnar.h"
+#include "power.h"
 
 #define LED_PIN CYW43_WL_GPIO_LED_PIN 
 
+#define HTTP_CONN_MAX 4 // Máximo de conexões HTTP simultâneas (contextos do pool)
+#define HTTP_STREAM_MAX 2 // Máximo de respostas em streaming simultâneas
+#define HTTP_PCB_RESERVE 2 // PCBs TCP fora do alcance do HTTP (MQTT e uma folga para TIME_WAIT)
+#define HTTP_SEG_RESERVE 8 // Segmentos TCP que o HTTP nunca ocupa (reservados ao MQTT)
+#define HTTP_POLL_INTERVAL 2 // Intervalo do tcp_poll (em ticks de 500 ms)
+#define HTTP_IDLE_POLLS 5 // Polls sem atividade até a conexão ser descartada (5 s)
+
+#define WIFI_POLL_MS 50 // Intervalo de consulta ao estado da associação Wi-Fi
+#define WIFI_RETRY_MS 5000 // Espera antes de tentar associar de novo após uma falha
+#define HTTP_CHUNK_SIZE 1024 // Tamanho máximo dos dados de cada trecho
+#define HTTP_CHUNK_MIN 512 // Espaço mínimo no buffer de envio para gerar um trecho
+#define HTTP_CHUNK_OVERHEAD 8 // "XXXX\r\n" antes e "\r\n" depois dos dados
+#define HTTP_YIELD_MS 2 // Pausa entre os passos de um gerador que cedeu a vez (aquisição e rede rodam nela)
+
+typedef struct http_stream_t http_stream_t;
+typedef struct http_conn_t http_conn_t;
+
+// Gera o próximo trecho da resposta; retorna os bytes escritos e sinaliza o fim em done
+typedef size_t (*http_fill_fn)(http_stream_t *stream, char *buf, size_t size, bool *done);
+
+// Libera recursos do gerador (arquivos abertos, etc.)
+typedef void (*http_close_fn)(http_stream_t *stream);
+
+// Contexto de uma conexão HTTP (alocado do pool estático)
+struct http_conn_t {
+    struct tcp_pcb *pcb; // PCB da conexão
+    http_stream_t *stream; // Resposta em streaming em andamento (ou NULL)
+    uint8_t idle; // Polls seguidos sem atividade
+    bool in_use; // Contexto ocupado
+};
+
+// Resposta em streaming
+struct http_stream_t {
+    http_conn_t *conn; // Conexão dona da resposta
+    http_fill_fn fill; // Gerador do conteúdo
+    http_close_fn close; // Liberação do gerador (opcional)
+    bool in_use; // Slot ocupado
+    bool done; // Gerador terminou; falta o trecho final
+    bool finished; // Trecho final já na fila de envio
+    uint16_t pending; // Bytes em chunk aguardando o tcp_write (trecho já gerado)
+    bool yield; // O gerador parou no meio do trabalho (não por falta de espaço): retomar sem esperar ACK
+    async_at_time_worker_t resume; // Retomada do gerador que cedeu a vez
+    union {
+        history_query_t history;
+        metrics_render_t metrics;
+        log_list_t log_list;
+        log_reader_t log;
+        log_col_query_t log_col;
+    } gen; // Estado do gerador
+    char chunk[HTTP_CHUNK_SIZE + HTTP_CHUNK_OVERHEAD]; // Trecho em montagem
+};
+
 void user_request(char *html, size_t html_size); // Função para lidar com a requisição do usuário
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err); // Função de callback para aceitar conexões TCP
 static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err); // Função de callback para receber dados TCP
-void server_init(void); // Inicializa o servidor TCP
+static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len); // Função de callback para dados TCP confirmados
+static void http_err(void *arg, err_t err); // Função de callback para erros na conexão TCP
+static err_t http_poll(void *arg, struct tcp_pcb *tpcb); // Função de callback periódica para descartar conexões ociosas
+void server_init(void); // Inicia o Wi-Fi em segundo plano e o servidor TCP
+bool wifi_poll(void); // Acompanha a associação Wi-Fi; retorna true com o enlace ativo
 bool handle_http_request(const char *request, size_t request_size, char *response, size_t response_size); // Função para lidar com a requisição HTTP
 
 #endif
\ No newline at end of file
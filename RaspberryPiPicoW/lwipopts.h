@@ -14,6 +14,17 @@
 
 #define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL+1)
 
+// PCBs TCP: HTTP_CONN_MAX conexões HTTP + MQTT + folga para TIME_WAIT
+#define MEMP_NUM_TCP_PCB            6
+
+// Estatísticas de memória do lwIP, expostas no endpoint /metrics
+#undef LWIP_STATS
+#define LWIP_STATS                  1
+#undef MEM_STATS
+#define MEM_STATS                   1
+#undef MEMP_STATS
+#define MEMP_STATS                  1
+
 #ifdef MQTT_CERT_INC
 #define LWIP_ALTCP               1
 #define LWIP_ALTCP_TLS           1
@@ -2,18 +2,52 @@
 
 int main() {
     init_hardware();
-    server_init(); 
+    server_init(); // Não espera o Wi-Fi: a aquisição começa imediatamente
+    button_events_attach(); // Botões acordam o laço principal
     generate_client_id(client_id_buf, sizeof(client_id_buf)); 
     configure_mqtt_client(&state, client_id_buf); 
-    resolve_and_connect_mqtt(&state); 
     
-    while (verify_mqtt(&state)){
-        cyw43_arch_poll(); 
-        cyw43_arch_wait_for_work_until(make_timeout_time_ms(10000)); 
-        printf("Reading sensors...\n");
+    bool link_up = false;
+    absolute_time_t mqtt_wake = at_the_end_of_time; // Próxima tentativa de conexão com o broker
+    absolute_time_t next_sample = get_absolute_time();
+    // A aquisição, o log e o painel rodam sempre; o MQTT conecta e reconecta em segundo plano
+    while (true) {
+        // Enquanto o Wi-Fi associa, acorda a cada WIFI_POLL_MS para acompanhar o estado
+        absolute_time_t wake = absolute_time_min(next_sample, mqtt_wake);
+        if (!link_up)
+            wake = absolute_time_min(wake, make_timeout_time_ms(WIFI_POLL_MS));
+        power_wait_until(wake); // Núcleo em WFE até a próxima amostra ou até o lwIP ter trabalho
+        link_up = wifi_poll(); // Também informa as mudanças do enlace ao modelo de energia
+        mqtt_wake = mqtt_service(&state, link_up);
+        handle_button_events(); // Toques registrados pela interrupção
+        dashboard_update(&ssd, &state); // Painel no display: só redesenha o que mudou, envio por DMA
+        if (absolute_time_diff_us(get_absolute_time(), next_sample) > 0)
+            continue;
+        next_sample = delayed_by_ms(next_sample, SENSOR_SAMPLE_PERIOD_MS);
+
+        uint64_t loop_start = time_us_64();
         SensorReadings readings = get_sensor_readings();
+        metrics_add(&metrics.samples, 1);
+        power_sample_done();
+        metrics_boot_mark(&metrics.boot_first_sample_ms);
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        cyw43_arch_lwip_begin();
+        history_push(&readings, now_ms);
+        history_sample_t sample;
+        if (history_latest(&sample)) {
+            rules_evaluate(&sample, &state); // Alertas saem já nesta amostra, antes da telemetria
+            anomaly_update(&sample, &state);
+        }
+        cyw43_arch_lwip_end();
+        log_writer_append(&readings, now_ms);
+        matrix_update(); // Redesenha a matriz com a nova amostra; o envio segue por DMA
+        metrics_observe(&metrics.loop_latency, (uint32_t)(time_us_64() - loop_start));
+
+        // Gravação no cartão fora da medição do laço; o FatFs não é reentrante, então bloqueia o lwIP
+        if (log_writer_pending()) {
+            cyw43_arch_lwip_begin();
+            log_writer_service();
+            cyw43_arch_lwip_end();
+        }
     }
-    printf("MQTT connection lost\n");
-    cyw43_arch_deinit();
-    return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ff.h"
+#include "my_debug.h"
+
+/**
+ * @brief Carimbo de tempo do FatFs no host (src/rtc.c usa o RTC da Pico)
+ * @return Data e hora no formato da FAT
+ */
+DWORD get_fattime(void) {
+    time_t now = time(NULL);
+    struct tm *tm = localtime(&now);
+    return (DWORD)(tm->tm_year - 80) << 25 | (DWORD)(tm->tm_mon + 1) << 21 | (DWORD)tm->tm_mday << 16 |
+           (DWORD)tm->tm_hour << 11 | (DWORD)tm->tm_min << 5 | (DWORD)(tm->tm_sec / 2);
+}
+
+/**
+ * @brief Falha de myASSERT no host (src/my_debug.c para o núcleo com bkpt)
+ */
+void my_assert_func(const char *file, int line, const char *func, const char *pred) {
+    printf("assertion \"%s\" failed: file \"%s\", line %d, function: %s\n", pred, file, line, func);
+    abort();
+}
@@ -0,0 +1,28 @@
+// Contadores para os testes no host (lib/metrics.c também gera o /metrics a partir de todos os módulos)
+#include "metrics.h"
+
+metrics_t metrics;
+
+uint32_t metrics_read(const metrics_counter_t *counter) {
+    uint32_t total = 0;
+    for (int i = 0; i < METRICS_NUM_CORES; i++)
+        total += counter->core[i];
+    return total;
+}
+
+void metrics_observe(metrics_histogram_t *hist, uint32_t us) {
+    static const uint32_t limits[METRICS_LATENCY_BUCKETS] = METRICS_LATENCY_BUCKET_LIMITS_US;
+    int bucket = 0;
+    while (bucket < METRICS_LATENCY_BUCKETS && us > limits[bucket])
+        bucket++;
+    metrics_add(&hist->bucket[bucket], 1);
+    metrics_add(&hist->sum_us, us);
+}
+
+int metrics_i2c(metrics_i2c_dev_t dev, int result) {
+    if (result == PICO_ERROR_TIMEOUT)
+        metrics_add(&metrics.i2c_timeouts[dev], 1);
+    else if (result < 0)
+        metrics_add(&metrics.i2c_errors[dev], 1);
+    return result;
+}
@@ -0,0 +1,65 @@
+// Sessão de escrita contínua do cartão sobre o backend em imagem. O primeiro envio da sessão paga o
+// comando de escrita do perfil (ACMD23 e CMD25) com disk_write; os seguintes só os setores, como no
+// driver, que mantém o cartão em CMD25 entre os envios. Falhas e paradas do perfil valem para todos
+#include "hw_config.h"
+#include "diskio.h"
+#include "disk_image.h"
+
+static sd_card_t card = {.pcName = "0:"};
+uint64_t sd_stream_sectors;
+uint64_t sd_stream_commands;
+bool sd_stream_per_command;
+static uint64_t stream_commands; // Comandos da imagem ao fim do último envio
+
+/**
+ * @brief Comandos enviados à imagem até agora
+ */
+static uint64_t image_commands(void) {
+    disk_image_stats_t s = disk_image_stats(0, false);
+    return s.reads + s.writes;
+}
+
+sd_card_t *sd_get_by_num(size_t num) {
+    if (num != 0)
+        return NULL;
+    // Como no driver, qualquer outro acesso ao cartão (FatFs, checkpoint) encerra a sessão
+    if (card.stream_open && image_commands() != stream_commands)
+        card.stream_open = false;
+    return &card;
+}
+
+int sd_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber, uint32_t blockCnt) {
+    pSD->stream_open = true;
+    pSD->stream_next = ulSectorNumber;
+    pSD->stream_end = ulSectorNumber + blockCnt;
+    pSD->stream_started = false;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_stream_write(sd_card_t *pSD, const uint8_t *buffer, uint32_t blockCnt) {
+    if (!pSD->stream_open || pSD->stream_next + blockCnt > pSD->stream_end) {
+        pSD->stream_open = false;
+        return SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    DRESULT dr;
+    if (pSD->stream_started && !sd_stream_per_command) {
+        dr = disk_image_write_stream(0, buffer, (LBA_t)pSD->stream_next, blockCnt);
+    } else {
+        dr = disk_write(0, buffer, (LBA_t)pSD->stream_next, blockCnt);
+        sd_stream_commands++;
+    }
+    pSD->stream_started = true;
+    stream_commands = image_commands();
+    if (dr != RES_OK) {
+        pSD->stream_open = false;
+        return SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    pSD->stream_next += blockCnt;
+    sd_stream_sectors += blockCnt;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+int sd_stream_close(sd_card_t *pSD) {
+    pSD->stream_open = false;
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
@@ -0,0 +1,16 @@
+// Canais dos sensores para os testes no host (lib/sensors.c também traz os drivers I2C)
+#include "sensors.h"
+
+const char *const SENSOR_CHANNEL_NAMES[SENSOR_CH_COUNT] = {
+    "temperature", "humidity", "altitude", "gyroscope", "acceleration",
+    "gyroscope_x", "gyroscope_y", "gyroscope_z",
+    "acceleration_x", "acceleration_y", "acceleration_z"
+};
+
+/**
+ * @brief Obtém o valor de um canal a partir de uma leitura (igual a lib/sensors.c)
+ */
+float sensor_channel_value(const SensorReadings *readings, sensor_channel_t channel) {
+    const float *values = &readings->temperature; // Os campos seguem a ordem de sensor_channel_t
+    return channel < SENSOR_CH_COUNT ? values[channel] : 0.0f;
+}
@@ -0,0 +1,24 @@
+// Substituto para o host: as funções são implementadas pelo teste que usa o barramento (tests/test_ssd1306.c)
+#pragma once
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t *i2c0, *i2c1;
+
+typedef struct {
+    volatile uint32_t enable, tar, data_cmd, status, raw_intr_stat, clr_tx_abrt, tx_abrt_source;
+} i2c_hw_t;
+
+#define I2C_IC_DATA_CMD_STOP_BITS 0x200u
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x400u
+#define I2C_IC_STATUS_TFE_BITS 0x4u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x20u
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS 0x40u
+
+void i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
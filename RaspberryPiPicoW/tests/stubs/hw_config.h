@@ -0,0 +1,25 @@
+// Substituto para o host do hw_config.h do FatFs_SPI: um cartão sobre o backend em imagem,
+// com a sessão de escrita contínua (CMD25) implementada por tests/sd_stream_host.c
+#pragma once
+#include "ff.h"
+#include "pico/stdlib.h"
+
+#define SD_BLOCK_DEVICE_ERROR_NONE 0
+#define SD_BLOCK_DEVICE_ERROR_WRITE -5011
+
+typedef struct sd_card_t {
+    const char *pcName;
+    bool stream_open; // Sessão de escrita contínua aberta
+    uint64_t stream_next; // Próximo setor da sessão
+    uint64_t stream_end; // Fim (exclusivo) da sessão
+    bool stream_started; // O comando de escrita da sessão já foi enviado
+} sd_card_t;
+
+extern uint64_t sd_stream_sectors; // Setores que a sessão contínua entregou à imagem (só no host)
+extern uint64_t sd_stream_commands; // Comandos de escrita (ACMD23 e CMD25) enviados pelas sessões (só no host)
+extern bool sd_stream_per_command; // Cada envio com o próprio comando de escrita, como antes da sessão (só no host)
+
+sd_card_t *sd_get_by_num(size_t num);
+int sd_stream_open(sd_card_t *pSD, uint64_t ulSectorNumber, uint32_t blockCnt);
+int sd_stream_write(sd_card_t *pSD, const uint8_t *buffer, uint32_t blockCnt);
+int sd_stream_close(sd_card_t *pSD);
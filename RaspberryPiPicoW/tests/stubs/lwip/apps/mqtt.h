@@ -0,0 +1,15 @@
+// Substituto para o host: cliente MQTT do lwIP (as publicações são feitas pelo teste)
+#pragma once
+#include "lwip/tcp.h"
+
+typedef struct mqtt_client_s mqtt_client_t;
+typedef enum { MQTT_CONNECT_ACCEPTED = 0, MQTT_CONNECT_DISCONNECTED = 256 } mqtt_connection_status_t;
+struct mqtt_connect_client_info_t {
+    const char *client_id, *client_user, *client_pass;
+    u16_t keep_alive;
+    const char *will_topic, *will_msg;
+    u8_t will_qos, will_retain;
+};
+#define MQTT_OUTPUT_RINGBUF_SIZE 256
+
+u8_t mqtt_client_is_connected(mqtt_client_t *client);
@@ -0,0 +1,11 @@
+// Substituto para o host: tipos básicos do lwIP usados nos cabeçalhos
+#pragma once
+#include "pico/stdlib.h"
+
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef struct { uint32_t addr; } ip_addr_t;
+
+enum { ERR_OK = 0, ERR_MEM = -1 };
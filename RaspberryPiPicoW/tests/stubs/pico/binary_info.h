@@ -0,0 +1,3 @@
+#pragma once
+#define bi_decl(x)
+#define bi_2pins_with_func(...)
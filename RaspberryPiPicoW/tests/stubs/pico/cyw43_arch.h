@@ -0,0 +1,10 @@
+// Substituto para o host: só os tipos do contexto assíncrono usados nos cabeçalhos
+#pragma once
+#include "pico/stdlib.h"
+#include "lwip/tcp.h"
+
+typedef struct async_context async_context_t;
+typedef struct async_at_time_worker {
+    void (*do_work)(async_context_t *context, struct async_at_time_worker *worker);
+    void *user_data;
+} async_at_time_worker_t;
@@ -0,0 +1,95 @@
+// Implementação para o host das funções do Pico SDK usadas pelos módulos testados.
+// O tempo é simulado: só avança com host_advance_us (e sleep_*), o que deixa os testes determinísticos
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include <time.h>
+
+static uint64_t now_us = 1000000; // Começa em 1 s, como um boot que já passou da inicialização
+static int64_t rtc_offset_us; // RTC menos o relógio desde o boot
+
+void host_advance_us(uint64_t us) {
+    now_us += us;
+}
+
+void host_set_time(time_t t) {
+    rtc_offset_us = (int64_t)t * 1000000 - (int64_t)now_us;
+}
+
+/**
+ * @brief time() do firmware (RTC): segue o relógio simulado a partir de host_set_time
+ */
+time_t time(time_t *t) {
+    time_t now = (time_t)(((int64_t)now_us + rtc_offset_us) / 1000000);
+    if (t)
+        *t = now;
+    return now;
+}
+
+uint get_core_num(void) {
+    return 0;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return now_us;
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return now_us + (uint64_t)ms * 1000;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return now_us + us;
+}
+
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return t + (uint64_t)ms * 1000;
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+bool time_reached(absolute_time_t t) {
+    return now_us >= t;
+}
+
+void sleep_ms(uint32_t ms) {
+    now_us += (uint64_t)ms * 1000;
+}
+
+void sleep_us(uint64_t us) {
+    now_us += us;
+}
+
+void gpio_set_function(uint gpio, int fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+}
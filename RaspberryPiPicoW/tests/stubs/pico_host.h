@@ -0,0 +1,7 @@
+// Controle do relógio simulado dos substitutos do Pico SDK (tests/stubs/pico_host.c)
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+void host_advance_us(uint64_t us); // Avança o relógio simulado (time_us_64, time_reached, ...)
+void host_set_time(time_t t); // Acerta o RTC simulado (time())
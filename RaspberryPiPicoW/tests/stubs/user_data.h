@@ -0,0 +1,5 @@
+// Credenciais fictícias para os testes no host (lib/user_data.h não é versionado)
+#pragma once
+#define WIFI_SSID "teste"
+#define WIFI_PASSWORD "teste"
+#define MQTT_SERVER "127.0.0.1"
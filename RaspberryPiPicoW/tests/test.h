@@ -0,0 +1,88 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <math.h>
+
+// Falhas do teste em execução; main retorna test_result()
+static int test_failures = 0;
+
+// Verifica uma condição e continua o teste mesmo se ela falhar
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            printf("%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond);                \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+// Verifica uma igualdade inteira, mostrando os dois valores
+#define CHECK_EQ(a, b)                                                               \
+    do {                                                                             \
+        long long _a = (long long)(a), _b = (long long)(b);                          \
+        if (_a != _b) {                                                              \
+            printf("%s:%d: falhou: %s == %s (%lld != %lld)\n", __FILE__, __LINE__,   \
+                   #a, #b, _a, _b);                                                  \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+/**
+ * @brief Relógio monotônico para os benchmarks
+ * @return Microssegundos
+ */
+static inline uint64_t test_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+// Gerador congruencial dos dados sintéticos: cada teste fixa a semente com test_seed, para ser reprodutível
+static uint32_t test_rng = 1;
+
+/**
+ * @brief Reinicia o gerador dos dados sintéticos
+ * @param seed Semente
+ */
+static inline void test_seed(uint32_t seed) {
+    test_rng = seed;
+}
+
+/**
+ * @brief Inteiro pseudoaleatório reprodutível
+ * @param n Limite (exclusivo)
+ * @return Valor em [0, n)
+ */
+static inline uint32_t test_random_below(uint32_t n) {
+    test_rng = test_rng * 1103515245u + 12345u;
+    return (test_rng >> 8) % n;
+}
+
+/**
+ * @brief Ruído gaussiano reprodutível (Box-Muller sobre o gerador congruencial)
+ * @return Amostra com média 0 e desvio padrão 1
+ */
+static inline float test_gauss(void) {
+    test_rng = test_rng * 1103515245u + 12345u;
+    float u = ((test_rng >> 8) + 1.0f) / 16777218.0f;
+    test_rng = test_rng * 1103515245u + 12345u;
+    float v = ((test_rng >> 8) + 1.0f) / 16777218.0f;
+    return sqrtf(-2.0f * logf(u)) * cosf(6.2831853f * v);
+}
+
+/**
+ * @brief Resultado do teste para o ctest
+ * @return 0 se nenhuma verificação falhou
+ */
+static inline int test_result(void) {
+    if (test_failures)
+        printf("%d verificação(ões) falharam\n", test_failures);
+    else
+        printf("OK\n");
+    return test_failures ? 1 : 0;
+}
+
+#endif
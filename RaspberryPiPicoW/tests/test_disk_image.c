@@ -0,0 +1,112 @@
+// Backend de disco em imagem (glue_image.c): formata, grava, remonta e lê de volta,
+// e confere os perfis de falha (queda de energia e erro de CRC na leitura)
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "ff.h"
+#include "disk_image.h"
+
+#define IMAGE_PATH "test_disk_image.img"
+#define IMAGE_SECTORS 8192 // 4 MB
+#define FILE_SIZE (100 * 1024 + 37) // Vários clusters e um setor final incompleto
+
+static FATFS fs;
+static BYTE work[FF_MAX_SS];
+static BYTE data[FILE_SIZE];
+static BYTE readback[FILE_SIZE];
+
+/**
+ * @brief Grava um arquivo inteiro
+ */
+static FRESULT write_file(const char *path, const void *buf, UINT len) {
+    FIL f;
+    UINT bw = 0;
+    FRESULT fr = f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK)
+        return fr;
+    fr = f_write(&f, buf, len, &bw);
+    FRESULT fr_close = f_close(&f);
+    if (fr == FR_OK)
+        fr = fr_close;
+    return fr == FR_OK && bw != len ? FR_DENIED : fr;
+}
+
+/**
+ * @brief Lê um arquivo inteiro
+ */
+static FRESULT read_file(const char *path, void *buf, UINT len, UINT *br) {
+    FIL f;
+    FRESULT fr = f_open(&f, path, FA_READ);
+    if (fr != FR_OK)
+        return fr;
+    fr = f_read(&f, buf, len, br);
+    f_close(&f);
+    return fr;
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (BYTE)(i * 7 + (i >> 9));
+
+    unlink(IMAGE_PATH);
+    CHECK(disk_image_open(0, IMAGE_PATH, IMAGE_SECTORS));
+    const MKFS_PARM opt = {.fmt = FM_ANY | FM_SFD};
+    CHECK_EQ(f_mkfs("0:", &opt, work, sizeof(work)), FR_OK);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    CHECK_EQ(f_mkdir("0:/logs"), FR_OK);
+    CHECK_EQ(write_file("0:/logs/data.bin", data, sizeof(data)), FR_OK);
+    disk_image_stats_t stats = disk_image_stats(0, true);
+    CHECK(stats.sectors_written >= sizeof(data) / DISK_IMAGE_SECTOR_SIZE);
+    CHECK_EQ(stats.write_failures, 0);
+    f_unmount("0:");
+    disk_image_close(0);
+
+    // A imagem guarda o sistema de arquivos entre montagens (sectors = 0 mantém o tamanho)
+    CHECK(disk_image_open(0, IMAGE_PATH, 0));
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    UINT br = 0;
+    memset(readback, 0, sizeof(readback));
+    CHECK_EQ(read_file("0:/logs/data.bin", readback, sizeof(readback), &br), FR_OK);
+    CHECK_EQ(br, sizeof(data));
+    CHECK(memcmp(readback, data, sizeof(data)) == 0);
+    CHECK(disk_image_stats(0, false).sectors_read > 0);
+
+    // Erro de CRC em toda leitura: o FatFs recebe RES_ERROR
+    disk_image_profile_t crc_fail = {.crc_error_ppm = 1000000};
+    disk_image_set_profile(0, &crc_fail);
+    disk_image_stats(0, true);
+    f_unmount("0:");
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_DISK_ERR);
+    CHECK(disk_image_stats(0, false).crc_errors > 0);
+
+    // Queda de energia após 3 gravações: nada mais chega à imagem
+    disk_image_profile_t power_cut = {.power_cut_after_writes = 3};
+    disk_image_set_profile(0, &power_cut);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    CHECK(write_file("0:/logs/cut.bin", data, sizeof(data)) != FR_OK);
+    stats = disk_image_stats(0, true);
+    CHECK(stats.write_failures > 0);
+    CHECK(stats.sectors_written <= 3 * sizeof(data) / DISK_IMAGE_SECTOR_SIZE);
+
+    // Próximo boot: o arquivo antigo continua íntegro
+    disk_image_set_profile(0, NULL);
+    f_unmount("0:");
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    memset(readback, 0, sizeof(readback));
+    CHECK_EQ(read_file("0:/logs/data.bin", readback, sizeof(readback), &br), FR_OK);
+    CHECK(memcmp(readback, data, sizeof(data)) == 0);
+
+    // Latência modelada (sem dormir): entra só nas estatísticas
+    disk_image_profile_t slow = {.write_us = 100, .write_us_per_sector = 10, .busy_every_writes = 4, .busy_us = 5000};
+    disk_image_set_profile(0, &slow);
+    disk_image_stats(0, true);
+    CHECK_EQ(write_file("0:/logs/slow.bin", data, 4096), FR_OK);
+    stats = disk_image_stats(0, false);
+    CHECK(stats.simulated_us >= stats.writes * 100 + stats.sectors_written * 10);
+    CHECK_EQ(stats.busy_events, stats.writes / 4);
+
+    f_unmount("0:");
+    disk_image_close(0);
+    unlink(IMAGE_PATH);
+    return test_result();
+}
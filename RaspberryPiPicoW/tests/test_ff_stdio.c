@@ -0,0 +1,135 @@
+// ff_stdio com o cache de escrita: conteúdo idêntico com e sem buffer, leitura e seek após
+// escrita pendente, pool esgotado; e benchmark byte a byte, por linha e por bloco
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "ff_stdio.h"
+#include "disk_image.h"
+
+#define IMAGE_PATH "test_ff_stdio.img"
+#define IMAGE_SECTORS 16384 // 8 MB
+#define BENCH_SIZE (256 * 1024)
+#define LINE_LEN 37 // Linha típica de log em texto, sem alinhamento com o setor
+#define BLOCK_LEN 4096
+
+static FATFS fs;
+static BYTE work[FF_MAX_SS];
+static char data[BENCH_SIZE];
+static char readback[BENCH_SIZE];
+
+typedef enum { MODE_BYTE, MODE_LINE, MODE_BLOCK } write_mode_t;
+static const char *const MODE_NAMES[] = {"byte", "linha", "bloco"};
+
+/**
+ * @brief Grava data em um arquivo no modo pedido
+ * @return Bytes aceitos
+ */
+static size_t write_mode(FF_FILE *fp, write_mode_t mode, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        size_t n = mode == MODE_BYTE ? 1 : mode == MODE_LINE ? LINE_LEN : BLOCK_LEN;
+        if (n > size - done)
+            n = size - done;
+        if (mode == MODE_BYTE) {
+            if (ff_fputc(data[done], fp) != (unsigned char)data[done])
+                break;
+        } else if (ff_fwrite(data + done, 1, n, fp) != n) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * @brief Confere o conteúdo de um arquivo contra data
+ */
+static bool file_matches(const char *path, size_t size) {
+    FF_FILE *fp = ff_fopen(path, "r");
+    if (!fp)
+        return false;
+    memset(readback, 0, size);
+    size_t n = ff_fread(readback, 1, BENCH_SIZE, fp);
+    ff_fclose(fp);
+    return n == size && memcmp(readback, data, size) == 0;
+}
+
+/**
+ * @brief Grava um arquivo em um modo, com ou sem cache, e mostra o tempo e as gravações no disco
+ */
+static void bench(write_mode_t mode, bool buffered) {
+    const char *path = "0:/bench.txt";
+    disk_image_stats(0, true);
+    uint64_t start = test_now_us();
+    FF_FILE *fp = ff_fopen(path, "w");
+    CHECK(fp != NULL);
+    if (!fp)
+        return;
+    if (!buffered)
+        CHECK_EQ(ff_setbuf(fp, 0), 0);
+    CHECK_EQ(write_mode(fp, mode, BENCH_SIZE), BENCH_SIZE);
+    CHECK_EQ(ff_fclose(fp), 0);
+    uint64_t us = test_now_us() - start;
+    disk_image_stats_t stats = disk_image_stats(0, false);
+    printf("%-6s %-9s %8.1f MB/s %6llu gravações no disco\n", MODE_NAMES[mode], buffered ? "com cache" : "sem cache",
+           us ? (double)BENCH_SIZE / us : 0.0, (unsigned long long)stats.writes);
+    CHECK(file_matches(path, BENCH_SIZE));
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = (i + 1) % LINE_LEN == 0 ? '\n' : (char)('a' + (i * 7) % 26);
+
+    unlink(IMAGE_PATH);
+    CHECK(disk_image_open(0, IMAGE_PATH, IMAGE_SECTORS));
+    const MKFS_PARM opt = {.fmt = FM_ANY | FM_SFD};
+    CHECK_EQ(f_mkfs("0:", &opt, work, sizeof(work)), FR_OK);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+
+    // Leitura, posição e seek enxergam os bytes ainda no cache
+    FF_FILE *fp = ff_fopen("0:/mixed.txt", "w+");
+    CHECK(fp != NULL);
+    CHECK_EQ(ff_fwrite(data, 1, 100, fp), 100);
+    CHECK_EQ(ff_ftell(fp), 100);
+    CHECK_EQ(ff_filelength(fp), 100);
+    CHECK_EQ(ff_fseek(fp, 10, FF_SEEK_SET), 0);
+    char buf[16] = {0};
+    CHECK_EQ(ff_fread(buf, 1, 8, fp), 8);
+    CHECK(memcmp(buf, data + 10, 8) == 0);
+    CHECK_EQ(ff_fseek(fp, 0, FF_SEEK_END), 0);
+    CHECK_EQ(ff_fputc(data[100], fp), (unsigned char)data[100]);
+    CHECK_EQ(ff_fsync(fp), 0);
+    CHECK_EQ(ff_fclose(fp), 0);
+    CHECK(file_matches("0:/mixed.txt", 101));
+
+    // Pool esgotado: o terceiro arquivo fica sem cache e o conteúdo continua correto
+    FF_FILE *files[FF_STDIO_WBUF_COUNT + 1];
+    char path[32];
+    for (int i = 0; i <= FF_STDIO_WBUF_COUNT; i++) {
+        snprintf(path, sizeof(path), "0:/pool%d.txt", i);
+        files[i] = ff_fopen(path, "w");
+        CHECK(files[i] != NULL);
+    }
+    FF_FILE *extra = ff_fopen("0:/extra.txt", "w");
+    CHECK(extra != NULL);
+    CHECK(ff_setbuf(extra, 1) != 0); // Nenhum buffer livre
+    ff_fclose(extra);
+    for (size_t off = 0; off < 3000; off += LINE_LEN)
+        for (int i = 0; i <= FF_STDIO_WBUF_COUNT; i++)
+            ff_fwrite(data + off, 1, off + LINE_LEN <= 3000 ? LINE_LEN : 3000 - off, files[i]);
+    for (int i = 0; i <= FF_STDIO_WBUF_COUNT; i++) {
+        CHECK_EQ(ff_fclose(files[i]), 0);
+        snprintf(path, sizeof(path), "0:/pool%d.txt", i);
+        CHECK(file_matches(path, 3000));
+    }
+
+    for (write_mode_t mode = MODE_BYTE; mode <= MODE_BLOCK; mode++) {
+        bench(mode, false);
+        bench(mode, true);
+    }
+
+    f_unmount("0:");
+    disk_image_close(0);
+    unlink(IMAGE_PATH);
+    return test_result();
+}
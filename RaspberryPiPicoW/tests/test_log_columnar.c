@@ -0,0 +1,249 @@
+// Formato colunar (log_columnar.c) sobre o backend em imagem: três dias de amostras sintéticas
+// a 2 Hz, consultas agregadas conferidas contra a soma direta das amostras, taxa de compressão
+// em relação ao log binário e custo das consultas (tempo e setores lidos)
+#include <unistd.h>
+#include "test.h"
+#include "log_columnar.h"
+#include "log_writer.h"
+#include "disk_image.h"
+
+#define IMAGE_PATH "test_log_columnar.img"
+#define IMAGE_SECTORS (64 * 2048) // 64 MB
+#define DAYS 3
+#define T0 1767225600 // 2026-01-01 00:00:00 UTC
+#define DAY_S (24 * 3600)
+#define SAMPLES (DAYS * DAY_S * (1000 / SENSOR_SAMPLE_PERIOD_MS))
+#define BOOT_MS 1234 // t_ms da primeira amostra
+#define RTC_PHASE_MS 700 // Fração de segundo do RTC na primeira amostra (não coincide com a do t_ms)
+#define RANDOM_QUERIES 300
+
+static FATFS fs;
+static BYTE work[FF_MAX_SS];
+static uint32_t times[SAMPLES];
+static int16_t values[SAMPLES][SENSOR_CH_COUNT];
+/**
+ * @brief Série sintética: ciclo diário em temperatura e umidade, ruído nos demais canais
+ */
+static void generate(void) {
+    for (int i = 0; i < SAMPLES; i++) {
+        times[i] = T0 + (RTC_PHASE_MS + (uint32_t)i * SENSOR_SAMPLE_PERIOD_MS) / 1000;
+        float day = sinf(6.2831853f * (times[i] - T0) / DAY_S);
+        float v[SENSOR_CH_COUNT] = {
+            [SENSOR_CH_TEMPERATURE] = 25 + 5 * day + 0.05f * test_gauss(),
+            [SENSOR_CH_HUMIDITY] = 60 - 10 * day + 0.2f * test_gauss(),
+            [SENSOR_CH_ALTITUDE] = 800 + 0.3f * test_gauss(),
+            [SENSOR_CH_GYROSCOPE] = 2 + 0.05f * test_gauss(),
+            [SENSOR_CH_ACCELERATION] = 1 + 0.02f * test_gauss(),
+            [SENSOR_CH_GYROSCOPE_X] = 0.05f * test_gauss(),
+            [SENSOR_CH_GYROSCOPE_Y] = 0.05f * test_gauss(),
+            [SENSOR_CH_GYROSCOPE_Z] = 0.05f * test_gauss(),
+            [SENSOR_CH_ACCELERATION_X] = 0.02f * test_gauss(),
+            [SENSOR_CH_ACCELERATION_Y] = 0.02f * test_gauss(),
+            [SENSOR_CH_ACCELERATION_Z] = 1 + 0.02f * test_gauss(),
+        };
+        for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+            values[i][ch] = history_from_float(ch, v[ch]);
+    }
+}
+
+/**
+ * @brief Agregado esperado, somando as amostras do intervalo uma a uma
+ */
+static log_col_query_t expected(int ch, uint32_t from, uint32_t to) {
+    log_col_query_t e = {.channel = ch, .from = from, .to = to};
+    for (int i = 0; i < SAMPLES; i++) {
+        if (times[i] < from || times[i] > to)
+            continue;
+        int16_t v = values[i][ch];
+        if (e.count == 0 || v < e.min) e.min = v;
+        if (e.count == 0 || v > e.max) e.max = v;
+        e.count++;
+        e.sum += v;
+    }
+    return e;
+}
+
+static uint64_t step_sectors_max; // Pior passo da varredura, em setores lidos do cartão
+static uint64_t step_us_max; // Pior passo da varredura, em tempo
+
+/**
+ * @brief Executa uma consulta passo a passo, como o servidor HTTP
+ * @return Setores lidos pela consulta
+ */
+static uint64_t run_query(int ch, uint32_t from, uint32_t to, log_col_query_t *q) {
+    uint64_t sectors = 0;
+    disk_image_stats(0, true);
+    CHECK(log_col_query_begin(q, ch, from, to));
+    bool finished = false;
+    while (!finished) {
+        uint64_t t = test_now_us();
+        finished = log_col_query_step(q);
+        t = test_now_us() - t;
+        uint64_t step = disk_image_stats(0, true).sectors_read;
+        sectors += step;
+        if (step > step_sectors_max)
+            step_sectors_max = step;
+        if (t > step_us_max)
+            step_us_max = t;
+    }
+    return sectors;
+}
+
+/**
+ * @brief Executa uma consulta e confere contra o agregado esperado
+ * @return Setores lidos pela consulta
+ */
+static uint64_t check_query(int ch, uint32_t from, uint32_t to, log_col_query_t *q) {
+    uint64_t sectors = run_query(ch, from, to, q);
+    log_col_query_t e = expected(ch, from, to);
+    if (q->count != e.count || q->sum != e.sum || (e.count && (q->min != e.min || q->max != e.max)))
+        printf("canal %d [%lu, %lu]: %lu amostras (esperado %lu)\n", ch, (unsigned long)from, (unsigned long)to,
+               (unsigned long)q->count, (unsigned long)e.count);
+    CHECK_EQ(q->count, e.count);
+    CHECK_EQ(q->sum, e.sum);
+    if (e.count) {
+        CHECK_EQ(q->min, e.min);
+        CHECK_EQ(q->max, e.max);
+    }
+    return sectors;
+}
+
+/**
+ * @brief Soma o tamanho dos arquivos de LOG_DIR com uma extensão
+ */
+static uint64_t dir_bytes(const char *ext) {
+    DIR dir;
+    FILINFO fno;
+    uint64_t total = 0;
+    if (f_opendir(&dir, LOG_DIR) != FR_OK)
+        return 0;
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != 0) {
+        size_t len = strlen(fno.fname);
+        if (len > strlen(ext) && !strcmp(fno.fname + len - strlen(ext), ext))
+            total += fno.fsize;
+    }
+    f_closedir(&dir);
+    return total;
+}
+
+int main(void) {
+    test_seed(777);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    generate();
+
+    unlink(IMAGE_PATH);
+    CHECK(disk_image_open(0, IMAGE_PATH, IMAGE_SECTORS));
+    const MKFS_PARM opt = {.fmt = FM_ANY | FM_SFD};
+    CHECK_EQ(f_mkfs("0:", &opt, work, sizeof(work)), FR_OK);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    CHECK_EQ(f_mkdir(LOG_DIR), FR_OK);
+
+    uint64_t start = test_now_us();
+    for (int i = 0; i < SAMPLES; i++)
+        log_col_append(times[i], BOOT_MS + (uint32_t)i * SENSOR_SAMPLE_PERIOD_MS, values[i]);
+    log_col_flush();
+    uint64_t append_us = test_now_us() - start;
+    CHECK_EQ(metrics_read(&metrics.log_write_errors), 0);
+    CHECK_EQ(metrics_read(&metrics.log_col_samples), (uint64_t)SAMPLES * SENSOR_CH_COUNT);
+
+    // Compressão: o log binário gasta LOG_RECORD_SIZE bytes por amostra de todos os canais
+    uint64_t raw = (uint64_t)SAMPLES * LOG_RECORD_SIZE;
+    uint64_t col = dir_bytes(LOG_COL_EXT), cdx = dir_bytes(LOG_COL_DIR_EXT);
+    uint64_t payload = metrics_read(&metrics.log_col_payload_bytes);
+    printf("%d amostras x %d canais em %.1f s: binário %.1f MB, colunar %.1f MB + %.1f KB de cabeçalhos "
+           "(%.2fx); %.2f bytes por valor codificado\n",
+           SAMPLES, SENSOR_CH_COUNT, append_us / 1e6, raw / 1e6, col / 1e6, cdx / 1e3, (double)raw / (col + cdx),
+           (double)payload / ((uint64_t)SAMPLES * SENSOR_CH_COUNT));
+    CHECK(col + cdx < raw / 2);
+    CHECK_EQ(cdx / sizeof(log_col_header_t), col / LOG_COL_BLOCK_SIZE);
+
+    // Dia inteiro: só os resumos dos cabeçalhos, sem decodificar nenhum bloco
+    log_col_query_t q;
+    for (int d = 0; d < DAYS; d++) {
+        uint64_t sectors = check_query(SENSOR_CH_TEMPERATURE, T0 + d * DAY_S, T0 + (d + 1) * DAY_S - 1, &q);
+        CHECK_EQ(q.files, 1);
+        CHECK_EQ(q.blocks_decoded, 0);
+        CHECK(q.blocks_summary > 0);
+        if (d == 1)
+            printf("dia inteiro: %lu blocos pelo resumo, %lu descartados, %llu setores lidos (%llu no log binário)\n",
+                   (unsigned long)q.blocks_summary, (unsigned long)q.blocks_skipped, (unsigned long long)sectors,
+                   (unsigned long long)(raw / DAYS / LOG_SECTOR_SIZE));
+    }
+
+    // Atravessando a meia-noite: dois arquivos e blocos de borda decodificados
+    check_query(SENSOR_CH_HUMIDITY, T0 + DAY_S - 1800, T0 + DAY_S + 1800, &q);
+    CHECK_EQ(q.files, 2);
+    CHECK(q.blocks_decoded > 0);
+
+    // Intervalos de um segundo, inclusive a primeira e a última amostra de cada bloco
+    check_query(SENSOR_CH_ALTITUDE, T0, T0, &q);
+    CHECK_EQ(q.count, 1); // Fase de 700 ms: só uma amostra no primeiro segundo
+    check_query(SENSOR_CH_ALTITUDE, times[SAMPLES - 1], times[SAMPLES - 1], &q);
+    check_query(SENSOR_CH_ACCELERATION_Z, T0 + 12345, T0 + 12345, &q);
+    CHECK_EQ(q.count, 2);
+
+    // Fora dos dados
+    check_query(SENSOR_CH_GYROSCOPE, T0 - 3600, T0 - 1, &q);
+    CHECK_EQ(q.count, 0);
+    CHECK_EQ(q.files, 0);
+
+    // Pelo gerador do HTTP: nada sai até a varredura terminar, um passo por chamada
+    bool done = false;
+    char json[384];
+    size_t len = 0;
+    int calls = 0;
+    CHECK(log_col_query_begin(&q, SENSOR_CH_TEMPERATURE, T0 + 3600, T0 + 7200));
+    while (!done && calls < 100000) {
+        len = log_col_query_read(&q, json, sizeof(json), &done);
+        calls++;
+        CHECK(done || len == 0);
+    }
+    CHECK_EQ(calls, q.steps);
+    CHECK(calls > 1);
+    CHECK(done && len > 0 && len < sizeof(json));
+    CHECK_EQ(q.count, expected(SENSOR_CH_TEMPERATURE, T0 + 3600, T0 + 7200).count);
+    char count[32];
+    snprintf(count, sizeof(count), "\"count\":%lu,", (unsigned long)q.count);
+    CHECK(strstr(json, count) != NULL);
+    CHECK(strstr(json, "\"channel\":\"temperature\"") != NULL);
+
+    // Intervalos e canais aleatórios: tempo e setores lidos por consulta
+    uint64_t query_us = 0, sectors = 0, decoded = 0, summary = 0, steps = 0;
+    for (int k = 0; k < RANDOM_QUERIES; k++) {
+        uint32_t from = T0 - 600 + test_random_below(DAYS * DAY_S + 1200);
+        uint32_t to = from + test_random_below(k % 3 == 0 ? DAY_S : 3600);
+        int ch = test_random_below(SENSOR_CH_COUNT);
+        uint64_t t = test_now_us();
+        sectors += check_query(ch, from, to, &q);
+        query_us += test_now_us() - t;
+        decoded += q.blocks_decoded;
+        summary += q.blocks_summary;
+        steps += q.steps;
+    }
+    printf("%d consultas aleatórias: %.0f µs, %.1f setores lidos e %.1f passos por consulta, %.2f blocos "
+           "decodificados e %.1f pelo resumo; pior passo %llu setores, %llu µs\n",
+           RANDOM_QUERIES, (double)query_us / RANDOM_QUERIES, (double)sectors / RANDOM_QUERIES,
+           (double)steps / RANDOM_QUERIES, (double)decoded / RANDOM_QUERIES, (double)summary / RANDOM_QUERIES,
+           (unsigned long long)step_sectors_max, (unsigned long long)step_us_max);
+    // Cada passo lê no máximo o orçamento, mais os dois blocos de borda de um setor de cabeçalhos e
+    // a abertura dos arquivos (diretório e FAT)
+    CHECK(step_sectors_max <= LOG_COL_QUERY_STEP_SECTORS + 2 * LOG_COL_BLOCK_SIZE / LOG_SECTOR_SIZE + 16);
+
+    // Gravação de blocos no meio de uma consulta: a varredura não deixa os arquivos do dia abertos
+    CHECK(log_col_query_begin(&q, SENSOR_CH_TEMPERATURE, T0, T0 + DAYS * DAY_S));
+    CHECK(!log_col_query_step(&q));
+    for (int i = 0; i < 4000; i++)
+        log_col_append(times[SAMPLES - 1] + 1 + i / 2, BOOT_MS + (uint32_t)(SAMPLES + i) * SENSOR_SAMPLE_PERIOD_MS,
+                       values[i]);
+    log_col_flush();
+    CHECK_EQ(metrics_read(&metrics.log_write_errors), 0);
+    while (!log_col_query_step(&q))
+        ;
+    CHECK(q.count >= expected(SENSOR_CH_TEMPERATURE, T0, T0 + DAYS * DAY_S).count);
+
+    f_unmount("0:");
+    disk_image_close(0);
+    unlink(IMAGE_PATH);
+    return test_result();
+}
@@ -0,0 +1,323 @@
+// Recuperação do log binário após queda de energia (log_writer.c sobre o backend em imagem).
+// Cada tentativa grava registros até um corte de energia em um ponto aleatório; no próximo boot
+// (outro processo, com o estado do módulo zerado) o setor seguinte ao último gravado é danificado
+// e log_writer_open faz a recuperação. O log recuperado deve ser um prefixo íntegro e contínuo
+// do que foi gravado, sem perder nada do que chegou ao cartão
+#include <sys/wait.h>
+#include <unistd.h>
+#include "test.h"
+#include "log_writer.h"
+#include "hw_config.h"
+#include "diskio.h"
+#include "disk_image.h"
+
+#define IMAGE_PATH (LOG_WRITER_PREALLOC ? "test_log_recovery.img" : "test_log_recovery_fwrite.img")
+#define IMAGE_SECTORS (16 * 2048) // 16 MB
+#define T0 1767225600 // 2026-01-01 00:00:00 UTC
+#define TRIALS 60
+#define RECORDS_MAX 6000
+#define RECORDS_PER_SECTOR (LOG_SECTOR_SIZE / LOG_RECORD_SIZE)
+#if LOG_WRITER_PREALLOC
+#define LOG_PATH LOG_DIR "/20260101_00.bin"
+#define LOG_DATA_START LOG_SECTOR_SIZE // Registros depois do setor de cabeçalho
+#else
+#define LOG_PATH LOG_DIR "/20260101.bin"
+#define LOG_DATA_START 0
+#endif
+
+// Conteúdo gravado no setor seguinte ao último que chegou ao cartão antes da recuperação
+typedef enum {
+    DAMAGE_NONE, // Setor como ficou
+    DAMAGE_GARBAGE, // Bytes aleatórios
+    DAMAGE_TORN, // Metade com os próximos registros e o resto aleatório (escrita interrompida)
+    DAMAGE_OLD, // Próximos registros, mas com o instante de um arquivo antigo (clusters reaproveitados)
+    DAMAGE_REPEAT, // Cópia de um setor anterior do mesmo arquivo (sequência quebrada)
+    DAMAGE_VALID, // Os próximos registros íntegros: a recuperação deve aceitá-los
+    DAMAGE_COUNT
+} damage_t;
+
+static const char *const DAMAGE_NAMES[DAMAGE_COUNT] = {"nenhum", "lixo", "rasgado", "antigo", "repetido", "válido"};
+
+typedef struct {
+    uint32_t appended; // Registros aceitos por log_writer_append
+    uint32_t landed; // Registros que chegaram à imagem antes do corte
+} cut_result_t;
+
+typedef struct {
+    uint32_t checkpointed; // Registros confirmados pelo último checkpoint (ou f_sync) antes da queda
+    uint32_t recovered; // Registros no log após a recuperação
+    uint32_t scan_us; // Duração de log_writer_open
+} recovery_result_t;
+
+static FATFS fs;
+static BYTE work[FF_MAX_SS];
+static uint8_t sector[LOG_SECTOR_SIZE];
+/**
+ * @brief Leitura sintética de um registro (determinada pela sequência)
+ */
+static void readings(uint32_t seq, SensorReadings *r) {
+    static const float base[SENSOR_CH_COUNT] = {25, 60, 800, 2, 1, 0, 0, 0, 0, 0, 1};
+    memset(r, 0, sizeof(*r));
+    float *v = &r->temperature;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        v[ch] = base[ch] + 0.01f * (int)((seq * 7 + ch * 13) % 101) - 0.5f;
+}
+
+/**
+ * @brief Monta um registro como log_writer_append
+ */
+static void record_make(log_record_t *rec, uint32_t seq, uint32_t t) {
+    SensorReadings r;
+    readings(seq, &r);
+    memset(rec, 0, sizeof(*rec));
+    rec->len = sizeof(*rec);
+    rec->channels = SENSOR_CH_COUNT;
+    rec->seq = seq;
+    rec->t = t;
+    rec->t_ms = seq * SENSOR_SAMPLE_PERIOD_MS;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        rec->value[ch] = history_from_float(ch, sensor_channel_value(&r, ch));
+    rec->crc = log_record_crc(rec);
+}
+
+/**
+ * @brief Primeiro boot: grava até o corte de energia depois de cut_after escritas no cartão
+ */
+static void write_until_cut(uint32_t cut_after, cut_result_t *out) {
+    CHECK(disk_image_open(0, IMAGE_PATH, IMAGE_SECTORS));
+    const MKFS_PARM opt = {.fmt = FM_ANY | FM_SFD};
+    CHECK_EQ(f_mkfs("0:", &opt, work, sizeof(work)), FR_OK);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    host_set_time(T0);
+    CHECK(log_writer_open());
+
+    disk_image_profile_t cut = {.power_cut_after_writes = cut_after};
+    disk_image_set_profile(0, &cut);
+    int after_cut = 0;
+    for (uint32_t seq = 0; seq < RECORDS_MAX && after_cut < 3 * LOG_WRITER_BUF_SIZE / LOG_RECORD_SIZE; seq++) {
+        SensorReadings r;
+        readings(seq, &r);
+        host_advance_us(SENSOR_SAMPLE_PERIOD_MS * 1000);
+        log_writer_append(&r, seq * SENSOR_SAMPLE_PERIOD_MS);
+        if (log_writer_pending())
+            log_writer_service();
+        if (disk_image_stats(0, false).write_failures)
+            after_cut++; // Continua um pouco depois do corte, como o firmware faria
+    }
+    out->appended = metrics_read(&metrics.log_records);
+    out->landed = (uint32_t)(sd_stream_sectors * RECORDS_PER_SECTOR);
+    // Sem desmontar nem fechar: a energia acabou
+}
+
+/**
+ * @brief Posição no cartão do setor de um arquivo
+ * @return LBA, ou 0 se a posição está fora do arquivo
+ */
+static LBA_t file_sector(const char *path, FSIZE_t pos) {
+    FIL f;
+    BYTE b;
+    UINT br = 0;
+    LBA_t lba = 0;
+    if (f_open(&f, path, FA_READ) != FR_OK)
+        return 0;
+    if (pos + LOG_SECTOR_SIZE <= f_size(&f) && f_lseek(&f, pos) == FR_OK && f_read(&f, &b, 1, &br) == FR_OK && br)
+        lba = f.sect;
+    f_close(&f);
+    return lba;
+}
+
+/**
+ * @brief Grava no setor pos do log o conteúdo do dano escolhido
+ * @return false se o setor ficou como estava
+ */
+static bool damage_sector(damage_t damage, FSIZE_t pos, uint32_t next_seq) {
+    LBA_t lba = file_sector(LOG_PATH, pos);
+    if (damage == DAMAGE_NONE || !lba)
+        return false;
+    if (damage == DAMAGE_REPEAT && next_seq < RECORDS_PER_SECTOR)
+        damage = DAMAGE_GARBAGE; // Ainda não há setor anterior para repetir
+    log_record_t *records = (log_record_t *)sector;
+    for (int i = 0; i < RECORDS_PER_SECTOR; i++)
+        record_make(&records[i], next_seq + i, damage == DAMAGE_OLD ? T0 - 86400 : T0 + 3600);
+    if (damage == DAMAGE_GARBAGE || damage == DAMAGE_TORN)
+        for (size_t i = damage == DAMAGE_GARBAGE ? 0 : LOG_SECTOR_SIZE / 2; i < LOG_SECTOR_SIZE; i++)
+            sector[i] = (uint8_t)test_random_below(256);
+    if (damage == DAMAGE_REPEAT)
+        for (int i = 0; i < RECORDS_PER_SECTOR; i++)
+            record_make(&records[i], next_seq - RECORDS_PER_SECTOR + i, T0 + 3600);
+    CHECK_EQ(disk_write(0, sector, lba, 1), RES_OK);
+    return true;
+}
+
+/**
+ * @brief Confere os registros do log: sequência a partir de 0, CRC e valores da leitura sintética
+ * @return Registros íntegros em sequência
+ */
+static uint32_t verify_log(FSIZE_t end) {
+    FIL f;
+    UINT br = 0;
+    uint32_t count = 0, t_prev = 0;
+    CHECK_EQ(f_open(&f, LOG_PATH, FA_READ), FR_OK);
+    f_lseek(&f, LOG_DATA_START);
+    for (FSIZE_t pos = LOG_DATA_START; pos + LOG_RECORD_SIZE <= end; pos += LOG_RECORD_SIZE) {
+        log_record_t rec, want;
+        if (f_read(&f, &rec, sizeof(rec), &br) != FR_OK || br != sizeof(rec))
+            break;
+        record_make(&want, count, rec.t);
+        want.t_ms = rec.t_ms;
+        want.crc = log_record_crc(&want);
+        if (memcmp(&rec, &want, sizeof(rec)) != 0 || rec.t < t_prev || rec.t < T0) {
+            printf("registro %lu em %lu não confere\n", (unsigned long)count, (unsigned long)pos);
+            CHECK(false);
+            break;
+        }
+        t_prev = rec.t;
+        count++;
+    }
+    f_close(&f);
+
+    // O índice só aponta para registros recuperados
+    char idx_path[sizeof(LOG_PATH LOG_INDEX_EXT)];
+    snprintf(idx_path, sizeof(idx_path), "%s%s", LOG_PATH, LOG_INDEX_EXT);
+    if (f_open(&f, idx_path, FA_READ) == FR_OK) {
+        log_index_entry_t e;
+        while (f_read(&f, &e, sizeof(e), &br) == FR_OK && br == sizeof(e))
+            CHECK(e.offset >= LOG_DATA_START && e.offset < end);
+        f_close(&f);
+    }
+    return count;
+}
+
+/**
+ * @brief Próximo boot: danifica o setor após o último gravado, recupera e confere o log
+ */
+static void recover(const cut_result_t *cut, damage_t damage, recovery_result_t *out) {
+    CHECK(disk_image_open(0, IMAGE_PATH, 0));
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    host_set_time(T0 + 7200); // O relógio segue: o mesmo dia
+
+    FIL f;
+    UINT br = 0;
+    CHECK_EQ(f_open(&f, LOG_PATH, FA_READ), FR_OK);
+#if LOG_WRITER_PREALLOC
+    log_prealloc_header_t header;
+    CHECK_EQ(f_read(&f, &header, sizeof(header), &br), FR_OK);
+    CHECK_EQ(header.flags & LOG_HEADER_CLOSED, 0);
+    out->checkpointed = header.used / LOG_RECORD_SIZE;
+    FSIZE_t damage_pos = LOG_DATA_START + (FSIZE_t)cut->landed * LOG_RECORD_SIZE;
+    uint32_t next_seq = cut->landed;
+#else
+    out->checkpointed = f_size(&f) / LOG_RECORD_SIZE; // O tamanho só muda no f_sync
+    FSIZE_t damage_pos = f_size(&f) >= LOG_SECTOR_SIZE ? f_size(&f) - LOG_SECTOR_SIZE : 0;
+    uint32_t next_seq = damage_pos / LOG_RECORD_SIZE;
+#endif
+    f_close(&f);
+    bool damaged = damage_sector(damage, damage_pos, next_seq);
+
+    uint64_t start = test_now_us();
+    CHECK(log_writer_open());
+    out->scan_us = (uint32_t)(test_now_us() - start);
+
+    // Remonta para ler o log sem a trava do arquivo que o módulo deixou aberto
+    f_unmount("0:");
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    CHECK_EQ(f_open(&f, LOG_PATH, FA_READ), FR_OK);
+#if LOG_WRITER_PREALLOC
+    CHECK_EQ(f_read(&f, &header, sizeof(header), &br), FR_OK);
+    CHECK(header.flags & LOG_HEADER_CLOSED);
+    FSIZE_t end = LOG_DATA_START + header.used;
+    CHECK_EQ(f_size(&f), end); // O resto da extensão voltou para a FAT
+#else
+    FSIZE_t end = f_size(&f);
+#endif
+    f_close(&f);
+    out->recovered = verify_log(end);
+    CHECK_EQ((FSIZE_t)out->recovered * LOG_RECORD_SIZE, end - LOG_DATA_START); // Nada além do prefixo íntegro
+
+    CHECK(out->recovered <= cut->appended);
+#if LOG_WRITER_PREALLOC
+    // Tudo o que chegou ao cartão volta, mais o setor válido plantado, e nada do que foi danificado
+    CHECK(out->checkpointed <= cut->landed);
+    CHECK_EQ(out->recovered, cut->landed + (damaged && damage == DAMAGE_VALID ? RECORDS_PER_SECTOR : 0));
+#else
+    // O tamanho confirmado vale, menos o último setor se ele foi danificado
+    uint32_t lost = damaged ? RECORDS_PER_SECTOR : 0;
+    CHECK_EQ(out->recovered, out->checkpointed - lost);
+#endif
+    f_unmount("0:");
+    disk_image_close(0);
+}
+
+/**
+ * @brief Executa fn num processo novo (estado do módulo zerado, como após um boot) e traz o resultado
+ */
+static void run_boot(void (*fn)(void *arg, void *out), void *arg, void *out, size_t size) {
+    int fds[2];
+    CHECK_EQ(pipe(fds), 0);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        fn(arg, out);
+        CHECK_EQ(write(fds[1], out, size), (ssize_t)size);
+        fflush(stdout);
+        _exit(test_failures ? 1 : 0);
+    }
+    close(fds[1]);
+    CHECK_EQ(read(fds[0], out, size), (ssize_t)size);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+typedef struct {
+    uint32_t cut_after;
+    cut_result_t cut;
+    damage_t damage;
+} trial_t;
+
+static void boot_write(void *arg, void *out) {
+    write_until_cut(((trial_t *)arg)->cut_after, out);
+}
+
+static void boot_recover(void *arg, void *out) {
+    recover(&((trial_t *)arg)->cut, ((trial_t *)arg)->damage, out);
+}
+
+int main(void) {
+    test_seed(4242);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    uint64_t appended = 0, landed = 0, checkpointed = 0, recovered = 0, scan_us = 0;
+    int per_damage[DAMAGE_COUNT] = {0};
+    for (int k = 0; k < TRIALS; k++) {
+        trial_t trial = {.cut_after = 1 + test_random_below(400), .damage = (damage_t)(k % DAMAGE_COUNT)};
+#if !LOG_WRITER_PREALLOC
+        if (trial.damage == DAMAGE_OLD || trial.damage == DAMAGE_REPEAT || trial.damage == DAMAGE_VALID)
+            trial.damage = DAMAGE_GARBAGE; // Dentro do tamanho confirmado só há o que o arquivo gravou
+#endif
+        unlink(IMAGE_PATH);
+        run_boot(boot_write, &trial, &trial.cut, sizeof(trial.cut));
+        recovery_result_t result;
+        run_boot(boot_recover, &trial, &result, sizeof(result));
+        appended += trial.cut.appended;
+        landed += trial.cut.landed;
+        checkpointed += result.checkpointed;
+        recovered += result.recovered;
+        scan_us += result.scan_us;
+        per_damage[trial.damage]++;
+    }
+    unlink(IMAGE_PATH);
+
+    printf("%d quedas (%s): %llu registros aceitos, ", TRIALS, LOG_WRITER_PREALLOC ? "pré-alocado" : "f_write",
+           (unsigned long long)appended);
+    if (LOG_WRITER_PREALLOC) // No modo f_write os setores passam pelo FatFs, sem a sessão contínua
+        printf("%llu no cartão, ", (unsigned long long)landed);
+    printf("%llu confirmados no checkpoint, %llu recuperados; recuperação em %.0f µs em média\n",
+           (unsigned long long)checkpointed, (unsigned long long)recovered, (double)scan_us / TRIALS);
+    for (int d = 0; d < DAMAGE_COUNT; d++)
+        if (per_damage[d])
+            printf("  dano %-8s %d tentativas\n", DAMAGE_NAMES[d], per_damage[d]);
+    return test_result();
+}
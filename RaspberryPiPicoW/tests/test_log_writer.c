@@ -0,0 +1,258 @@
+// Benchmark do log binário (log_writer.c) sobre um cartão simulado: latência de comando, custo por
+// setor e paradas periódicas de apagamento (disk_image_set_profile). Mede a vazão sustentada em
+// registros/s, o pior tempo de log_writer_append e o pior tempo de gravação de um buffer, e confere
+// que o buffer duplo absorve a pior parada do cartão na taxa de aquisição do firmware
+#include <unistd.h>
+#include "test.h"
+#include "log_writer.h"
+#include "log_columnar.h"
+#include "hw_config.h"
+#include "disk_image.h"
+
+#define IMAGE_PATH (LOG_WRITER_PREALLOC ? "test_log_writer.img" : "test_log_writer_fwrite.img")
+#define IMAGE_SECTORS (16 * 2048) // 16 MB
+#define T0 1767225600 // 2026-01-01 00:00:00 UTC
+#define RECORDS 40000 // Mais que uma extensão pré-alocada: inclui a troca de arquivo
+#define RECORDS_PER_BUFFER (LOG_WRITER_BUF_SIZE / LOG_RECORD_SIZE)
+#define RECORDS_PER_SECTOR (LOG_SECTOR_SIZE / LOG_RECORD_SIZE)
+#define FAILING_BUFFERS 30 // Buffers adquiridos com o cartão recusando escritas (4 minutos)
+
+// Cartão SD em SPI: comando de escrita (ACMD23, CMD25, STOP_TRAN e espera no CMD13), ~1,3 MB/s
+// de dados e uma parada de 80 ms a cada 100 escritas (apagamento de bloco no controlador)
+static const disk_image_profile_t CARD = {
+    .read_us = 500,
+    .read_us_per_sector = 400,
+    .write_us = 2000,
+    .write_us_per_sector = 400,
+    .busy_every_writes = 100,
+    .busy_us = 80000,
+};
+
+static FATFS fs;
+static BYTE work[FF_MAX_SS];
+
+/**
+ * @brief Leitura sintética de um registro
+ */
+static void readings(uint32_t i, SensorReadings *r) {
+    static const float base[SENSOR_CH_COUNT] = {25, 60, 800, 2, 1, 0, 0, 0, 0, 0, 1};
+    memset(r, 0, sizeof(*r));
+    float *v = &r->temperature;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++)
+        v[ch] = base[ch] + 0.01f * (int)((i * 7 + ch * 13) % 101) - 0.5f;
+}
+
+typedef struct {
+    double rate; // Registros/s sustentados (CPU do host mais o tempo simulado do cartão)
+    uint64_t append_max_us; // Pior log_writer_append
+    uint64_t service_max_us; // Pior log_writer_service (CPU mais cartão)
+    uint64_t card_us; // Tempo simulado do cartão
+    uint64_t touched; // Chamadas de log_writer_append que acessaram o cartão
+    uint64_t services; // Buffers gravados
+    uint64_t stream_commands; // Comandos de escrita das sessões (um por sessão, ou por envio no driver antigo)
+    disk_image_stats_t stats;
+} throughput_t;
+
+/**
+ * @brief Comandos enviados ao cartão até agora
+ */
+static uint64_t card_commands(void) {
+    disk_image_stats_t s = disk_image_stats(0, false);
+    return s.reads + s.writes;
+}
+
+/**
+ * @brief Grava RECORDS registros sem pausa, chamando log_writer_service assim que um buffer enche
+ * @param first Índice do primeiro registro
+ * @param out Medidas
+ */
+static void throughput(uint32_t first, throughput_t *out) {
+    memset(out, 0, sizeof(*out));
+    disk_image_stats(0, true);
+    uint64_t stream_commands = sd_stream_commands;
+    uint64_t start = test_now_us();
+    for (uint32_t i = first; i < first + RECORDS; i++) {
+        SensorReadings r;
+        readings(i, &r);
+        uint64_t commands = card_commands();
+        uint64_t t = test_now_us();
+        CHECK(log_writer_append(&r, i * SENSOR_SAMPLE_PERIOD_MS));
+        t = test_now_us() - t;
+        if (t > out->append_max_us)
+            out->append_max_us = t;
+        out->touched += card_commands() != commands;
+        if (!log_writer_pending())
+            continue;
+        uint64_t card = disk_image_stats(0, false).simulated_us;
+        t = test_now_us();
+        log_writer_service();
+        t = test_now_us() - t;
+        card = disk_image_stats(0, false).simulated_us - card;
+        host_advance_us(card); // Os prazos de checkpoint e do índice correm com o cartão
+        out->card_us += card;
+        out->services++;
+        if (t + card > out->service_max_us)
+            out->service_max_us = t + card;
+    }
+    out->stats = disk_image_stats(0, false);
+    out->stream_commands = sd_stream_commands - stream_commands;
+    out->rate = RECORDS * 1e6 / (test_now_us() - start + out->card_us);
+}
+
+/**
+ * @brief Mostra as medidas de uma rodada
+ */
+static void print_throughput(const char *label, const throughput_t *m) {
+    printf("%s: %d registros, %.0f registros/s sustentados (%.0fx a taxa de aquisição); %.2f comandos e "
+           "%.1f ms de cartão por buffer; pior log_writer_append %llu µs, pior gravação de buffer %.1f ms, "
+           "%llu paradas do cartão\n",
+           label, RECORDS, m->rate, m->rate * SENSOR_SAMPLE_PERIOD_MS / 1000,
+           (double)(m->stats.reads + m->stats.writes) / m->services, m->card_us / 1e3 / m->services,
+           (unsigned long long)m->append_max_us, m->service_max_us / 1e3, (unsigned long long)m->stats.busy_events);
+}
+
+/**
+ * @brief Conta os logs binários em LOG_DIR
+ */
+static uint32_t count_logs(void) {
+    DIR dir;
+    FILINFO fno;
+    uint32_t n = 0;
+    if (f_opendir(&dir, LOG_DIR) != FR_OK)
+        return 0;
+    size_t ext_len = strlen(LOG_WRITER_EXT);
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0] != 0) {
+        size_t len = strlen(fno.fname);
+        n += len > ext_len && strcmp(fno.fname + len - ext_len, LOG_WRITER_EXT) == 0;
+    }
+    f_closedir(&dir);
+    return n;
+}
+
+/**
+ * @brief Enche um buffer na taxa de aquisição e o entrega a log_writer_service
+ * @param first Índice do primeiro registro
+ */
+static void acquire_buffer(uint32_t first) {
+    for (uint32_t i = first; i < first + RECORDS_PER_BUFFER; i++) {
+        SensorReadings r;
+        readings(i, &r);
+        host_advance_us(SENSOR_SAMPLE_PERIOD_MS * 1000);
+        CHECK(log_writer_append(&r, i * SENSOR_SAMPLE_PERIOD_MS));
+    }
+    CHECK(log_writer_pending());
+    log_writer_service();
+    CHECK(!log_writer_pending());
+}
+
+int main(void) {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    unlink(IMAGE_PATH);
+    CHECK(disk_image_open(0, IMAGE_PATH, IMAGE_SECTORS));
+    const MKFS_PARM opt = {.fmt = FM_ANY | FM_SFD};
+    CHECK_EQ(f_mkfs("0:", &opt, work, sizeof(work)), FR_OK);
+    CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+    host_set_time(T0);
+    disk_image_set_profile(0, &CARD);
+    CHECK(log_writer_open());
+
+    // Vazão: registros tão rápido quanto o cartão aceita, gravando cada buffer assim que enche
+    throughput_t session;
+    throughput(0, &session);
+    print_throughput(LOG_WRITER_PREALLOC ? "pré-alocado, sessão CMD25" : "f_write", &session);
+    double budget_us = RECORDS_PER_BUFFER * SENSOR_SAMPLE_PERIOD_MS * 1000.0; // Enchimento de um buffer
+    printf("pior gravação de buffer: %.2f%% dos %.0f s de enchimento de um buffer\n",
+           100 * session.service_max_us / budget_us, budget_us / 1e6);
+
+    CHECK_EQ(session.touched, 0); // log_writer_append nunca acessa o cartão
+    CHECK_EQ(session.services, RECORDS / RECORDS_PER_BUFFER);
+    CHECK_EQ(metrics_read(&metrics.log_records), RECORDS);
+    CHECK_EQ(metrics_read(&metrics.log_dropped), 0);
+    CHECK_EQ(metrics_read(&metrics.log_write_errors), 0);
+    CHECK_EQ(metrics_read(&metrics.log_payload_sectors) * RECORDS_PER_SECTOR, RECORDS);
+    CHECK(session.stats.busy_events > 0);
+    CHECK(session.rate > 100 * 1000.0 / SENSOR_SAMPLE_PERIOD_MS);
+    // Com o buffer duplo, a pior gravação (parada do cartão ou troca de arquivo) cabe com folga no
+    // tempo em que o outro buffer enche
+    CHECK(session.service_max_us < budget_us / 10);
+
+#if LOG_WRITER_PREALLOC
+    // Mesmo fluxo com o driver antigo: ACMD23, CMD25, STOP_TRAN e CMD13 a cada buffer
+    throughput_t per_command;
+    sd_stream_per_command = true;
+    throughput(RECORDS, &per_command);
+    sd_stream_per_command = false;
+    print_throughput("pré-alocado, comando por buffer", &per_command);
+    printf("sessão CMD25: %.1fx menos comandos de escrita nos dados, %.2fx menos tempo de cartão por buffer\n",
+           (double)per_command.stream_commands / session.stream_commands,
+           (double)per_command.card_us / session.card_us);
+    CHECK_EQ(metrics_read(&metrics.log_write_errors), 0);
+    CHECK_EQ(per_command.stream_commands, per_command.services); // Um comando por buffer
+    CHECK(session.stream_commands < per_command.services / 2);
+    CHECK(session.card_us < per_command.card_us);
+#endif
+
+    // Sem log_writer_service: os dois buffers enchem e o excedente é descartado, sem bloquear
+    uint32_t extra = RECORDS_PER_BUFFER;
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < 2 * RECORDS_PER_BUFFER + extra; i++) {
+        SensorReadings r;
+        readings(2 * RECORDS + i, &r);
+        accepted += log_writer_append(&r, (2 * RECORDS + i) * SENSOR_SAMPLE_PERIOD_MS);
+    }
+    CHECK_EQ(accepted, 2 * RECORDS_PER_BUFFER);
+    CHECK_EQ(metrics_read(&metrics.log_dropped), extra);
+    log_writer_service();
+    CHECK(!log_writer_pending());
+    SensorReadings r;
+    readings(0, &r);
+    CHECK(log_writer_append(&r, 0)); // O buffer gravado volta a receber registros
+    CHECK_EQ(metrics_read(&metrics.log_write_errors), 0);
+    for (uint32_t i = 1; i < RECORDS_PER_BUFFER; i++)
+        CHECK(log_writer_append(&r, 0));
+    log_writer_service();
+
+    // Cartão recusando escritas por alguns minutos: o log espera entre as tentativas e, quando o
+    // cartão volta, continua no mesmo arquivo em vez de reservar outra extensão a cada falha
+    uint32_t logs = count_logs();
+    uint64_t sectors = metrics_read(&metrics.log_payload_sectors);
+    uint64_t dropped = metrics_read(&metrics.log_dropped);
+    disk_image_profile_t failing = CARD;
+    failing.write_fail_ppm = 1000000;
+    disk_image_set_profile(0, &failing);
+    uint32_t first = 3 * RECORDS;
+    for (int i = 0; i < FAILING_BUFFERS; i++, first += RECORDS_PER_BUFFER)
+        acquire_buffer(first);
+    uint64_t errors = metrics_read(&metrics.log_write_errors);
+    printf("%d buffers com o cartão falhando: %llu falhas de gravação\n", FAILING_BUFFERS,
+           (unsigned long long)errors);
+    CHECK(errors >= 1);
+    CHECK(!log_writer_is_open());
+    CHECK_EQ(metrics_read(&metrics.log_payload_sectors), sectors);
+    // Todo buffer que não chegou ao cartão conta como descartado, inclusive o da falha de gravação
+    CHECK_EQ(metrics_read(&metrics.log_dropped) - dropped, FAILING_BUFFERS * RECORDS_PER_BUFFER);
+
+    disk_image_set_profile(0, &CARD);
+    for (int i = 0; i < 8; i++, first += RECORDS_PER_BUFFER)
+        acquire_buffer(first);
+    CHECK(log_writer_is_open());
+    CHECK_EQ(count_logs(), logs);
+    // A espera máxima entre tentativas cabe em poucos buffers
+    uint32_t reopen_buffers = LOG_REOPEN_MAX_MS / (RECORDS_PER_BUFFER * SENSOR_SAMPLE_PERIOD_MS) + 1;
+    CHECK(metrics_read(&metrics.log_payload_sectors) - sectors >=
+          (8 - reopen_buffers) * LOG_WRITER_BUF_SIZE / LOG_SECTOR_SIZE);
+    // O formato colunar tem exatamente os registros gravados no log binário: os buffers perdidos ficam
+    // fora dos dois
+    log_col_flush();
+    log_col_query_t q;
+    CHECK(log_col_query_begin(&q, SENSOR_CH_TEMPERATURE, 0, UINT32_MAX));
+    while (!log_col_query_step(&q))
+        ;
+    CHECK_EQ(q.count, metrics_read(&metrics.log_payload_sectors) * RECORDS_PER_SECTOR);
+
+    f_unmount("0:");
+    disk_image_close(0);
+    unlink(IMAGE_PATH);
+    return test_result();
+}
@@ -0,0 +1,521 @@
+// Renderizador do SSD1306: as primitivas atuais (por byte de coluna, lib/ssd1306.c) devem gerar
+// exatamente o mesmo quadro que as originais, pixel a pixel (copiadas abaixo); o envio das
+// regiões alteradas deve deixar a RAM de um display simulado igual ao buffer. Mede pixels/µs
+// das duas versões e os bytes no barramento I2C por atualização de tela
+#include "test.h"
+#include "ssd1306.h"
+#include "font.h"
+
+#define BENCH_ROUNDS 2000
+
+i2c_inst_t *i2c0, *i2c1;
+static i2c_hw_t i2c_hw = {.status = I2C_IC_STATUS_TFE_BITS}; // FIFO sempre vazia: o envio termina na hora
+
+// Display simulado: GDDRAM, janela de endereçamento e comando em montagem
+static uint8_t gddram[SSD1306_WIDTH][SSD1306_PAGES];
+static uint8_t col0, col1 = SSD1306_WIDTH - 1, page0, page1 = SSD1306_PAGES - 1, col, page;
+static bool vertical;
+static uint8_t cmd[3];
+static int cmd_len;
+static uint64_t wire_bytes; // Bytes no barramento, endereço incluso
+
+static uint32_t rng = 2024;
+
+/**
+ * @brief Tamanho de um comando com seus argumentos
+ */
+static int command_length(uint8_t c) {
+    switch (c) {
+    case SET_COL_ADDR:
+    case SET_PAGE_ADDR:
+        return 3;
+    case SET_MEM_ADDR:
+    case SET_MUX_RATIO:
+    case SET_DISP_OFFSET:
+    case SET_COM_PIN_CFG:
+    case SET_DISP_CLK_DIV:
+    case SET_PRECHARGE:
+    case SET_VCOM_DESEL:
+    case SET_CONTRAST:
+    case SET_CHARGE_PUMP:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Executa um byte de comando (os argumentos podem vir em transações seguintes)
+ */
+static void display_command(uint8_t byte) {
+    cmd[cmd_len++] = byte;
+    if (cmd_len < command_length(cmd[0]))
+        return;
+    cmd_len = 0;
+    if (cmd[0] == SET_MEM_ADDR) {
+        vertical = cmd[1] == 0x01;
+    } else if (cmd[0] == SET_COL_ADDR) {
+        col = col0 = cmd[1];
+        col1 = cmd[2];
+    } else if (cmd[0] == SET_PAGE_ADDR) {
+        page = page0 = cmd[1];
+        page1 = cmd[2];
+    }
+}
+
+/**
+ * @brief Grava um byte de dados na posição atual e avança dentro da janela
+ */
+static void display_data(uint8_t byte) {
+    gddram[col][page] = byte;
+    if (vertical) {
+        if (page++ == page1) {
+            page = page0;
+            col = col == col1 ? col0 : col + 1;
+        }
+    } else if (col++ == col1) {
+        col = col0;
+        page = page == page1 ? page0 : page + 1;
+    }
+}
+
+/**
+ * @brief Recebe uma transação I2C: bytes de controle (Co, D/C) seguidos de comandos ou dados
+ */
+static void display_receive(const uint8_t *bytes, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        uint8_t control = bytes[i++];
+        bool data = control & SSD1306_CTRL_DATA;
+        if (control & 0x80) { // Co = 1: um só byte, depois outro byte de controle
+            if (i < len)
+                data ? display_data(bytes[i++]) : display_command(bytes[i++]);
+            continue;
+        }
+        for (; i < len; i++)
+            data ? display_data(bytes[i]) : display_command(bytes[i]);
+    }
+    wire_bytes += len + 1;
+}
+
+void i2c_init(i2c_inst_t *i2c, uint baudrate) {
+}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    return &i2c_hw;
+}
+
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+    return 0;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    CHECK_EQ(addr, SSD1306_ADDR);
+    display_receive(src, len);
+    return (int)len;
+}
+
+int dma_claim_unused_channel(bool required) {
+    return 0;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    return (dma_channel_config){0};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+}
+
+/**
+ * @brief Entrega a fila de palavras DATA_CMD ao display, uma transação por bit de STOP
+ */
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    const volatile uint16_t *words = read_addr;
+    static uint8_t bytes[SSD1306_TX_WORDS];
+    size_t len = 0;
+    CHECK_EQ(i2c_hw.tar, SSD1306_ADDR);
+    CHECK(transfer_count <= SSD1306_TX_WORDS);
+    for (uint32_t i = 0; i < transfer_count; i++) {
+        bytes[len++] = (uint8_t)words[i];
+        if (words[i] & I2C_IC_DATA_CMD_STOP_BITS) {
+            display_receive(bytes, len);
+            len = 0;
+        }
+    }
+    CHECK_EQ(len, 0); // A última palavra encerra a transação
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return false;
+}
+
+void dma_channel_abort(uint channel) {
+}
+
+// Primitivas originais, pixel a pixel (só o recorte no pixel foi acrescentado:
+// a original escrevia fora do buffer e os casos recortados não seriam comparáveis)
+
+static void ref_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+    if (x >= ssd->width || y >= ssd->height)
+        return;
+    uint16_t index = (y >> 3) + (x << 3) + 1;
+    uint8_t pixel = (y & 0b111);
+    if (value)
+        ssd->ram_buffer[index] |= (1 << pixel);
+    else
+        ssd->ram_buffer[index] &= ~(1 << pixel);
+}
+
+static void ref_fill(ssd1306_t *ssd, bool value) {
+    for (uint8_t y = 0; y < ssd->height; ++y)
+        for (uint8_t x = 0; x < ssd->width; ++x)
+            ref_pixel(ssd, x, y, value);
+}
+
+static void ref_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+    for (uint8_t x = left; x < left + width; ++x) {
+        ref_pixel(ssd, x, top, value);
+        ref_pixel(ssd, x, top + height - 1, value);
+    }
+    for (uint8_t y = top; y < top + height; ++y) {
+        ref_pixel(ssd, left, y, value);
+        ref_pixel(ssd, left + width - 1, y, value);
+    }
+    if (fill)
+        for (uint8_t x = left + 1; x < left + width - 1; ++x)
+            for (uint8_t y = top + 1; y < top + height - 1; ++y)
+                ref_pixel(ssd, x, y, value);
+}
+
+static void ref_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1;
+    int sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+    while (true) {
+        ref_pixel(ssd, x0, y0, value);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int e2 = err * 2;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void ref_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+    for (uint8_t x = x0; x <= x1; ++x)
+        ref_pixel(ssd, x, y, value);
+}
+
+static void ref_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+    for (uint8_t y = y0; y <= y1; ++y)
+        ref_pixel(ssd, x, y, value);
+}
+
+static void ref_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y) {
+    uint16_t index = (c - ' ') * 8;
+    for (uint8_t i = 0; i < 8; ++i) {
+        uint8_t line = font[index + i];
+        for (uint8_t j = 0; j < 8; ++j)
+            ref_pixel(ssd, x + i, y + j, line & (1 << j));
+    }
+}
+
+static void ref_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y) {
+    while (*str) {
+        ref_draw_char(ssd, *str++, x, y);
+        x += 8;
+        if (x + 8 >= ssd->width) {
+            x = 0;
+            y += 8;
+        }
+        if (y + 8 >= ssd->height)
+            break;
+    }
+}
+
+/**
+ * @brief Envio original: janela inteira, um comando por transação e o quadro completo
+ */
+static void ref_send_data(ssd1306_t *ssd) {
+    const uint8_t window[] = {SET_COL_ADDR, 0, ssd->width - 1, SET_PAGE_ADDR, 0, ssd->pages - 1};
+    for (size_t i = 0; i < sizeof(window); i++) {
+        ssd->port_buffer[1] = window[i];
+        i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->port_buffer, 2, false);
+    }
+    i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->ram_buffer, ssd->bufsize, false);
+}
+
+typedef struct {
+    void (*fill)(ssd1306_t *ssd, bool value);
+    void (*rect)(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill);
+    void (*line)(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
+    void (*hline)(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
+    void (*vline)(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
+    void (*draw_char)(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
+    void (*draw_string)(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+    void (*send_data)(ssd1306_t *ssd);
+} renderer_t;
+
+static const renderer_t ORIGINAL = {ref_fill, ref_rect, ref_line, ref_hline, ref_vline,
+                                    ref_draw_char, ref_draw_string, ref_send_data};
+static const renderer_t CURRENT = {ssd1306_fill, ssd1306_rect, ssd1306_line, ssd1306_hline, ssd1306_vline,
+                                   ssd1306_draw_char, ssd1306_draw_string, ssd1306_send_data};
+
+static uint32_t random_below(uint32_t n) {
+    rng = rng * 1103515245u + 12345u;
+    return (rng >> 8) % n;
+}
+
+static void scene_fill(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, true);
+    r->fill(ssd, false);
+    r->fill(ssd, true);
+}
+
+static void scene_rects(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, false);
+    r->rect(ssd, 0, 0, 128, 64, true, false); // Borda da tela
+    r->rect(ssd, 3, 5, 20, 11, true, false);
+    r->rect(ssd, 13, 30, 40, 30, true, true);
+    r->rect(ssd, 17, 35, 30, 21, false, true); // Apaga dentro do anterior
+    r->rect(ssd, 20, 40, 1, 1, true, true);
+    r->rect(ssd, 5, 100, 1, 50, true, false); // Coluna de um pixel por várias páginas
+    r->rect(ssd, 7, 80, 40, 2, true, true); // Duas linhas desalinhadas com a página
+    r->rect(ssd, 50, 90, 38, 14, true, true); // Até o canto
+}
+
+static void scene_lines(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, false);
+    for (int x = 0; x < 128; x += 7) { // Do centro à borda, em todos os octantes
+        r->line(ssd, 64, 32, x, 0, true);
+        r->line(ssd, 64, 32, x, 63, true);
+    }
+    for (int y = 0; y < 64; y += 5) {
+        r->line(ssd, 64, 32, 0, y, true);
+        r->line(ssd, 64, 32, 127, y, true);
+    }
+    r->rect(ssd, 20, 20, 60, 20, true, true);
+    r->line(ssd, 20, 20, 79, 39, false); // Apaga sobre o fundo aceso
+    r->line(ssd, 79, 20, 20, 39, false);
+}
+
+static void scene_hvlines(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, false);
+    for (int y = 0; y < 64; y += 3)
+        r->hline(ssd, y, 127 - y, y, true);
+    for (int x = 1; x < 128; x += 9)
+        r->vline(ssd, x, x % 13, 63 - x % 11, true);
+    r->hline(ssd, 0, 127, 33, false);
+    r->vline(ssd, 64, 0, 63, false);
+    r->vline(ssd, 70, 9, 9, true);
+}
+
+static void scene_text(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, false);
+    r->draw_string(ssd, "CEPEDI   TIC37", 8, 10);
+    r->draw_string(ssd, "Estabelecendo", 12, 30);
+    r->draw_string(ssd, "Conexao", 33, 48);
+    r->draw_string(ssd, "abc", 0, 0);
+    r->draw_string(ssd, "T 25.3C H 61%", 3, 19); // y desalinhado: cada coluna ocupa duas páginas
+    r->rect(ssd, 36, 0, 128, 10, true, true);
+    r->draw_string(ssd, "!\"#$%&'()*+,-./0123456789:;<=>?@[\\]^_`{|}~", 0, 37); // Quebra de linha
+    for (char c = ' '; c <= '~'; c++)
+        r->draw_char(ssd, c, (c - ' ') % 15 * 8 + 4, 55);
+}
+
+static void scene_random(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, false);
+    for (int i = 0; i < 3000; i++) {
+        uint8_t x0 = random_below(128), y0 = random_below(64);
+        uint8_t x1 = random_below(128), y1 = random_below(64);
+        bool value = random_below(4) != 0;
+        switch (random_below(6)) {
+        case 0:
+            r->rect(ssd, MIN(y0, y1), MIN(x0, x1), abs(x1 - x0) + 1, abs(y1 - y0) + 1, value, random_below(2));
+            break;
+        case 1:
+            r->line(ssd, x0, y0, x1, y1, value);
+            break;
+        case 2:
+            r->hline(ssd, MIN(x0, x1), MAX(x0, x1), y0, value);
+            break;
+        case 3:
+            r->vline(ssd, x0, MIN(y0, y1), MAX(y0, y1), value);
+            break;
+        case 4:
+            r->draw_char(ssd, ' ' + random_below('~' - ' ' + 1), MIN(x0, 120), MIN(y0, 56));
+            break;
+        default:
+            r->draw_string(ssd, "Pico W", MIN(x0, 112), MIN(y0, 48));
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Tela de status como status_display, com as primitivas de cada versão
+ */
+static void status_screen(const renderer_t *r, ssd1306_t *ssd, const char *string1, const char *string2) {
+    r->fill(ssd, false);
+    r->draw_string(ssd, "CEPEDI   TIC37", 8, 10);
+    r->draw_string(ssd, string1, 12, 30);
+    if (string2 != NULL)
+        r->draw_string(ssd, string2, 17, 48);
+    r->send_data(ssd);
+}
+
+/**
+ * @brief Confere os dois buffers e a RAM do display simulado contra o buffer atual
+ */
+static bool frames_match(const ssd1306_t *ref, const ssd1306_t *cur) {
+    return ref->ram_buffer[0] == cur->ram_buffer[0] &&
+           memcmp(ref->ram_buffer + 1, cur->ram_buffer + 1, SSD1306_PAGES * SSD1306_WIDTH) == 0;
+}
+
+static bool display_matches(const ssd1306_t *ssd) {
+    return memcmp(gddram, ssd->ram_buffer + 1, sizeof(gddram)) == 0;
+}
+
+/**
+ * @brief Mede pixels/µs de uma primitiva nas duas versões
+ */
+static void bench(const char *name, void (*draw)(const renderer_t *r, ssd1306_t *ssd), uint32_t pixels,
+                  ssd1306_t *ref, ssd1306_t *cur) {
+    double rate[2];
+    for (int v = 0; v < 2; v++) {
+        uint64_t start = test_now_us();
+        for (int i = 0; i < BENCH_ROUNDS; i++)
+            draw(v ? &CURRENT : &ORIGINAL, v ? cur : ref);
+        uint64_t us = test_now_us() - start;
+        rate[v] = us ? (double)pixels * BENCH_ROUNDS / us : 0.0;
+    }
+    printf("%-8s original %7.1f pixels/µs, atual %7.1f pixels/µs (%.1fx)\n", name, rate[0], rate[1],
+           rate[0] ? rate[1] / rate[0] : 0.0);
+    CHECK(frames_match(ref, cur));
+}
+
+static void bench_fill(const renderer_t *r, ssd1306_t *ssd) {
+    r->fill(ssd, ssd->ram_buffer[1] == 0); // Alterna: cada chamada muda todos os pixels
+}
+
+static void bench_rect(const renderer_t *r, ssd1306_t *ssd) {
+    r->rect(ssd, 11, 10, 100, 40, ssd->ram_buffer[1 + 10 * SSD1306_PAGES + 1] == 0, true);
+}
+
+static void bench_hline(const renderer_t *r, ssd1306_t *ssd) {
+    for (uint8_t y = 0; y < 64; y++)
+        r->hline(ssd, 4, 123, y, y & 1);
+}
+
+static void bench_vline(const renderer_t *r, ssd1306_t *ssd) {
+    for (uint8_t x = 0; x < 128; x++)
+        r->vline(ssd, x, 3, 60, x & 1);
+}
+
+static void bench_text(const renderer_t *r, ssd1306_t *ssd) {
+    r->draw_string(ssd, "T 25.31C H 60.2%", 0, 0); // 16 caracteres: a linha toda
+    r->draw_string(ssd, "P 912.4 A 800.1m", 0, 19);
+}
+
+int main(void) {
+    ssd1306_t cur;
+    ssd1306_init(&cur, SSD1306_WIDTH, SSD1306_HEIGHT, false, SSD1306_ADDR, i2c1);
+    ssd1306_config(&cur);
+    CHECK(vertical);
+    ssd1306_fill(&cur, false);
+    ssd1306_send_data(&cur);
+    CHECK(display_matches(&cur)); // A RAM inteira foi escrita (começa marcada como alterada)
+
+    ssd1306_t ref = cur;
+    ref.ram_buffer = calloc(ref.bufsize, 1);
+    ref.ram_buffer[0] = SSD1306_CTRL_DATA;
+
+    // Mesmo quadro nas duas versões; o envio parcial deixa o display igual ao buffer
+    static const struct {
+        const char *name;
+        void (*draw)(const renderer_t *r, ssd1306_t *ssd);
+    } scenes[] = {
+        {"fill", scene_fill}, {"rect", scene_rects}, {"line", scene_lines},
+        {"hline/vline", scene_hvlines}, {"texto", scene_text}, {"aleatória", scene_random},
+    };
+    for (size_t s = 0; s < count_of(scenes); s++) {
+        uint32_t seed = rng;
+        scenes[s].draw(&ORIGINAL, &ref);
+        rng = seed;
+        scenes[s].draw(&CURRENT, &cur);
+        if (!frames_match(&ref, &cur))
+            printf("cena %s: quadros diferentes\n", scenes[s].name);
+        CHECK(frames_match(&ref, &cur));
+        ssd1306_send_data(&cur);
+        CHECK(display_matches(&cur));
+    }
+
+    bench("fill", bench_fill, SSD1306_WIDTH * SSD1306_HEIGHT, &ref, &cur);
+    bench("rect", bench_rect, 100 * 40, &ref, &cur);
+    bench("hline", bench_hline, 120 * 64, &ref, &cur);
+    bench("vline", bench_vline, 58 * 128, &ref, &cur);
+    bench("texto", bench_text, 32 * 64, &ref, &cur);
+
+    // Bytes no barramento por atualização de tela: o original sempre manda o quadro inteiro
+    static const struct {
+        const char *name, *string1, *string2;
+    } updates[] = {
+        {"boot", "Estabelecendo", "Conexao"},
+        {"conectado", "Conectado", "192.168.0.10"},
+        {"leitura", "T 25.31C", "192.168.0.10"},
+        {"valor", "T 25.32C", "192.168.0.10"},
+        {"igual", "T 25.32C", "192.168.0.10"},
+    };
+    uint64_t total[2] = {0, 0};
+    for (size_t u = 0; u < count_of(updates); u++) {
+        uint64_t bytes[2];
+        for (int v = 0; v < 2; v++) {
+            uint64_t before = wire_bytes;
+            uint32_t counted = metrics_read(&metrics.display_bytes);
+            status_screen(v ? &CURRENT : &ORIGINAL, v ? &cur : &ref, updates[u].string1, updates[u].string2);
+            bytes[v] = wire_bytes - before;
+            if (v)
+                CHECK_EQ(metrics_read(&metrics.display_bytes) - counted, bytes[v]); // O /metrics conta o mesmo
+            total[v] += bytes[v];
+            CHECK(display_matches(v ? &cur : &ref));
+        }
+        printf("%-10s original %5llu bytes, atual %5llu bytes\n", updates[u].name, (unsigned long long)bytes[0],
+               (unsigned long long)bytes[1]);
+        CHECK_EQ(bytes[0], 6 * 3 + SSD1306_PAGES * SSD1306_WIDTH + 2); // 6 comandos de 3 bytes + quadro
+        CHECK(bytes[1] < bytes[0]);
+        if (!strcmp(updates[u].name, "valor"))
+            CHECK(bytes[1] < 100); // Só os caracteres que mudaram
+        if (!strcmp(updates[u].name, "igual"))
+            CHECK_EQ(bytes[1], 0);
+    }
+    // Display reiniciado: a região marcada à força vai inteira, mesmo igual ao último envio
+    memset(gddram, 0xA5, sizeof(gddram));
+    ssd1306_mark_dirty(&cur, 0, SSD1306_WIDTH - 1, 0, SSD1306_PAGES - 1);
+    ssd1306_send_data(&cur);
+    CHECK(display_matches(&cur));
+
+    printf("total: original %llu bytes, atual %llu bytes\n", (unsigned long long)total[0],
+           (unsigned long long)total[1]);
+    return test_result();
+}
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Teste de carga do servidor HTTP do Pico W.
+
+Abre várias conexões simultâneas com respostas em streaming (mais que
+HTTP_STREAM_MAX e HTTP_CONN_MAX) e confere o comportamento esperado sob carga:
+cada resposta deve ser 200 com o corpo chunked completo (até o trecho final
+"0\\r\\n\\r\\n"), 503 com Retry-After ou RST (pool cheio e segmentos TCP na
+reserva do MQTT). Qualquer outra coisa (404, corpo truncado, conexão fechada
+sem resposta) conta como falha.
+
+Uso:
+    python3 tools/http_stress.py 192.168.0.50 --conns 8 --rounds 5
+"""
+
+import argparse
+import socket
+import sys
+import threading
+import time
+from collections import Counter
+
+DEFAULT_PATHS = ["/metrics", "/api/v1/history?from=-300000&points=200", "/api/v1/logs"]
+
+
+def read_response(sock):
+    """Lê a resposta inteira (o servidor sempre fecha a conexão ao terminar)."""
+    data = bytearray()
+    while True:
+        part = sock.recv(4096)
+        if not part:
+            return bytes(data)
+        data += part
+
+
+def decode_chunked(body):
+    """Decodifica um corpo chunked; retorna (dados, completo)."""
+    out = bytearray()
+    pos = 0
+    while True:
+        eol = body.find(b"\r\n", pos)
+        if eol < 0:
+            return bytes(out), False
+        try:
+            size = int(body[pos:eol], 16)
+        except ValueError:
+            return bytes(out), False
+        pos = eol + 2
+        if size == 0:
+            return bytes(out), body[pos:pos + 2] == b"\r\n"
+        if len(body) < pos + size + 2 or body[pos + size:pos + size + 2] != b"\r\n":
+            return bytes(out), False
+        out += body[pos:pos + size]
+        pos += size + 2
+
+
+def classify(raw):
+    """Classifica uma resposta em um resultado do relatório."""
+    head, sep, body = raw.partition(b"\r\n\r\n")
+    if not sep:
+        return "no_response" if not raw else "bad_header"
+    lines = head.decode("latin-1").split("\r\n")
+    parts = lines[0].split(" ", 2)
+    status = int(parts[1]) if len(parts) > 1 and parts[1].isdigit() else 0
+    headers = {k.strip().lower(): v.strip() for k, _, v in (line.partition(":") for line in lines[1:])}
+    if status == 200 and headers.get("transfer-encoding") == "chunked":
+        _, complete = decode_chunked(body)
+        return "ok" if complete else "truncated"
+    if status == 200:
+        return "ok"
+    if status == 503:
+        return "busy" if "retry-after" in headers else "busy_no_retry_after"
+    return "status_%d" % status
+
+
+def request(host, port, path, timeout, results, latencies, lock):
+    start = time.monotonic()
+    try:
+        with socket.create_connection((host, port), timeout=timeout) as sock:
+            sock.sendall(("GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n" % (path, host)).encode())
+            result = classify(read_response(sock))
+    except ConnectionResetError:
+        result = "reset"
+    except OSError:
+        result = "timeout"
+    with lock:
+        results[result] += 1
+        if result == "ok":
+            latencies.append(time.monotonic() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--conns", type=int, default=8, help="conexões simultâneas por rodada")
+    parser.add_argument("--rounds", type=int, default=5)
+    parser.add_argument("--timeout", type=float, default=15.0)
+    parser.add_argument("--path", action="append", help="caminhos usados em rodízio (padrão: rotas em streaming)")
+    args = parser.parse_args()
+    paths = args.path or DEFAULT_PATHS
+
+    results = Counter()
+    latencies = []
+    lock = threading.Lock()
+    for _ in range(args.rounds):
+        threads = [threading.Thread(target=request,
+                                    args=(args.host, args.port, paths[i % len(paths)], args.timeout,
+                                          results, latencies, lock))
+                   for i in range(args.conns)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+    total = sum(results.values())
+    for result, count in sorted(results.items()):
+        print("%-22s %5d  (%.1f%%)" % (result, count, 100.0 * count / total))
+    if latencies:
+        latencies.sort()
+        print("latência ok: p50 %.3f s, p95 %.3f s, máx %.3f s" % (
+            latencies[len(latencies) // 2], latencies[int(len(latencies) * 0.95)], latencies[-1]))
+    # Sob carga só são aceitas respostas completas, 503 com Retry-After e RST (pool cheio e sem memória)
+    failures = total - results["ok"] - results["busy"] - results["reset"]
+    return 1 if failures or not results["ok"] else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())